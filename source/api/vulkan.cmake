@@ -9,21 +9,27 @@ set(VULKAN_SOURCE_FILES
         vulkan/wrapper/instance.cpp
 )
 set(VULKAN_HEADER_FILES
+        vulkan/wrapper/allocator.hpp
         vulkan/wrapper/buffer.hpp
         vulkan/wrapper/command.hpp
         vulkan/wrapper/descriptor.hpp
         vulkan/wrapper/device.hpp
+        vulkan/wrapper/event.hpp
         vulkan/wrapper/fence.hpp
         vulkan/wrapper/instance.hpp
         vulkan/wrapper/image.hpp
         vulkan/wrapper/image_view.hpp
+        vulkan/wrapper/memory.hpp
         vulkan/wrapper/physical_device.hpp
+        vulkan/wrapper/query_pool.hpp
         vulkan/wrapper/queue.hpp
         vulkan/wrapper/sampler.hpp
         vulkan/wrapper/semaphore.hpp
         vulkan/wrapper/shader.hpp
+        vulkan/wrapper/staging_queue.hpp
         vulkan/wrapper/surface.hpp
         vulkan/wrapper/swap_chain.hpp
+        vulkan/wrapper/upload_ring.hpp
         vulkan/deer_vulkan_core.hpp
 )
 list(TRANSFORM VULKAN_SOURCE_FILES PREPEND "${CMAKE_CURRENT_SOURCE_DIR}/source/api/")
@@ -255,5 +255,5 @@ enum class vk_check_severity : std::uint8_t
     error,
 };
 
-inline constexpr std::uint8_t maxFramesInFlight{2U};
+inline constexpr std::uint8_t maxFramesInFlight{3U}; // slots; how many of them a renderer actually keeps queued is up to its latency limit
 } // namespace deer_vulkan
@@ -0,0 +1,496 @@
+#pragma once
+#include "../deer_vulkan_core.hpp"
+#include "device.hpp"
+#include "dispatch.hpp"
+#include "physical_device.hpp"
+
+namespace deer_vulkan
+{
+// Buffers and images are sub-allocated from large blocks of device memory, one set of blocks per memory type. Each block keeps a TLSF free list,
+// so finding and releasing a range both take constant time. Resources the driver wants on their own, or that are big compared to a block, get a
+// dedicated allocation instead.
+constexpr std::uint64_t g_allocationGranule{256U};  // every offset and size within a block is a multiple of it
+constexpr std::uint64_t g_blockSize{64ULL << 20U};  // heaps of 1 GiB or less use an eighth of the heap instead
+constexpr std::uint32_t g_secondLevelBits{4U};      // size classes per power of two, as a shift
+constexpr std::uint32_t g_secondLevelCount{1U << g_secondLevelBits};
+constexpr std::uint32_t g_firstLevelCount{64U};
+constexpr std::uint32_t g_noNode{~0U};
+constexpr std::uint32_t g_dedicatedBlock{~0U};
+
+// A range of a block, free or in use. Neighbours in memory are linked, and so are the free ranges of one size class.
+struct AllocatorNode
+{
+    std::uint64_t offset{};
+    std::uint64_t size{};
+    std::uint32_t prevPhysical{g_noNode};
+    std::uint32_t nextPhysical{g_noNode};
+    std::uint32_t prevFree{g_noNode};
+    std::uint32_t nextFree{g_noNode};
+    bool isFree{};
+};
+
+struct AllocatorBlock
+{
+    vk::DeviceMemory memory{nullptr}; // nullptr once released; the slot is reused by the next block
+    std::byte* pMapped{nullptr};      // the whole block, mapped for as long as it lives when its memory is host visible
+    std::uint64_t size{};
+    std::uint64_t used{};
+    std::uint64_t flushAlignment{};
+    std::uint32_t memoryType{};
+    bool isLinear{}; // holds only buffers and linear images, or only optimal images, once bufferImageGranularity is bigger than a granule
+    std::vector<AllocatorNode> nodes{};
+    std::vector<std::uint32_t> unusedNodes{};
+    std::uint64_t firstLevelMap{};                                                // bit per first level with a free range
+    std::array<std::uint32_t, g_firstLevelCount> secondLevelMaps{};               // bit per size class with a free range
+    std::array<std::uint32_t, g_firstLevelCount * g_secondLevelCount> freeHeads{}; // first free range of each size class
+};
+
+// Resources take their memory from it through Allocate and give it back through Free. Safe to use from several threads.
+struct Allocator
+{
+    std::mutex mutex{};
+    std::vector<AllocatorBlock> blocks{};
+    const PhysicalDevice* pPhysicalDevice{nullptr};
+    std::uint64_t bufferImageGranularity{1U};
+    std::uint64_t nonCoherentAtomSize{1U};
+    std::uint32_t allocationCount{}; // device memory objects it holds, blocks and dedicated allocations both
+    std::uint32_t maxAllocationCount{};
+};
+
+struct AllocationRequest
+{
+    std::uint64_t size{};
+    std::uint64_t alignment{};
+    std::uint32_t memoryTypeBits{};
+    std::uint32_t memoryProperty{}; // raw VkMemoryPropertyFlags the memory must have
+    memory_usage memoryUsage{};     // picks among the types that have them
+    bool isLinear{};                // a buffer or a linear image
+    bool isDedicated{};
+    vk::Buffer dedicatedBuffer{nullptr}; // the resource a dedicated allocation is made for, at most one of them
+    vk::Image dedicatedImage{nullptr};
+};
+
+// What a resource holds instead of its own vk::DeviceMemory. A default one owns nothing.
+struct Allocation
+{
+    vk::DeviceMemory memory{nullptr};
+    std::byte* pMapped{nullptr}; // at offset; set for as long as the allocation lives when its memory is host visible
+    std::uint64_t offset{};
+    std::uint64_t size{};
+    std::uint64_t flushAlignment{}; // nonCoherentAtomSize when writes through pMapped have to be flushed, otherwise 0
+    std::uint32_t block{g_dedicatedBlock};
+    std::uint32_t node{g_noNode};
+};
+
+[[nodiscard]] constexpr auto AlignUp(const std::uint64_t value, const std::uint64_t alignment) noexcept -> std::uint64_t
+{
+    return (value + alignment - 1U) / alignment * alignment;
+}
+
+// TLSF size class of a size in granules: the power of two it falls in, then which of g_secondLevelCount slices of it.
+[[nodiscard]] constexpr auto SizeClass(const std::uint64_t units) noexcept -> std::pair<std::uint32_t, std::uint32_t>
+{
+    if (units < g_secondLevelCount)
+    {
+        return {0U, static_cast<std::uint32_t>(units)};
+    }
+    const auto topBit{static_cast<std::uint32_t>(std::bit_width(units)) - 1U};
+    return {topBit - g_secondLevelBits + 1U, static_cast<std::uint32_t>(units >> (topBit - g_secondLevelBits)) - g_secondLevelCount};
+}
+
+inline auto InsertFree(AllocatorBlock& block, const std::uint32_t index) noexcept -> void
+{
+    AllocatorNode& node{block.nodes[index]};
+    const auto [firstLevel, secondLevel]{SizeClass(node.size / g_allocationGranule)};
+    std::uint32_t& head{block.freeHeads[firstLevel * g_secondLevelCount + secondLevel]};
+    node.isFree   = true;
+    node.prevFree = g_noNode;
+    node.nextFree = head;
+    if (head != g_noNode)
+    {
+        block.nodes[head].prevFree = index;
+    }
+    head = index;
+    block.firstLevelMap |= 1ULL << firstLevel;
+    block.secondLevelMaps[firstLevel] |= 1U << secondLevel;
+}
+
+inline auto RemoveFree(AllocatorBlock& block, const std::uint32_t index) noexcept -> void
+{
+    AllocatorNode& node{block.nodes[index]};
+    const auto [firstLevel, secondLevel]{SizeClass(node.size / g_allocationGranule)};
+    std::uint32_t& head{block.freeHeads[firstLevel * g_secondLevelCount + secondLevel]};
+    if (node.prevFree != g_noNode)
+    {
+        block.nodes[node.prevFree].nextFree = node.nextFree;
+    }
+    else
+    {
+        head = node.nextFree;
+    }
+    if (node.nextFree != g_noNode)
+    {
+        block.nodes[node.nextFree].prevFree = node.prevFree;
+    }
+    node.isFree = false;
+    if (head == g_noNode)
+    {
+        block.secondLevelMaps[firstLevel] &= ~(1U << secondLevel);
+        if (block.secondLevelMaps[firstLevel] == 0U)
+        {
+            block.firstLevelMap &= ~(1ULL << firstLevel);
+        }
+    }
+}
+
+// A free range of at least units granules, or g_noNode. Looks in the first size class whose every range is big enough, so it never walks a list.
+[[nodiscard]] inline auto FindFree(const AllocatorBlock& block, const std::uint64_t units) noexcept -> std::uint32_t
+{
+    const std::uint64_t rounded{units < g_secondLevelCount ? units : units + (1ULL << (std::bit_width(units) - 1U - g_secondLevelBits)) - 1U};
+    auto [firstLevel, secondLevel]{SizeClass(rounded)};
+    if (firstLevel >= g_firstLevelCount)
+    {
+        return g_noNode;
+    }
+    std::uint32_t secondLevelMap{block.secondLevelMaps[firstLevel] & (~0U << secondLevel)};
+    if (secondLevelMap == 0U)
+    {
+        const std::uint64_t firstLevelMap{firstLevel + 1U < g_firstLevelCount ? block.firstLevelMap & (~0ULL << (firstLevel + 1U)) : 0U};
+        if (firstLevelMap == 0U)
+        {
+            return g_noNode;
+        }
+        firstLevel     = static_cast<std::uint32_t>(std::countr_zero(firstLevelMap));
+        secondLevelMap = block.secondLevelMaps[firstLevel];
+    }
+    secondLevel = static_cast<std::uint32_t>(std::countr_zero(secondLevelMap));
+    return block.freeHeads[firstLevel * g_secondLevelCount + secondLevel];
+}
+
+[[nodiscard]] inline auto NewNode(AllocatorBlock& block) noexcept -> std::uint32_t
+{
+    if (!block.unusedNodes.empty())
+    {
+        const std::uint32_t index{block.unusedNodes.back()};
+        block.unusedNodes.pop_back();
+        block.nodes[index] = {};
+        return index;
+    }
+    block.nodes.emplace_back();
+    return static_cast<std::uint32_t>(block.nodes.size() - 1U);
+}
+
+// Cuts a range in two after size bytes and returns the second half, which is in use until it is inserted as free.
+[[nodiscard]] inline auto Split(AllocatorBlock& block, const std::uint32_t index, const std::uint64_t size) noexcept -> std::uint32_t
+{
+    const std::uint32_t rest{NewNode(block)};
+    AllocatorNode& node{block.nodes[index]};
+    block.nodes[rest] = {
+        .offset       = node.offset + size,
+        .size         = node.size - size,
+        .prevPhysical = index,
+        .nextPhysical = node.nextPhysical,
+    };
+    if (node.nextPhysical != g_noNode)
+    {
+        block.nodes[node.nextPhysical].prevPhysical = rest;
+    }
+    node.nextPhysical = rest;
+    node.size         = size;
+    return rest;
+}
+
+// Folds the range after index into it.
+inline auto Merge(AllocatorBlock& block, const std::uint32_t index) noexcept -> void
+{
+    AllocatorNode& node{block.nodes[index]};
+    const std::uint32_t next{node.nextPhysical};
+    const AllocatorNode& absorbed{block.nodes[next]};
+    node.size += absorbed.size;
+    node.nextPhysical = absorbed.nextPhysical;
+    if (absorbed.nextPhysical != g_noNode)
+    {
+        block.nodes[absorbed.nextPhysical].prevPhysical = index;
+    }
+    block.unusedNodes.emplace_back(next);
+}
+
+inline auto InitializeBlock(AllocatorBlock& block, const vk::DeviceMemory memory, std::byte* pMapped, const std::uint64_t size, const std::uint64_t flushAlignment,
+                            const std::uint32_t memoryType, const bool isLinear) noexcept -> void
+{
+    block = {.memory = memory, .pMapped = pMapped, .size = size, .flushAlignment = flushAlignment, .memoryType = memoryType, .isLinear = isLinear};
+    block.freeHeads.fill(g_noNode);
+    block.nodes.emplace_back(AllocatorNode{.offset = 0U, .size = size});
+    InsertFree(block, 0U);
+}
+
+// Takes an aligned range of size bytes from the block, if it has one.
+[[nodiscard]] inline auto AllocateFromBlock(AllocatorBlock& block, const std::uint64_t size, const std::uint64_t alignment, Allocation& allocation) noexcept -> bool
+{
+    const std::uint64_t rangeSize{AlignUp(size, g_allocationGranule)};
+    const std::uint64_t padding{alignment > g_allocationGranule ? alignment - g_allocationGranule : 0U};
+    std::uint32_t index{FindFree(block, (rangeSize + padding) / g_allocationGranule)};
+    if (index == g_noNode)
+    {
+        return false;
+    }
+    RemoveFree(block, index);
+
+    // Whatever alignment skips stays free as a range of its own.
+    if (const std::uint64_t skipped{AlignUp(block.nodes[index].offset, alignment) - block.nodes[index].offset}; skipped != 0U)
+    {
+        const std::uint32_t aligned{Split(block, index, skipped)};
+        InsertFree(block, index);
+        index = aligned;
+    }
+    if (block.nodes[index].size > rangeSize)
+    {
+        InsertFree(block, Split(block, index, rangeSize));
+    }
+
+    block.used += rangeSize;
+    allocation = {
+        .memory         = block.memory,
+        .pMapped        = block.pMapped != nullptr ? block.pMapped + block.nodes[index].offset : nullptr,
+        .offset         = block.nodes[index].offset,
+        .size           = size,
+        .flushAlignment = block.flushAlignment,
+        .node           = index,
+    };
+    return true;
+}
+
+inline auto FreeFromBlock(AllocatorBlock& block, std::uint32_t index) noexcept -> void
+{
+    block.used -= block.nodes[index].size;
+    if (const std::uint32_t next{block.nodes[index].nextPhysical}; next != g_noNode && block.nodes[next].isFree)
+    {
+        RemoveFree(block, next);
+        Merge(block, index);
+    }
+    if (const std::uint32_t prev{block.nodes[index].prevPhysical}; prev != g_noNode && block.nodes[prev].isFree)
+    {
+        RemoveFree(block, prev);
+        Merge(block, prev);
+        index = prev;
+    }
+    InsertFree(block, index);
+}
+
+inline auto Initialize(const PhysicalDevice& physicalDevice, Allocator& allocator) noexcept -> void
+{
+    const vk::PhysicalDeviceLimits& limits{physicalDevice.deviceProperties.properties.limits};
+    allocator.pPhysicalDevice        = &physicalDevice;
+    allocator.bufferImageGranularity = limits.bufferImageGranularity;
+    allocator.nonCoherentAtomSize    = limits.nonCoherentAtomSize;
+    allocator.maxAllocationCount     = limits.maxMemoryAllocationCount;
+    allocator.allocationCount        = 0U;
+}
+
+[[nodiscard]] inline auto BlockSize(const Allocator& allocator, const std::uint32_t memoryType) noexcept -> std::uint64_t
+{
+    const vk::PhysicalDeviceMemoryProperties& properties{allocator.pPhysicalDevice->deviceMemoryProperties.memoryProperties};
+    const std::uint64_t heapSize{properties.memoryHeaps[properties.memoryTypes[memoryType].heapIndex].size};
+    return heapSize <= (1ULL << 30U) ? AlignUp(heapSize / 8U, g_allocationGranule) : g_blockSize;
+}
+
+// How writes to mapped memory of the type have to be flushed: 0 for memory that is not host visible or is coherent, otherwise nonCoherentAtomSize.
+[[nodiscard]] inline auto FlushAlignment(const Allocator& allocator, const std::uint32_t memoryType) noexcept -> std::uint64_t
+{
+    const vk::MemoryPropertyFlags flags{allocator.pPhysicalDevice->deviceMemoryProperties.memoryProperties.memoryTypes[memoryType].propertyFlags};
+    return (flags & vk::MemoryPropertyFlagBits::eHostVisible) && !(flags & vk::MemoryPropertyFlagBits::eHostCoherent) ? allocator.nonCoherentAtomSize : 0U;
+}
+
+// Host visible memory is mapped right away and stays mapped until it is freed, so nothing maps or unmaps memory while a frame is recorded.
+[[nodiscard]] inline auto AllocateMemory(const Dispatch& dispatch, const Device& device, Allocator& allocator, const std::uint64_t size, const std::uint32_t memoryType,
+                                         const void* pNext, vk::DeviceMemory& memory, std::byte*& pMapped) noexcept -> vk_status
+{
+    if (allocator.allocationCount >= allocator.maxAllocationCount) [[unlikely]]
+    {
+        return vk_status::too_many_objects;
+    }
+    const vk::MemoryAllocateInfo allocInfo{
+        .sType           = vk::StructureType::eMemoryAllocateInfo,
+        .pNext           = pNext,
+        .allocationSize  = size,
+        .memoryTypeIndex = memoryType,
+    };
+    if (const vk_status status{FromVkResult(device.device.allocateMemory(&allocInfo, nullptr, &memory, dispatch.dispatch))}; IsError(status)) [[unlikely]]
+    {
+        return status;
+    }
+
+    void* pData{nullptr};
+    if (const vk::MemoryPropertyFlags flags{allocator.pPhysicalDevice->deviceMemoryProperties.memoryProperties.memoryTypes[memoryType].propertyFlags};
+        flags & vk::MemoryPropertyFlagBits::eHostVisible)
+    {
+        if (const vk_status status{FromVkResult(device.device.mapMemory(memory, 0U, vk::WholeSize, {}, &pData, dispatch.dispatch))}; IsError(status)) [[unlikely]]
+        {
+            device.device.freeMemory(memory, nullptr, dispatch.dispatch);
+            return status;
+        }
+    }
+    pMapped = static_cast<std::byte*>(pData);
+    ++allocator.allocationCount;
+    return vk_status::ok;
+}
+
+[[nodiscard]] inline auto AllocateDedicated(const Dispatch& dispatch, const Device& device, Allocator& allocator, const AllocationRequest& request, const std::uint32_t memoryType,
+                                            Allocation& allocation) noexcept -> vk_status
+{
+    const vk::MemoryDedicatedAllocateInfo dedicatedInfo{
+        .sType  = vk::StructureType::eMemoryDedicatedAllocateInfo,
+        .pNext  = nullptr,
+        .image  = request.dedicatedImage,
+        .buffer = request.dedicatedBuffer,
+    };
+    const bool hasResource{request.dedicatedImage != nullptr || request.dedicatedBuffer != nullptr};
+    vk::DeviceMemory memory{nullptr};
+    std::byte* pMapped{nullptr};
+    if (const vk_status status{AllocateMemory(dispatch, device, allocator, request.size, memoryType, hasResource ? &dedicatedInfo : nullptr, memory, pMapped)};
+        IsError(status))
+    {
+        return status;
+    }
+    allocation = {.memory = memory, .pMapped = pMapped, .offset = 0U, .size = request.size, .flushAlignment = FlushAlignment(allocator, memoryType)};
+    return vk_status::ok;
+}
+
+// Finds room in an existing block of the memory type, adds a block when none has any, and falls back to a dedicated allocation when the
+// request is big or a new block does not fit in the heap any more.
+[[nodiscard]] inline auto AllocateOfType(const Dispatch& dispatch, const Device& device, Allocator& allocator, const AllocationRequest& request, const std::uint32_t memoryType,
+                                         Allocation& allocation) noexcept -> vk_status
+{
+    const std::uint64_t blockSize{BlockSize(allocator, memoryType)};
+    const std::uint64_t alignment{std::max(request.alignment, std::uint64_t{1U})};
+    const bool isLinear{allocator.bufferImageGranularity > g_allocationGranule && request.isLinear};
+
+    std::lock_guard lock{allocator.mutex};
+    if (request.isDedicated || request.size > blockSize / 2U)
+    {
+        return AllocateDedicated(dispatch, device, allocator, request, memoryType, allocation);
+    }
+    for (std::uint32_t i{}; i < allocator.blocks.size(); ++i)
+    {
+        AllocatorBlock& block{allocator.blocks[i]};
+        if (block.memory != nullptr && block.memoryType == memoryType && block.isLinear == isLinear && AllocateFromBlock(block, request.size, alignment, allocation))
+        {
+            allocation.block = i;
+            return vk_status::ok;
+        }
+    }
+
+    vk::DeviceMemory memory{nullptr};
+    std::byte* pMapped{nullptr};
+    if (IsError(AllocateMemory(dispatch, device, allocator, blockSize, memoryType, nullptr, memory, pMapped)))
+    {
+        return AllocateDedicated(dispatch, device, allocator, request, memoryType, allocation);
+    }
+
+    const auto slot{std::ranges::find_if(allocator.blocks,
+                                         [](const AllocatorBlock& unused) noexcept
+                                         {
+                                             return unused.memory == nullptr;
+                                         })};
+    const auto index{static_cast<std::uint32_t>(slot - allocator.blocks.begin())};
+    AllocatorBlock& block{slot != allocator.blocks.end() ? *slot : allocator.blocks.emplace_back()};
+    InitializeBlock(block, memory, pMapped, blockSize, FlushAlignment(allocator, memoryType), memoryType, isLinear);
+    if (!AllocateFromBlock(block, request.size, alignment, allocation)) [[unlikely]]
+    {
+        return vk_status::out_of_device_memory;
+    }
+    allocation.block = index;
+    return vk_status::ok;
+}
+
+// Takes the memory type that suits the request's usage best. When its heap is full, as a resizable BAR heap fills up long before video memory does,
+// the next best type takes over.
+[[nodiscard]] inline auto Allocate(const Dispatch& dispatch, const Device& device, Allocator& allocator, const AllocationRequest& request, Allocation& allocation) noexcept
+    -> vk_status
+{
+    std::uint32_t memoryTypeBits{request.memoryTypeBits};
+    while (true)
+    {
+        const std::uint32_t memoryType{FindMemoryType(*allocator.pPhysicalDevice, memoryTypeBits, request.memoryProperty, request.memoryUsage)};
+        if (memoryType == g_noMemoryType) [[unlikely]]
+        {
+            return vk_status::out_of_device_memory;
+        }
+        if (const vk_status status{AllocateOfType(dispatch, device, allocator, request, memoryType, allocation)}; status != vk_status::out_of_device_memory)
+        {
+            return status;
+        }
+        memoryTypeBits &= ~(1U << memoryType);
+    }
+}
+
+// Gives the range back. A block that ends up empty is released, unless it is the last one of its memory type.
+inline auto Free(const Dispatch& dispatch, const Device& device, Allocator& allocator, Allocation& allocation) noexcept -> void
+{
+    if (allocation.memory == nullptr)
+    {
+        return;
+    }
+
+    std::lock_guard lock{allocator.mutex};
+    if (allocation.block == g_dedicatedBlock)
+    {
+        device.device.freeMemory(allocation.memory, nullptr, dispatch.dispatch);
+        --allocator.allocationCount;
+        allocation = {};
+        return;
+    }
+
+    AllocatorBlock& block{allocator.blocks[allocation.block]};
+    FreeFromBlock(block, allocation.node);
+    allocation = {};
+    if (block.used != 0U)
+    {
+        return;
+    }
+    const auto isSibling = [&block](const AllocatorBlock& other) noexcept
+    {
+        return &other != &block && other.memory != nullptr && other.memoryType == block.memoryType;
+    };
+    if (std::ranges::any_of(allocator.blocks, isSibling))
+    {
+        device.device.freeMemory(block.memory, nullptr, dispatch.dispatch);
+        --allocator.allocationCount;
+        block = {};
+    }
+}
+
+// Makes writes through pMapped to [offset, offset + size) of the allocation visible to the device. Nothing to do for coherent memory.
+inline auto Flush(const Dispatch& dispatch, const Device& device, const Allocation& allocation, const std::uint64_t offset, const std::uint64_t size) noexcept -> void
+{
+    if (allocation.flushAlignment == 0U || size == 0U)
+    {
+        return;
+    }
+    // The range has to start and end on an atom. Blocks are a whole number of atoms, so only a dedicated allocation can end between two.
+    const std::uint64_t begin{(allocation.offset + offset) / allocation.flushAlignment * allocation.flushAlignment};
+    const std::uint64_t end{AlignUp(allocation.offset + offset + size, allocation.flushAlignment)};
+    const vk::MappedMemoryRange mappedRange{
+        .sType  = vk::StructureType::eMappedMemoryRange,
+        .pNext  = nullptr,
+        .memory = allocation.memory,
+        .offset = begin,
+        .size   = allocation.block == g_dedicatedBlock && end >= allocation.size ? vk::WholeSize : end - begin,
+    };
+    static_cast<void>(device.device.flushMappedMemoryRanges(1U, &mappedRange, dispatch.dispatch));
+}
+
+// Releases every block. Whatever was allocated from the allocator has to be freed or destroyed already.
+inline auto Cleanup(const Dispatch& dispatch, const Device& device, Allocator& allocator) noexcept -> void
+{
+    for (const AllocatorBlock& block : allocator.blocks)
+    {
+        if (block.memory != nullptr)
+        {
+            device.device.freeMemory(block.memory, nullptr, dispatch.dispatch);
+        }
+    }
+    allocator.blocks.clear();
+    allocator.allocationCount = 0U;
+}
+} // namespace deer_vulkan
@@ -1,8 +1,8 @@
 #pragma once
 #include "../deer_vulkan_core.hpp"
+#include "allocator.hpp"
 #include "device.hpp"
 #include "dispatch.hpp"
-#include "physical_device.hpp"
 
 namespace deer_vulkan
 {
@@ -11,16 +11,18 @@ struct BufferCreateInfo
     std::uint64_t size{};
     std::uint32_t usage{};
     std::uint32_t memoryProperty{};
+    memory_usage memoryUsage{};
 };
 
 struct Buffer
 {
     vk::Buffer buffer{nullptr};
-    vk::DeviceMemory memory{};
+    Allocation allocation{};
+    std::uint64_t size{};
 };
 
-[[nodiscard]] inline auto Initialize(const Dispatch& dispatch, const Device& device, const PhysicalDevice& physicalDevice, const BufferCreateInfo& createInfo,
-                                     Buffer& buffer) noexcept -> vk_status
+[[nodiscard]] inline auto Initialize(const Dispatch& dispatch, const Device& device, Allocator& allocator, const BufferCreateInfo& createInfo, Buffer& buffer) noexcept
+    -> vk_status
 {
     const vk::DeviceSize size{createInfo.size};
     const vk::BufferUsageFlags usage{static_cast<vk::BufferUsageFlagBits>(createInfo.usage)};
@@ -36,46 +38,88 @@ struct Buffer
     };
 
     buffer.buffer = device.device.createBuffer(bufferCI, nullptr, dispatch.dispatch);
+    buffer.size   = size;
 
-    const vk::MemoryRequirements memoryRequirements{device.device.getBufferMemoryRequirements(buffer.buffer, dispatch.dispatch)};
-    const vk::MemoryAllocateInfo allocInfo{
-        .sType           = vk::StructureType::eMemoryAllocateInfo,
-        .pNext           = nullptr,
-        .allocationSize  = memoryRequirements.size,
-        .memoryTypeIndex = FindMemoryType(physicalDevice, memoryRequirements.memoryTypeBits, createInfo.memoryProperty),
+    const vk::BufferMemoryRequirementsInfo2 requirementsInfo{
+        .sType  = vk::StructureType::eBufferMemoryRequirementsInfo2,
+        .pNext  = nullptr,
+        .buffer = buffer.buffer,
+    };
+    const auto requirements{device.device.getBufferMemoryRequirements2<vk::MemoryRequirements2, vk::MemoryDedicatedRequirements>(requirementsInfo, dispatch.dispatch)};
+    const vk::MemoryRequirements& memoryRequirements{requirements.get<vk::MemoryRequirements2>().memoryRequirements};
+    const vk::MemoryDedicatedRequirements& dedicated{requirements.get<vk::MemoryDedicatedRequirements>()};
+    const AllocationRequest request{
+        .size            = memoryRequirements.size,
+        .alignment       = memoryRequirements.alignment,
+        .memoryTypeBits  = memoryRequirements.memoryTypeBits,
+        .memoryProperty  = createInfo.memoryProperty,
+        .memoryUsage     = createInfo.memoryUsage,
+        .isLinear        = true,
+        .isDedicated     = dedicated.requiresDedicatedAllocation || dedicated.prefersDedicatedAllocation,
+        .dedicatedBuffer = buffer.buffer,
     };
-    buffer.memory = device.device.allocateMemory(allocInfo, nullptr, dispatch.dispatch);
+    if (const vk_status status{Allocate(dispatch, device, allocator, request, buffer.allocation)}; IsError(status)) [[unlikely]]
+    {
+        device.device.destroyBuffer(buffer.buffer, nullptr, dispatch.dispatch);
+        buffer.buffer = nullptr;
+        return status;
+    }
 
-    device.device.bindBufferMemory(buffer.buffer, buffer.memory, 0, dispatch.dispatch);
+    const vk::BindBufferMemoryInfo bindInfo{
+        .sType        = vk::StructureType::eBindBufferMemoryInfo,
+        .pNext        = nullptr,
+        .buffer       = buffer.buffer,
+        .memory       = buffer.allocation.memory,
+        .memoryOffset = buffer.allocation.offset,
+    };
+    if (const vk_status status{FromVkResult(device.device.bindBufferMemory2(1U, &bindInfo, dispatch.dispatch))}; IsError(status)) [[unlikely]]
+    {
+        device.device.destroyBuffer(buffer.buffer, nullptr, dispatch.dispatch);
+        Free(dispatch, device, allocator, buffer.allocation);
+        buffer.buffer = nullptr;
+        return status;
+    }
     return vk_status::ok;
 }
 
-inline auto Cleanup(const Dispatch& dispatch, const Device& device, Buffer& buffer) noexcept -> void
+inline auto Cleanup(const Dispatch& dispatch, const Device& device, Allocator& allocator, Buffer& buffer) noexcept -> void
 {
-    device.device.freeMemory(buffer.memory, nullptr, dispatch.dispatch);
     device.device.destroyBuffer(buffer.buffer, nullptr, dispatch.dispatch);
-    buffer.memory = nullptr;
+    Free(dispatch, device, allocator, buffer.allocation);
     buffer.buffer = nullptr;
+    buffer.size   = 0U;
 }
 
-template <typename T, auto Size = std::dynamic_extent>
-auto CopyData(const Dispatch& dispatch, const Device& device, const Buffer& buffer, const std::span<const T, Size> data, const std::uint32_t offset = 0) noexcept -> void
+// The buffer's memory as Ts, mapped for as long as the buffer lives. Empty unless the buffer is host visible.
+// Writes to memory that is not host coherent have to be flushed before the device reads them.
+template <typename T>
+[[nodiscard]] auto Mapped(const Buffer& buffer) noexcept -> std::span<T>
 {
-    void* pData = device.device.mapMemory(buffer.memory, offset, static_cast<vk::DeviceSize>(data.size_bytes()), {}, dispatch.dispatch);
-    memcpy(pData, std::bit_cast<const unsigned char*>(data.data()), data.size_bytes());
-    device.device.unmapMemory(buffer.memory, dispatch.dispatch);
+    if (buffer.allocation.pMapped == nullptr)
+    {
+        return {};
+    }
+    return {std::bit_cast<T*>(buffer.allocation.pMapped), static_cast<std::size_t>(buffer.size / sizeof(T))};
 }
 
-inline void Flush(const Dispatch& dispatch, const Device& device, const Buffer& buffer, const std::uint64_t size, const std::uint64_t offset) noexcept
+// Makes writes to [offset, offset + size) of a mapped buffer visible to the device. Nothing to do for coherent memory.
+inline void Flush(const Dispatch& dispatch, const Device& device, const Buffer& buffer, const std::uint64_t offset, const std::uint64_t size) noexcept
 {
-    const vk::MappedMemoryRange mappedRange{
-        .sType  = vk::StructureType::eMappedMemoryRange,
-        .pNext  = nullptr,
-        .memory = buffer.memory,
-        .offset = offset,
-        .size   = size,
-    };
+    Flush(dispatch, device, buffer.allocation, offset, size);
+}
 
-    device.device.flushMappedMemoryRanges({mappedRange}, dispatch.dispatch);
+// Writes through the persistent mapping, flushing only what was written and only when the memory is not coherent. memory_map_failed when the buffer
+// is not host visible.
+template <typename T, auto Size = std::dynamic_extent>
+[[nodiscard]] auto CopyData(const Dispatch& dispatch, const Device& device, const Buffer& buffer, const std::span<const T, Size> data, const std::uint32_t offset = 0) noexcept
+    -> vk_status
+{
+    if (buffer.allocation.pMapped == nullptr) [[unlikely]]
+    {
+        return vk_status::memory_map_failed;
+    }
+    memcpy(buffer.allocation.pMapped + offset, std::bit_cast<const unsigned char*>(data.data()), data.size_bytes());
+    Flush(dispatch, device, buffer.allocation, offset, data.size_bytes());
+    return vk_status::ok;
 }
 } // namespace deer_vulkan
@@ -28,23 +28,60 @@ struct CommandBuffer
     std::vector<vk::CommandBuffer> commandBuffer{};
 };
 
+// Load and store ops are raw VkAttachmentLoadOp/VkAttachmentStoreOp values; the clear values only matter for a clear load op.
 struct RenderParams
 {
     const ImageView* colorImageView{nullptr};
     const ImageView* depthImageView{nullptr};
-    std::array<float, 3> clearColor{0.0F, 0.0F, 0.0F};
+    std::array<float, 4> clearColor{0.0F, 0.0F, 0.0F, 1.0F};
     float depthClear{1.0F};
     std::int32_t xOffset{};
     std::int32_t yOffset{};
     std::uint32_t width{};
     std::uint32_t height{};
     std::uint32_t stencilClear{};
+    std::uint32_t colorLoadOp{static_cast<std::uint32_t>(vk::AttachmentLoadOp::eClear)};
+    std::uint32_t colorStoreOp{static_cast<std::uint32_t>(vk::AttachmentStoreOp::eStore)};
+    std::uint32_t depthLoadOp{static_cast<std::uint32_t>(vk::AttachmentLoadOp::eClear)};
+    std::uint32_t depthStoreOp{static_cast<std::uint32_t>(vk::AttachmentStoreOp::eStore)};
+    std::uint32_t colorLayout{static_cast<std::uint32_t>(vk::ImageLayout::eAttachmentOptimalKHR)};
+    std::uint32_t depthLayout{}; // undefined picks read only or attachment optimal from depthReadOnly
+    bool depthReadOnly{};
 };
 
 struct StageAccess
 {
-    vk::PipelineStageFlags stageMask{};
-    vk::AccessFlags accessMask{};
+    vk::PipelineStageFlags2 stageMask{};
+    vk::AccessFlags2 accessMask{};
+};
+
+// Stages and accesses are raw VkPipelineStageFlags2/VkAccessFlags2 bits, layouts raw VkImageLayout values.
+struct ImageBarrier
+{
+    Image* image{nullptr};
+    std::uint64_t srcStage{};
+    std::uint64_t srcAccess{};
+    std::uint64_t dstStage{};
+    std::uint64_t dstAccess{};
+    std::uint32_t oldLayout{};
+    std::uint32_t newLayout{};
+    std::uint32_t srcQueueFamily{vk::QueueFamilyIgnored}; // differing families make this one half of an ownership transfer
+    std::uint32_t dstQueueFamily{vk::QueueFamilyIgnored};
+    std::uint32_t mipOffset{0U}; // the whole image by default
+    std::uint32_t mipCount{vk::RemainingMipLevels};
+    std::uint32_t layerOffset{0U};
+    std::uint32_t layerCount{vk::RemainingArrayLayers};
+};
+
+struct BufferBarrier
+{
+    const Buffer* buffer{nullptr};
+    std::uint64_t srcStage{};
+    std::uint64_t srcAccess{};
+    std::uint64_t dstStage{};
+    std::uint64_t dstAccess{};
+    std::uint32_t srcQueueFamily{vk::QueueFamilyIgnored};
+    std::uint32_t dstQueueFamily{vk::QueueFamilyIgnored};
 };
 
 [[nodiscard]] constexpr auto IsDepthLayout(const vk::ImageLayout layout) noexcept -> bool
@@ -109,6 +146,12 @@ inline void Cleanup(const Dispatch& dispatch, const Device& device, const Comman
     commandBuffer.commandBuffer.clear();
 }
 
+// Recycles every command buffer allocated from the pool. The GPU must be done with all of them.
+inline void Reset(const Dispatch& dispatch, const Device& device, const CommandPool& commandPool) noexcept
+{
+    device.device.resetCommandPool(commandPool.commandPool, {}, dispatch.dispatch);
+}
+
 // ---------------------------------------------------------------------------
 // Recording — errors only, no per-frame spam
 // ---------------------------------------------------------------------------
@@ -141,19 +184,19 @@ inline void EndCommand(const Dispatch& dispatch, const CommandBuffer& commandBuf
 
 inline void BeginRender(const Dispatch& dispatch, const CommandBuffer& commandBuffer, const RenderParams& params) noexcept
 {
-    const vk::ClearValue colorClearValue{vk::ClearColorValue{params.clearColor[0], params.clearColor[1], params.clearColor[2], 1.0F}};
+    const vk::ClearValue colorClearValue{vk::ClearColorValue{params.clearColor[0], params.clearColor[1], params.clearColor[2], params.clearColor[3]}};
     const vk::ClearValue depthClearValue{vk::ClearDepthStencilValue{params.depthClear, params.stencilClear}};
 
     const vk::RenderingAttachmentInfo colorAttachment{
         .sType              = vk::StructureType::eRenderingAttachmentInfo,
         .pNext              = nullptr,
         .imageView          = params.colorImageView != nullptr ? params.colorImageView->imageView : nullptr,
-        .imageLayout        = vk::ImageLayout::eAttachmentOptimalKHR,
+        .imageLayout        = static_cast<vk::ImageLayout>(params.colorLayout),
         .resolveMode        = vk::ResolveModeFlagBits::eNone,
         .resolveImageView   = nullptr,
         .resolveImageLayout = vk::ImageLayout::eUndefined,
-        .loadOp             = vk::AttachmentLoadOp::eClear,
-        .storeOp            = vk::AttachmentStoreOp::eStore,
+        .loadOp             = static_cast<vk::AttachmentLoadOp>(params.colorLoadOp),
+        .storeOp            = static_cast<vk::AttachmentStoreOp>(params.colorStoreOp),
         .clearValue         = colorClearValue,
     };
 
@@ -161,12 +204,14 @@ inline void BeginRender(const Dispatch& dispatch, const CommandBuffer& commandBu
         .sType              = vk::StructureType::eRenderingAttachmentInfo,
         .pNext              = nullptr,
         .imageView          = params.depthImageView != nullptr ? params.depthImageView->imageView : nullptr,
-        .imageLayout        = vk::ImageLayout::eAttachmentOptimalKHR,
+        .imageLayout        = params.depthLayout != 0U ? static_cast<vk::ImageLayout>(params.depthLayout)
+                              : params.depthReadOnly  ? vk::ImageLayout::eReadOnlyOptimal
+                                                      : vk::ImageLayout::eAttachmentOptimalKHR,
         .resolveMode        = vk::ResolveModeFlagBits::eNone,
         .resolveImageView   = nullptr,
         .resolveImageLayout = vk::ImageLayout::eUndefined,
-        .loadOp             = vk::AttachmentLoadOp::eClear,
-        .storeOp            = vk::AttachmentStoreOp::eStore,
+        .loadOp             = static_cast<vk::AttachmentLoadOp>(params.depthLoadOp),
+        .storeOp            = static_cast<vk::AttachmentStoreOp>(params.depthStoreOp),
         .clearValue         = depthClearValue,
     };
 
@@ -381,25 +426,26 @@ inline void BindShader(const Dispatch& dispatch, const CommandBuffer& commandBuf
     commandBuffer.commandBuffer.front().bindShadersEXT(static_cast<std::uint32_t>(shader.stages.size()), shader.stages.data(), shader.shaders.data(), dispatch.dispatch);
 }
 
-inline void BindDescriptor(const Dispatch& dispatch, const CommandBuffer& commandBuffer, const Descriptor& descriptor) noexcept
+// dynamicOffsets has one entry per dynamic uniform or storage buffer in the set, in binding order.
+inline void BindDescriptor(const Dispatch& dispatch, const CommandBuffer& commandBuffer, const Descriptor& descriptor,
+                           const std::span<const std::uint32_t> dynamicOffsets = {}) noexcept
 {
-    commandBuffer.commandBuffer.front().bindDescriptorSets(vk::PipelineBindPoint::eGraphics, descriptor.pipelineLayout, 0U, {descriptor.descriptorSet}, {}, dispatch.dispatch);
+    commandBuffer.commandBuffer.front().bindDescriptorSets(vk::PipelineBindPoint::eGraphics, descriptor.pipelineLayout, 0U, 1U, &descriptor.descriptorSet,
+                                                           static_cast<std::uint32_t>(dynamicOffsets.size()), dynamicOffsets.data(), dispatch.dispatch);
 }
 
-inline void BindIndexBuffer(const Dispatch& dispatch, const CommandBuffer& commandBuffer, const Buffer& buffer) noexcept
+inline void BindIndexBuffer(const Dispatch& dispatch, const CommandBuffer& commandBuffer, const Buffer& buffer, const std::uint64_t offset = 0U) noexcept
 {
-    commandBuffer.commandBuffer.front().bindIndexBuffer(buffer.buffer, 0ULL, vk::IndexType::eUint32, dispatch.dispatch);
+    commandBuffer.commandBuffer.front().bindIndexBuffer(buffer.buffer, offset, vk::IndexType::eUint32, dispatch.dispatch);
 }
 
-inline void BindVertexBuffer(const Dispatch& dispatch, const CommandBuffer& commandBuffer, const Buffer& buffer) noexcept
+inline void BindVertexBuffer(const Dispatch& dispatch, const CommandBuffer& commandBuffer, const Buffer& buffer, const std::uint64_t offset = 0U) noexcept
 {
-    static constexpr vk::DeviceSize offset{0ULL};
     commandBuffer.commandBuffer.front().bindVertexBuffers(0U, {buffer.buffer}, {offset}, dispatch.dispatch);
 }
 
-inline void BindInstanceBuffer(const Dispatch& dispatch, const CommandBuffer& commandBuffer, const Buffer& buffer) noexcept
+inline void BindInstanceBuffer(const Dispatch& dispatch, const CommandBuffer& commandBuffer, const Buffer& buffer, const std::uint64_t offset = 0U) noexcept
 {
-    static constexpr vk::DeviceSize offset{0ULL};
     commandBuffer.commandBuffer.front().bindVertexBuffers(1U, {buffer.buffer}, {offset}, dispatch.dispatch);
 }
 
@@ -407,29 +453,29 @@ inline void BindInstanceBuffer(const Dispatch& dispatch, const CommandBuffer& co
 // Transfer — log one-time ops, skip per-frame CopyBuffers
 // ---------------------------------------------------------------------------
 
-inline void CopyBuffers(const Dispatch& dispatch, const CommandBuffer& commandBuffer, const Buffer& fromBuffer, const Buffer& toBuffer, const uint64_t size) noexcept
+inline void CopyBuffers(const Dispatch& dispatch, const CommandBuffer& commandBuffer, const Buffer& fromBuffer, const Buffer& toBuffer, const uint64_t size,
+                        const std::uint64_t srcOffset = 0ULL, const std::uint64_t dstOffset = 0ULL) noexcept
 {
     const vk::BufferCopy copyRegion{
-        .srcOffset = 0ULL,
-        .dstOffset = 0ULL,
+        .srcOffset = srcOffset,
+        .dstOffset = dstOffset,
         .size      = size,
     };
     commandBuffer.commandBuffer.front().copyBuffer(fromBuffer.buffer, toBuffer.buffer, {copyRegion}, dispatch.dispatch);
 }
 
-inline void CopyToImage(const Dispatch& dispatch, const CommandBuffer& commandBuffer, const Buffer& buffer, const Image& image, const std::uint32_t width,
-                        const std::uint32_t height, const std::uint32_t depth) noexcept
+// Fills mip 0 of every layer from tightly packed texels at bufferOffset. The image has to be in transfer dst layout.
+inline void CopyToImage(const Dispatch& dispatch, const CommandBuffer& commandBuffer, const Buffer& buffer, const std::uint64_t bufferOffset, const Image& image,
+                        const std::uint32_t width, const std::uint32_t height, const std::uint32_t depth) noexcept
 {
-    BeginSingleCommand(dispatch, commandBuffer);
-
-    constexpr vk::ImageSubresourceLayers subresource{
+    const vk::ImageSubresourceLayers subresource{
         .aspectMask     = vk::ImageAspectFlagBits::eColor,
         .mipLevel       = 0U,
         .baseArrayLayer = 0U,
-        .layerCount     = 1U,
+        .layerCount     = image.layerCount,
     };
 
-    const vk::BufferImageCopy region{.bufferOffset      = vk::DeviceSize{},
+    const vk::BufferImageCopy region{.bufferOffset      = bufferOffset,
                                      .bufferRowLength   = 0U,
                                      .bufferImageHeight = 0U,
                                      .imageSubresource  = subresource,
@@ -441,107 +487,45 @@ inline void CopyToImage(const Dispatch& dispatch, const CommandBuffer& commandBu
                                      },};
 
     commandBuffer.commandBuffer.front().copyBufferToImage(buffer.buffer, image.image, vk::ImageLayout::eTransferDstOptimal, {region}, dispatch.dispatch);
-
-    EndCommand(dispatch, commandBuffer);
 }
 
-[[nodiscard]] inline auto GenerateMips(const Dispatch& dispatch, const CommandBuffer& commandBuffer, const Image& image, const std::uint32_t width, const std::uint32_t height,
-                                       const std::uint32_t mipCount) noexcept -> vk_status
+// The stages and accesses an image in layout is used with, as sync2 bits. Layouts that do not say what they are for (attachment and read-only) are
+// told apart by the aspect. General can be any use at all, so it waits for and on everything.
+[[nodiscard]] constexpr auto LayoutStageAccess(const vk::ImageLayout layout, const vk::ImageAspectFlags aspect) noexcept -> StageAccess
 {
-    BeginSingleCommand(dispatch, commandBuffer);
-
-    vk::ImageMemoryBarrier barrier{
-        .sType               = vk::StructureType::eImageMemoryBarrier,
-        .pNext               = nullptr,
-        .srcAccessMask       = {},
-        .dstAccessMask       = {},
-        .oldLayout           = vk::ImageLayout::eUndefined,
-        .newLayout           = vk::ImageLayout::eUndefined,
-        .srcQueueFamilyIndex = vk::QueueFamilyIgnored,
-        .dstQueueFamilyIndex = vk::QueueFamilyIgnored,
-        .image               = image.image,
-        .subresourceRange    = vk::ImageSubresourceRange{
-            .aspectMask      = vk::ImageAspectFlagBits::eColor,
-            .baseMipLevel    = 0U,
-            .levelCount      = 1U,
-            .baseArrayLayer  = 0U,
-            .layerCount      = 1U,
-        },
-    };
-
-    auto mipWidth  = static_cast<std::int32_t>(width);
-    auto mipHeight = static_cast<std::int32_t>(height);
-
-    for (std::uint32_t i = 1U; i < mipCount; ++i)
+    const bool isDepth{(aspect & (vk::ImageAspectFlagBits::eDepth | vk::ImageAspectFlagBits::eStencil)) != vk::ImageAspectFlags{}};
+    constexpr vk::PipelineStageFlags2 fragmentTests{vk::PipelineStageFlagBits2::eEarlyFragmentTests | vk::PipelineStageFlagBits2::eLateFragmentTests};
+    switch (layout)
     {
-        barrier.subresourceRange.baseMipLevel = i - 1U;
-        barrier.oldLayout                     = vk::ImageLayout::eTransferDstOptimal;
-        barrier.newLayout                     = vk::ImageLayout::eTransferSrcOptimal;
-        barrier.srcAccessMask                 = vk::AccessFlagBits::eTransferWrite;
-        barrier.dstAccessMask                 = vk::AccessFlagBits::eTransferRead;
-
-        commandBuffer.commandBuffer.front().pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eTransfer, vk::DependencyFlags{}, {}, {}, {barrier},
-                                                            dispatch.dispatch);
-
-        const vk::ImageBlit blit{
-            .srcSubresource = vk::ImageSubresourceLayers{.aspectMask = vk::ImageAspectFlagBits::eColor, .mipLevel = i - 1U, .baseArrayLayer = 0U, .layerCount = 1U,},
-            .srcOffsets     = std::array{vk::Offset3D{.x=0,.y= 0,.z= 0}, vk::Offset3D{.x=mipWidth, .y=mipHeight, .z=1}},
-            .dstSubresource = vk::ImageSubresourceLayers{.aspectMask=vk::ImageAspectFlagBits::eColor, .mipLevel= i, .baseArrayLayer= 0U, .layerCount= 1U,},
-            .dstOffsets     = std::array{vk::Offset3D{.x=0, .y=0, .z=0}, vk::Offset3D{.x=mipWidth > 1 ? mipWidth >> 1 : 1,.y= mipHeight > 1 ? mipHeight >> 1 : 1,.z= 1}},
-        };
-
-        commandBuffer.commandBuffer.front().blitImage(image.image, vk::ImageLayout::eTransferSrcOptimal, image.image, vk::ImageLayout::eTransferDstOptimal, {blit},
-                                                      vk::Filter::eLinear, dispatch.dispatch);
-
-        barrier.oldLayout     = vk::ImageLayout::eTransferSrcOptimal;
-        barrier.newLayout     = vk::ImageLayout::eTransferDstOptimal;
-        barrier.srcAccessMask = vk::AccessFlagBits::eTransferRead;
-        barrier.dstAccessMask = vk::AccessFlagBits::eShaderRead;
-
-        commandBuffer.commandBuffer.front().pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eFragmentShader, vk::DependencyFlags{}, {}, {},
-                                                            {barrier}, dispatch.dispatch);
-
-        if (mipWidth > 1)
-        {
-            mipWidth >>= 1;
-        }
-        if (mipHeight > 1)
+    case vk::ImageLayout::eUndefined: [[fallthrough]];
+    case vk::ImageLayout::ePresentSrcKHR: return {vk::PipelineStageFlagBits2::eNone, vk::AccessFlagBits2::eNone};
+    case vk::ImageLayout::eAttachmentOptimal:
+        if (isDepth)
         {
-            mipHeight >>= 1;
+            return {fragmentTests, vk::AccessFlagBits2::eDepthStencilAttachmentRead | vk::AccessFlagBits2::eDepthStencilAttachmentWrite};
         }
-    }
-
-    barrier.subresourceRange.baseMipLevel = mipCount - 1U;
-    barrier.oldLayout                     = vk::ImageLayout::eTransferDstOptimal;
-    barrier.newLayout                     = vk::ImageLayout::eReadOnlyOptimal;
-    barrier.srcAccessMask                 = vk::AccessFlagBits::eTransferRead;
-    barrier.dstAccessMask                 = vk::AccessFlagBits::eShaderRead;
-    commandBuffer.commandBuffer.front().pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eFragmentShader, vk::DependencyFlagBits{}, {}, {},
-                                                        {barrier}, dispatch.dispatch);
-
-    EndCommand(dispatch, commandBuffer);
-    return vk_status::ok;
-}
-
-[[nodiscard]] constexpr StageAccess getStageAccess(const vk::ImageLayout layout)
-{
-    switch (layout)
-    {
-    case vk::ImageLayout::eUndefined: return {vk::PipelineStageFlagBits::eTopOfPipe, vk::AccessFlags{}};
-    case vk::ImageLayout::eGeneral: return {vk::PipelineStageFlagBits::eAllCommands, vk::AccessFlagBits::eMemoryRead | vk::AccessFlagBits::eMemoryWrite};
+        [[fallthrough]];
     case vk::ImageLayout::eColorAttachmentOptimal:
-        return {vk::PipelineStageFlagBits::eColorAttachmentOutput, vk::AccessFlagBits::eColorAttachmentWrite | vk::AccessFlagBits::eColorAttachmentRead};
+        return {vk::PipelineStageFlagBits2::eColorAttachmentOutput, vk::AccessFlagBits2::eColorAttachmentRead | vk::AccessFlagBits2::eColorAttachmentWrite};
+    case vk::ImageLayout::eDepthAttachmentOptimal: [[fallthrough]];
     case vk::ImageLayout::eDepthStencilAttachmentOptimal:
-        return {vk::PipelineStageFlagBits::eEarlyFragmentTests | vk::PipelineStageFlagBits::eLateFragmentTests,
-                vk::AccessFlagBits::eDepthStencilAttachmentWrite | vk::AccessFlagBits::eDepthStencilAttachmentRead};
+        return {fragmentTests, vk::AccessFlagBits2::eDepthStencilAttachmentRead | vk::AccessFlagBits2::eDepthStencilAttachmentWrite};
+    case vk::ImageLayout::eReadOnlyOptimal:
+        if (!isDepth)
+        {
+            return {vk::PipelineStageFlagBits2::eFragmentShader | vk::PipelineStageFlagBits2::eComputeShader, vk::AccessFlagBits2::eShaderSampledRead};
+        }
+        [[fallthrough]];
+    case vk::ImageLayout::eDepthReadOnlyOptimal: [[fallthrough]];
     case vk::ImageLayout::eDepthStencilReadOnlyOptimal:
-        return {vk::PipelineStageFlagBits::eFragmentShader | vk::PipelineStageFlagBits::eEarlyFragmentTests,
-                vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eDepthStencilAttachmentRead};
-    case vk::ImageLayout::eShaderReadOnlyOptimal: return {vk::PipelineStageFlagBits::eFragmentShader | vk::PipelineStageFlagBits::eComputeShader, vk::AccessFlagBits::eShaderRead};
-    case vk::ImageLayout::eTransferSrcOptimal: return {vk::PipelineStageFlagBits::eTransfer, vk::AccessFlagBits::eTransferRead};
-    case vk::ImageLayout::eTransferDstOptimal: return {vk::PipelineStageFlagBits::eTransfer, vk::AccessFlagBits::eTransferWrite};
-    case vk::ImageLayout::ePresentSrcKHR: return {vk::PipelineStageFlagBits::eBottomOfPipe, vk::AccessFlags{}};
-    default: return {vk::PipelineStageFlagBits::eAllCommands, vk::AccessFlagBits::eMemoryRead | vk::AccessFlagBits::eMemoryWrite};
+        return {fragmentTests | vk::PipelineStageFlagBits2::eFragmentShader | vk::PipelineStageFlagBits2::eComputeShader,
+                vk::AccessFlagBits2::eDepthStencilAttachmentRead | vk::AccessFlagBits2::eShaderSampledRead};
+    case vk::ImageLayout::eShaderReadOnlyOptimal:
+        return {vk::PipelineStageFlagBits2::eFragmentShader | vk::PipelineStageFlagBits2::eComputeShader, vk::AccessFlagBits2::eShaderSampledRead};
+    case vk::ImageLayout::eTransferSrcOptimal: return {vk::PipelineStageFlagBits2::eAllTransfer, vk::AccessFlagBits2::eTransferRead};
+    case vk::ImageLayout::eTransferDstOptimal: return {vk::PipelineStageFlagBits2::eAllTransfer, vk::AccessFlagBits2::eTransferWrite};
+    case vk::ImageLayout::eGeneral: [[fallthrough]];
+    default: return {vk::PipelineStageFlagBits2::eAllCommands, vk::AccessFlagBits2::eMemoryRead | vk::AccessFlagBits2::eMemoryWrite};
     }
 }
 
@@ -568,31 +552,206 @@ inline void CopyToImage(const Dispatch& dispatch, const CommandBuffer& commandBu
     }
 }
 
+// Image barriers cover the range they name, buffer barriers the whole buffer.
+[[nodiscard]] inline auto ToImageMemoryBarrier(const ImageBarrier& barrier) noexcept -> vk::ImageMemoryBarrier2
+{
+    return vk::ImageMemoryBarrier2{
+        .sType               = vk::StructureType::eImageMemoryBarrier2,
+        .pNext               = nullptr,
+        .srcStageMask        = static_cast<vk::PipelineStageFlags2>(barrier.srcStage),
+        .srcAccessMask       = static_cast<vk::AccessFlags2>(barrier.srcAccess),
+        .dstStageMask        = static_cast<vk::PipelineStageFlags2>(barrier.dstStage),
+        .dstAccessMask       = static_cast<vk::AccessFlags2>(barrier.dstAccess),
+        .oldLayout           = static_cast<vk::ImageLayout>(barrier.oldLayout),
+        .newLayout           = static_cast<vk::ImageLayout>(barrier.newLayout),
+        .srcQueueFamilyIndex = barrier.srcQueueFamily,
+        .dstQueueFamilyIndex = barrier.dstQueueFamily,
+        .image               = barrier.image->image,
+        .subresourceRange =
+            vk::ImageSubresourceRange{
+                .aspectMask     = barrier.image->aspect,
+                .baseMipLevel   = barrier.mipOffset,
+                .levelCount     = barrier.mipCount,
+                .baseArrayLayer = barrier.layerOffset,
+                .layerCount     = barrier.layerCount,
+            },
+    };
+}
+
+[[nodiscard]] inline auto ToBufferMemoryBarrier(const BufferBarrier& barrier) noexcept -> vk::BufferMemoryBarrier2
+{
+    return vk::BufferMemoryBarrier2{
+        .sType               = vk::StructureType::eBufferMemoryBarrier2,
+        .pNext               = nullptr,
+        .srcStageMask        = static_cast<vk::PipelineStageFlags2>(barrier.srcStage),
+        .srcAccessMask       = static_cast<vk::AccessFlags2>(barrier.srcAccess),
+        .dstStageMask        = static_cast<vk::PipelineStageFlags2>(barrier.dstStage),
+        .dstAccessMask       = static_cast<vk::AccessFlags2>(barrier.dstAccess),
+        .srcQueueFamilyIndex = barrier.srcQueueFamily,
+        .dstQueueFamilyIndex = barrier.dstQueueFamily,
+        .buffer              = barrier.buffer->buffer,
+        .offset              = 0U,
+        .size                = vk::WholeSize,
+    };
+}
+
+// Collects barriers and records them all with one pipelineBarrier2 call when flushed, so a boundary between two pieces of work costs one call
+// however many images and buffers it covers. Only a batch that fills up is recorded early.
+struct BarrierBatch
+{
+    static constexpr std::uint32_t capacity{32U};
+    std::array<vk::ImageMemoryBarrier2, capacity> imageInfos{};
+    std::array<vk::BufferMemoryBarrier2, capacity> bufferInfos{};
+    std::uint32_t imageCount{};
+    std::uint32_t bufferCount{};
+};
+
+inline void FlushBarriers(const Dispatch& dispatch, const CommandBuffer& commandBuffer, BarrierBatch& batch) noexcept
+{
+    if (batch.imageCount == 0U && batch.bufferCount == 0U)
+    {
+        return;
+    }
+    const vk::DependencyInfo dependencyInfo{
+        .sType                    = vk::StructureType::eDependencyInfo,
+        .pNext                    = nullptr,
+        .dependencyFlags          = {},
+        .memoryBarrierCount       = 0U,
+        .pMemoryBarriers          = nullptr,
+        .bufferMemoryBarrierCount = batch.bufferCount,
+        .pBufferMemoryBarriers    = batch.bufferInfos.data(),
+        .imageMemoryBarrierCount  = batch.imageCount,
+        .pImageMemoryBarriers     = batch.imageInfos.data(),
+    };
+    commandBuffer.commandBuffer.front().pipelineBarrier2(dependencyInfo, dispatch.dispatch);
+    batch.imageCount  = 0U;
+    batch.bufferCount = 0U;
+}
+
+// Unless told otherwise, the tracked layout of the barrier's range changes right away, as later transitions in the same batch have to see it.
+inline void AddBarrier(const Dispatch& dispatch, const CommandBuffer& commandBuffer, BarrierBatch& batch, const ImageBarrier& barrier, const bool trackLayout = true) noexcept
+{
+    if (batch.imageCount == BarrierBatch::capacity)
+    {
+        FlushBarriers(dispatch, commandBuffer, batch);
+    }
+    batch.imageInfos[batch.imageCount++] = ToImageMemoryBarrier(barrier);
+    if (trackLayout)
+    {
+        SetLayout(*barrier.image, barrier.newLayout, barrier.mipOffset, barrier.mipCount, barrier.layerOffset, barrier.layerCount);
+    }
+}
+
+inline void AddBarrier(const Dispatch& dispatch, const CommandBuffer& commandBuffer, BarrierBatch& batch, const BufferBarrier& barrier) noexcept
+{
+    if (batch.bufferCount == BarrierBatch::capacity)
+    {
+        FlushBarriers(dispatch, commandBuffer, batch);
+    }
+    batch.bufferInfos[batch.bufferCount++] = ToBufferMemoryBarrier(barrier);
+}
+
+// Records the barriers with as few pipelineBarrier2 calls as possible (one unless there are more than a batch) and, unless told otherwise, updates the
+// tracked image layouts. Callers recording on several threads at once pass trackLayouts = false and set the layouts themselves afterwards.
+inline void PipelineBarrier(const Dispatch& dispatch, const CommandBuffer& commandBuffer, const std::span<const ImageBarrier> imageBarriers,
+                            const std::span<const BufferBarrier> bufferBarriers, const bool trackLayouts = true) noexcept
+{
+    BarrierBatch batch{};
+    for (const ImageBarrier& barrier : imageBarriers)
+    {
+        AddBarrier(dispatch, commandBuffer, batch, barrier, trackLayouts);
+    }
+    for (const BufferBarrier& barrier : bufferBarriers)
+    {
+        AddBarrier(dispatch, commandBuffer, batch, barrier);
+    }
+    FlushBarriers(dispatch, commandBuffer, batch);
+}
+
+// Adds what it takes to move a range of subresources to newLayout. Only the parts that are in another layout get a barrier, each from the layout it is
+// actually in and with the stages that layout is used in, so mips or layers that went their own way (mip generation, rendering into one face or cascade)
+// are neither transitioned twice nor from a wrong layout.
+inline void AddTransition(const Dispatch& dispatch, const CommandBuffer& commandBuffer, BarrierBatch& batch, Image& image, const std::uint32_t newLayout,
+                          const std::uint32_t mipOffset = 0U, const std::uint32_t mipCount = vk::RemainingMipLevels, const std::uint32_t layerOffset = 0U,
+                          const std::uint32_t layerCount = vk::RemainingArrayLayers) noexcept
+{
+    const auto [dstStageMask, dstAccessMask]{LayoutStageAccess(static_cast<vk::ImageLayout>(newLayout), image.aspect)};
+    ForEachLayoutRun(image, newLayout, mipOffset, mipCount, layerOffset, layerCount,
+                     [&](const std::uint32_t runMipOffset, const std::uint32_t runMipCount, const std::uint32_t runLayerOffset, const std::uint32_t runLayerCount,
+                         const vk::ImageLayout oldLayout)
+                     {
+                         const auto [srcStageMask, srcAccessMask]{LayoutStageAccess(oldLayout, image.aspect)};
+                         AddBarrier(dispatch, commandBuffer, batch,
+                                    ImageBarrier{.image       = &image,
+                                                 .srcStage    = static_cast<std::uint64_t>(srcStageMask),
+                                                 .srcAccess   = static_cast<std::uint64_t>(srcAccessMask),
+                                                 .dstStage    = static_cast<std::uint64_t>(dstStageMask),
+                                                 .dstAccess   = static_cast<std::uint64_t>(dstAccessMask),
+                                                 .oldLayout   = static_cast<std::uint32_t>(oldLayout),
+                                                 .newLayout   = newLayout,
+                                                 .mipOffset   = runMipOffset,
+                                                 .mipCount    = runMipCount,
+                                                 .layerOffset = runLayerOffset,
+                                                 .layerCount  = runLayerCount},
+                                    /*trackLayout=*/false);
+                     });
+    SetLayout(image, newLayout, mipOffset, mipCount, layerOffset, layerCount);
+}
+
+// AddTransition on its own, recorded right away with a single barrier call.
 inline void TransitionImageLayout(const Dispatch& dispatch, const CommandBuffer& commandBuffer, Image& image, const std::uint32_t newLayout, const std::uint32_t mipOffset = 0U,
                                   const std::uint32_t mipCount = 1U, const std::uint32_t layerOffset = 0U, const std::uint32_t layerCount = 1U) noexcept
 {
-    const auto layout{static_cast<vk::ImageLayout>(newLayout)};
-    const auto [srsStageMask, srsAccessMask]{getStageAccess(image.layout)};
-    const auto [dstStageMask, dstAccessMask]{getStageAccess(layout)};
-    const vk::ImageMemoryBarrier barrierPresent{.sType               = vk::StructureType::eImageMemoryBarrier,
-                                           .pNext               = nullptr,
-                                           .srcAccessMask       = srsAccessMask,
-                                           .dstAccessMask       = dstAccessMask,
-                                           .oldLayout           = image.layout,
-                                           .newLayout           = layout,
-                                           .srcQueueFamilyIndex = vk::QueueFamilyIgnored,
-                                           .dstQueueFamilyIndex = vk::QueueFamilyIgnored,
-                                           .image               = image.image,
-                                           .subresourceRange    = {
-                                               .aspectMask     = ChooseAspectMask(layout),
-                                               .baseMipLevel   = mipOffset,
-                                               .levelCount     = mipCount,
-                                               .baseArrayLayer = layerOffset,
-                                               .layerCount     = layerCount,
-                                           },};
-
-    commandBuffer.commandBuffer.front().pipelineBarrier(srsStageMask, dstStageMask, {}, {}, {}, {barrierPresent}, dispatch.dispatch);
-    image.layout = static_cast<vk::ImageLayout>(newLayout);
+    BarrierBatch batch{};
+    AddTransition(dispatch, commandBuffer, batch, image, newLayout, mipOffset, mipCount, layerOffset, layerCount);
+    FlushBarriers(dispatch, commandBuffer, batch);
+}
+
+// Fills mips 1 to mipCount - 1 of every layer by blitting each from the one above, and leaves every mip in finalLayout.
+// Every blit is preceded by one barrier call: the mip it reads from, the mip it writes to and the mip done two steps ago move together.
+[[nodiscard]] inline auto GenerateMips(const Dispatch& dispatch, const CommandBuffer& commandBuffer, Image& image, const std::uint32_t width, const std::uint32_t height,
+                                       const std::uint32_t mipCount, const std::uint32_t finalLayout = static_cast<std::uint32_t>(vk::ImageLayout::eReadOnlyOptimal)) noexcept
+    -> vk_status
+{
+    constexpr auto transferSrc{static_cast<std::uint32_t>(vk::ImageLayout::eTransferSrcOptimal)};
+    constexpr auto transferDst{static_cast<std::uint32_t>(vk::ImageLayout::eTransferDstOptimal)};
+
+    auto mipWidth  = static_cast<std::int32_t>(width);
+    auto mipHeight = static_cast<std::int32_t>(height);
+
+    BarrierBatch batch{};
+    for (std::uint32_t i = 1U; i < mipCount; ++i)
+    {
+        if (i >= 2U)
+        {
+            AddTransition(dispatch, commandBuffer, batch, image, finalLayout, i - 2U, 1U, 0U, image.layerCount);
+        }
+        AddTransition(dispatch, commandBuffer, batch, image, transferSrc, i - 1U, 1U, 0U, image.layerCount);
+        AddTransition(dispatch, commandBuffer, batch, image, transferDst, i, 1U, 0U, image.layerCount);
+        FlushBarriers(dispatch, commandBuffer, batch);
+
+        const vk::ImageBlit blit{
+            .srcSubresource = vk::ImageSubresourceLayers{.aspectMask = vk::ImageAspectFlagBits::eColor, .mipLevel = i - 1U, .baseArrayLayer = 0U, .layerCount = image.layerCount,},
+            .srcOffsets     = std::array{vk::Offset3D{.x=0,.y= 0,.z= 0}, vk::Offset3D{.x=mipWidth, .y=mipHeight, .z=1}},
+            .dstSubresource = vk::ImageSubresourceLayers{.aspectMask=vk::ImageAspectFlagBits::eColor, .mipLevel= i, .baseArrayLayer= 0U, .layerCount= image.layerCount,},
+            .dstOffsets     = std::array{vk::Offset3D{.x=0, .y=0, .z=0}, vk::Offset3D{.x=mipWidth > 1 ? mipWidth >> 1 : 1,.y= mipHeight > 1 ? mipHeight >> 1 : 1,.z= 1}},
+        };
+
+        commandBuffer.commandBuffer.front().blitImage(image.image, vk::ImageLayout::eTransferSrcOptimal, image.image, vk::ImageLayout::eTransferDstOptimal, {blit},
+                                                      vk::Filter::eLinear, dispatch.dispatch);
+
+        if (mipWidth > 1)
+        {
+            mipWidth >>= 1;
+        }
+        if (mipHeight > 1)
+        {
+            mipHeight >>= 1;
+        }
+    }
+    AddTransition(dispatch, commandBuffer, batch, image, finalLayout, 0U, mipCount, 0U, image.layerCount);
+    FlushBarriers(dispatch, commandBuffer, batch);
+    return vk_status::ok;
 }
 
 // ---------------------------------------------------------------------------
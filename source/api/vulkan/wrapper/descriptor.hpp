@@ -102,9 +102,11 @@ inline void Cleanup(const Dispatch& dispatch, const Device& device, Descriptor&
     descriptor.bufferInfos.clear();
 }
 
-inline void BindImage(Descriptor& descriptor, const Sampler& sampler, const ImageView& imageView, const Image& image, const std::uint32_t binding) noexcept
+// layout is a raw VkImageLayout: the one the image is in whenever the descriptor is read, not its current layout.
+inline void BindImage(Descriptor& descriptor, const Sampler& sampler, const ImageView& imageView, const std::uint32_t layout, const std::uint32_t binding) noexcept
 {
-    descriptor.imageInfos.push_back(vk::DescriptorImageInfo{.sampler = sampler.sampler, .imageView = imageView.imageView, .imageLayout = image.layout});
+    descriptor.imageInfos.push_back(
+        vk::DescriptorImageInfo{.sampler = sampler.sampler, .imageView = imageView.imageView, .imageLayout = static_cast<vk::ImageLayout>(layout)});
     descriptor.writeDescriptorSets.push_back(vk::WriteDescriptorSet{
         .pNext            = nullptr,
         .dstSet           = descriptor.descriptorSet,
@@ -118,8 +120,9 @@ inline void BindImage(Descriptor& descriptor, const Sampler& sampler, const Imag
     });
 }
 
+// type is a raw VkDescriptorType. A dynamic type adds the offset given when the descriptor is bound to offset.
 inline void BindBuffer(Descriptor& descriptor, const Buffer& buffer, const uint64_t offset, const uint64_t range, const std::uint32_t binding,
-                       const vk::DescriptorType type = vk::DescriptorType::eUniformBuffer) noexcept
+                       const std::uint32_t type = static_cast<std::uint32_t>(vk::DescriptorType::eUniformBuffer)) noexcept
 {
     descriptor.bufferInfos.push_back(vk::DescriptorBufferInfo{.buffer = buffer.buffer, .offset = offset, .range = range});
     descriptor.writeDescriptorSets.push_back(vk::WriteDescriptorSet{
@@ -128,7 +131,7 @@ inline void BindBuffer(Descriptor& descriptor, const Buffer& buffer, const uint6
         .dstBinding       = binding,
         .dstArrayElement  = 0U,
         .descriptorCount  = 1U,
-        .descriptorType   = type,
+        .descriptorType   = static_cast<vk::DescriptorType>(type),
         .pImageInfo       = nullptr,
         .pBufferInfo      = &descriptor.bufferInfos.back(),
         .pTexelBufferView = nullptr,
@@ -13,51 +13,31 @@ struct Device
 
 [[nodiscard]] inline auto Initialize(const Dispatch& dispatch, PhysicalDevice& physicalDevice, Device& device) noexcept -> vk_status
 {
-    const bool sharedFamily{(physicalDevice.graphicsQueueFamily == physicalDevice.presentQueueFamily)};
+    // One create info per distinct family, asking for as many queues as SelectPhysicalDevice handed out of it.
+    static constexpr std::array priorities{1.0f, 1.0f, 1.0f, 1.0f};
+    const std::array<std::pair<std::uint32_t, std::uint32_t>, 4> queueUses{{
+        {physicalDevice.graphicsQueueFamily, physicalDevice.graphicsQueueIdx},
+        {physicalDevice.computeQueueFamily, physicalDevice.computeQueueIdx},
+        {physicalDevice.presentQueueFamily, physicalDevice.presentQueueIdx},
+        {physicalDevice.transferQueueFamily, physicalDevice.transferQueueIdx},
+    }};
 
     std::vector<vk::DeviceQueueCreateInfo> queueCIs;
-    if (sharedFamily)
+    for (const auto& [family, index] : queueUses)
     {
-        // All three queues from the same family — request distinct indices if available
-        static constexpr std::array priorities{1.0f, 1.0f, 1.0f};
+        const auto it{std::ranges::find(queueCIs, family, &vk::DeviceQueueCreateInfo::queueFamilyIndex)};
+        if (it != queueCIs.end())
+        {
+            it->queueCount = std::max(it->queueCount, index + 1U);
+            continue;
+        }
         queueCIs.push_back({
             .sType            = vk::StructureType::eDeviceQueueCreateInfo,
-            .queueFamilyIndex = physicalDevice.graphicsQueueFamily,
-            .queueCount       = static_cast<std::uint32_t>(priorities.size()),
+            .queueFamilyIndex = family,
+            .queueCount       = index + 1U,
             .pQueuePriorities = priorities.data(),
         });
     }
-    else
-    {
-        static constexpr float priority{1.0f};
-        queueCIs.push_back({
-            .sType            = vk::StructureType::eDeviceQueueCreateInfo,
-            .queueFamilyIndex = physicalDevice.graphicsQueueFamily,
-            .queueCount       = 1U,
-            .pQueuePriorities = &priority,
-        });
-
-        // Dedicated compute family if available
-        if (physicalDevice.computeQueueFamily != physicalDevice.graphicsQueueFamily)
-        {
-            queueCIs.push_back({
-                .sType            = vk::StructureType::eDeviceQueueCreateInfo,
-                .queueFamilyIndex = physicalDevice.computeQueueFamily,
-                .queueCount       = 1U,
-                .pQueuePriorities = &priority,
-            });
-        }
-
-        if (physicalDevice.presentQueueFamily != physicalDevice.graphicsQueueFamily && physicalDevice.presentQueueFamily != physicalDevice.computeQueueFamily)
-        {
-            queueCIs.push_back({
-                .sType            = vk::StructureType::eDeviceQueueCreateInfo,
-                .queueFamilyIndex = physicalDevice.presentQueueFamily,
-                .queueCount       = 1U,
-                .pQueuePriorities = &priority,
-            });
-        }
-    }
 
     constexpr vk::Bool32 vkBoolTrue{static_cast<vk::Bool32>(true)};
     constexpr vk::Bool32 vkBoolFalse{static_cast<vk::Bool32>(false)};
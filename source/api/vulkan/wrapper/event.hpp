@@ -0,0 +1,91 @@
+#pragma once
+#include "../deer_vulkan_core.hpp"
+
+#include "command.hpp"
+#include "device.hpp"
+#include "dispatch.hpp"
+
+namespace deer_vulkan
+{
+
+// Splits a barrier in two: SetEvent once the source work is recorded, WaitEvent where the destination work starts, with unrelated work in between.
+// Both halves have to be given the same barrier. Events are only set and waited for on the GPU, within one queue.
+struct Event
+{
+    vk::Event event{nullptr};
+};
+
+[[nodiscard]] inline auto Initialize(const Dispatch& dispatch, const Device& device, Event& event) noexcept -> vk_status
+{
+    const vk::EventCreateInfo createInfo{
+        .sType = vk::StructureType::eEventCreateInfo,
+        .pNext = nullptr,
+        .flags = vk::EventCreateFlagBits::eDeviceOnly,
+    };
+
+    if (const vk_status status{FromVkResult(device.device.createEvent(&createInfo, nullptr, &event.event, dispatch.dispatch))}; IsError(status)) [[unlikely]]
+    {
+        event.event = nullptr;
+        return status;
+    }
+    return vk_status::ok;
+}
+
+inline auto Cleanup(const Dispatch& dispatch, const Device& device, Event& event) noexcept -> void
+{
+    if (event.event == nullptr)
+    {
+        return;
+    }
+    device.device.destroyEvent(event.event, nullptr, dispatch.dispatch);
+    event.event = nullptr;
+}
+
+// Exactly one of pImageBarrier and pBufferBarrier is set.
+[[nodiscard]] inline auto EventDependency(const ImageBarrier* pImageBarrier, const BufferBarrier* pBufferBarrier, vk::ImageMemoryBarrier2& imageInfo,
+                                          vk::BufferMemoryBarrier2& bufferInfo) noexcept -> vk::DependencyInfo
+{
+    if (pImageBarrier != nullptr)
+    {
+        imageInfo = ToImageMemoryBarrier(*pImageBarrier);
+    }
+    else
+    {
+        bufferInfo = ToBufferMemoryBarrier(*pBufferBarrier);
+    }
+    return vk::DependencyInfo{
+        .sType                    = vk::StructureType::eDependencyInfo,
+        .pNext                    = nullptr,
+        .dependencyFlags          = {},
+        .memoryBarrierCount       = 0U,
+        .pMemoryBarriers          = nullptr,
+        .bufferMemoryBarrierCount = pImageBarrier != nullptr ? 0U : 1U,
+        .pBufferMemoryBarriers    = &bufferInfo,
+        .imageMemoryBarrierCount  = pImageBarrier != nullptr ? 1U : 0U,
+        .pImageMemoryBarriers     = &imageInfo,
+    };
+}
+
+// Must be recorded outside a rendering scope.
+inline void SetEvent(const Dispatch& dispatch, const CommandBuffer& commandBuffer, const Event& event, const ImageBarrier* pImageBarrier,
+                     const BufferBarrier* pBufferBarrier) noexcept
+{
+    vk::ImageMemoryBarrier2 imageInfo{};
+    vk::BufferMemoryBarrier2 bufferInfo{};
+    const vk::DependencyInfo dependencyInfo{EventDependency(pImageBarrier, pBufferBarrier, imageInfo, bufferInfo)};
+    commandBuffer.commandBuffer.front().setEvent2(event.event, dependencyInfo, dispatch.dispatch);
+}
+
+// Waits for the event and, once past it, unsignals it again at the barrier's destination stage so it can be set by the next frame that uses it.
+// Does not touch the tracked image layout.
+inline void WaitEvent(const Dispatch& dispatch, const CommandBuffer& commandBuffer, const Event& event, const ImageBarrier* pImageBarrier,
+                      const BufferBarrier* pBufferBarrier) noexcept
+{
+    vk::ImageMemoryBarrier2 imageInfo{};
+    vk::BufferMemoryBarrier2 bufferInfo{};
+    const vk::DependencyInfo dependencyInfo{EventDependency(pImageBarrier, pBufferBarrier, imageInfo, bufferInfo)};
+    const vk::CommandBuffer& cmd{commandBuffer.commandBuffer.front()};
+    cmd.waitEvents2(1U, &event.event, &dependencyInfo, dispatch.dispatch);
+    cmd.resetEvent2(event.event, pImageBarrier != nullptr ? imageInfo.dstStageMask : bufferInfo.dstStageMask, dispatch.dispatch);
+}
+} // namespace deer_vulkan
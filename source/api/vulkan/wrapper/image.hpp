@@ -1,5 +1,6 @@
 #pragma once
 #include "../deer_vulkan_core.hpp"
+#include "allocator.hpp"
 #include "device.hpp"
 #include "physical_device.hpp"
 
@@ -16,18 +17,139 @@ struct ImageCreateInfo
     std::uint32_t sampleCount{};
     std::uint32_t usage{};
     std::uint32_t memoryProperty{};
+    memory_usage memoryUsage{}; // unknown picks transient for transient attachments
     std::uint8_t imageType{};
     std::uint8_t tiling{};
 };
 
+// Layouts are tracked per mip level and array layer, but only once they differ: while subresourceLayouts is empty, every subresource is in layout.
 struct Image
 {
     vk::Image image{nullptr};
-    vk::DeviceMemory memory{nullptr};
+    Allocation allocation{}; // owns nothing when the image was bound to memory it does not own
     vk::ImageLayout layout{};
+    vk::ImageAspectFlags aspect{vk::ImageAspectFlagBits::eColor};
+    std::uint32_t width{};
+    std::uint32_t height{};
+    std::uint32_t mipCount{1U};
+    std::uint32_t layerCount{1U};
+    std::vector<vk::ImageLayout> subresourceLayouts{}; // layer * mipCount + mip
+};
+
+[[nodiscard]] inline auto GetLayout(const Image& image, const std::uint32_t mip, const std::uint32_t layer) noexcept -> vk::ImageLayout
+{
+    return image.subresourceLayouts.empty() ? image.layout : image.subresourceLayouts[layer * image.mipCount + mip];
+}
+
+// Whether every subresource is in layout, a raw VkImageLayout value.
+[[nodiscard]] inline auto IsInLayout(const Image& image, const std::uint32_t layout) noexcept -> bool
+{
+    return image.subresourceLayouts.empty() && image.layout == static_cast<vk::ImageLayout>(layout);
+}
+
+// How many of total levels or layers a range starting at offset covers; count may be vk::RemainingMipLevels / vk::RemainingArrayLayers.
+[[nodiscard]] constexpr auto RangeCount(const std::uint32_t offset, const std::uint32_t count, const std::uint32_t total) noexcept -> std::uint32_t
+{
+    return offset >= total ? 0U : std::min(count, total - offset);
+}
+
+// Records that a range of subresources is now in layout, a raw VkImageLayout value. Goes back to a single layout once every subresource agrees again.
+inline auto SetLayout(Image& image, const std::uint32_t layout, const std::uint32_t mipOffset = 0U, const std::uint32_t mipCount = vk::RemainingMipLevels,
+                      const std::uint32_t layerOffset = 0U, const std::uint32_t layerCount = vk::RemainingArrayLayers) noexcept -> void
+{
+    const auto newLayout{static_cast<vk::ImageLayout>(layout)};
+    const std::uint32_t mips{RangeCount(mipOffset, mipCount, image.mipCount)};
+    const std::uint32_t layers{RangeCount(layerOffset, layerCount, image.layerCount)};
+    if (mips == image.mipCount && layers == image.layerCount)
+    {
+        image.layout = newLayout;
+        image.subresourceLayouts.clear();
+        return;
+    }
+    if (image.subresourceLayouts.empty())
+    {
+        if (image.layout == newLayout)
+        {
+            return;
+        }
+        image.subresourceLayouts.assign(static_cast<std::size_t>(image.mipCount) * image.layerCount, image.layout);
+    }
+    for (std::uint32_t layer{layerOffset}; layer < layerOffset + layers; ++layer)
+    {
+        std::fill_n(image.subresourceLayouts.begin() + layer * image.mipCount + mipOffset, mips, newLayout);
+    }
+    if (std::ranges::all_of(image.subresourceLayouts,
+                            [newLayout](const vk::ImageLayout subresourceLayout)
+                            {
+                                return subresourceLayout == newLayout;
+                            }))
+    {
+        image.layout = newLayout;
+        image.subresourceLayouts.clear();
+    }
+}
+
+// Calls visit(mipOffset, mipCount, layerOffset, layerCount, oldLayout) for the parts of a range that are not in layout yet: the whole range at once while
+// the image has a single layout, otherwise every run of consecutive mips of one layer that shares a layout.
+template <class Visit>
+inline auto ForEachLayoutRun(const Image& image, const std::uint32_t layout, const std::uint32_t mipOffset, const std::uint32_t mipCount, const std::uint32_t layerOffset,
+                             const std::uint32_t layerCount, Visit&& visit) noexcept -> void
+{
+    const auto newLayout{static_cast<vk::ImageLayout>(layout)};
+    const std::uint32_t mips{RangeCount(mipOffset, mipCount, image.mipCount)};
+    const std::uint32_t layers{RangeCount(layerOffset, layerCount, image.layerCount)};
+    if (image.subresourceLayouts.empty())
+    {
+        if (image.layout != newLayout && mips != 0U && layers != 0U)
+        {
+            visit(mipOffset, mips, layerOffset, layers, image.layout);
+        }
+        return;
+    }
+    for (std::uint32_t layer{layerOffset}; layer < layerOffset + layers; ++layer)
+    {
+        std::uint32_t mip{mipOffset};
+        while (mip < mipOffset + mips)
+        {
+            const vk::ImageLayout oldLayout{GetLayout(image, mip, layer)};
+            std::uint32_t end{mip + 1U};
+            while (end < mipOffset + mips && GetLayout(image, end, layer) == oldLayout)
+            {
+                ++end;
+            }
+            if (oldLayout != newLayout)
+            {
+                visit(mip, end - mip, layer, 1U, oldLayout);
+            }
+            mip = end;
+        }
+    }
+}
+
+[[nodiscard]] constexpr auto AspectFromFormat(const vk::Format format) noexcept -> vk::ImageAspectFlags
+{
+    switch (format)
+    {
+    case vk::Format::eD16Unorm: [[fallthrough]];
+    case vk::Format::eX8D24UnormPack32: [[fallthrough]];
+    case vk::Format::eD32Sfloat: return vk::ImageAspectFlagBits::eDepth;
+    case vk::Format::eS8Uint: return vk::ImageAspectFlagBits::eStencil;
+    case vk::Format::eD16UnormS8Uint: [[fallthrough]];
+    case vk::Format::eD24UnormS8Uint: [[fallthrough]];
+    case vk::Format::eD32SfloatS8Uint: return vk::ImageAspectFlagBits::eDepth | vk::ImageAspectFlagBits::eStencil;
+    default: return vk::ImageAspectFlagBits::eColor;
+    }
+}
+
+struct ImageMemoryRequirements
+{
+    std::uint64_t size{};
+    std::uint64_t alignment{};
+    std::uint32_t memoryTypeBits{};
 };
 
-[[nodiscard]] inline auto Initialize(const Dispatch& dispatch, const Device& device, const PhysicalDevice& physicalDevice, const ImageCreateInfo& createInfo, Image& image) noexcept -> vk_status
+// Creates the image without backing memory. Bind it before creating views or recording commands on it.
+[[nodiscard]] inline auto InitializeUnbound(const Dispatch& dispatch, const Device& device, const ImageCreateInfo& createInfo, Image& image) noexcept -> vk_status
 {
     const vk::ImageCreateInfo imageCI{
         .sType = vk::StructureType::eImageCreateInfo,
@@ -50,29 +172,93 @@ struct Image
         .pQueueFamilyIndices=nullptr,
         .initialLayout=vk::ImageLayout::eUndefined,
     };
-    image.image = device.device.createImage(imageCI, nullptr, dispatch.dispatch);
+    image.image      = device.device.createImage(imageCI, nullptr, dispatch.dispatch);
+    image.allocation = {};
+    image.layout     = imageCI.initialLayout;
+    image.aspect     = AspectFromFormat(imageCI.format);
+    image.width      = createInfo.width;
+    image.height     = createInfo.height;
+    image.mipCount   = std::max(createInfo.mipCount, 1U);
+    image.layerCount = std::max(createInfo.arrayCount, 1U);
+    image.subresourceLayouts.clear();
+
+    return vk_status::ok;
+}
+
+[[nodiscard]] inline auto GetMemoryRequirements(const Dispatch& dispatch, const Device& device, const Image& image) noexcept -> ImageMemoryRequirements
+{
+    const vk::MemoryRequirements memRequirements{device.device.getImageMemoryRequirements(image.image, dispatch.dispatch)};
+    return {
+        .size           = memRequirements.size,
+        .alignment      = memRequirements.alignment,
+        .memoryTypeBits = memRequirements.memoryTypeBits,
+    };
+}
 
-    const vk::MemoryRequirements memRequirements { device.device.getImageMemoryRequirements(image.image, dispatch.dispatch)};
+// Binds memory the image does not own; Cleanup leaves it alone. Several images may share one range as long as their lifetimes do not overlap.
+[[nodiscard]] inline auto Bind(const Dispatch& dispatch, const Device& device, const Image& image, const vk::DeviceMemory memory, const std::uint64_t offset) noexcept -> vk_status
+{
+    const vk::BindImageMemoryInfo bindInfo{
+        .sType        = vk::StructureType::eBindImageMemoryInfo,
+        .pNext        = nullptr,
+        .image        = image.image,
+        .memory       = memory,
+        .memoryOffset = offset,
+    };
+    return FromVkResult(device.device.bindImageMemory2(1U, &bindInfo, dispatch.dispatch));
+}
+
+// Memory comes from the allocator; dedicated when the driver prefers it or the image is large compared to a block.
+[[nodiscard]] inline auto Initialize(const Dispatch& dispatch, const Device& device, Allocator& allocator, const ImageCreateInfo& createInfo, Image& image) noexcept
+    -> vk_status
+{
+    if (const vk_status status{InitializeUnbound(dispatch, device, createInfo, image)}; IsError(status))
+    {
+        return status;
+    }
 
-    const vk::MemoryAllocateInfo allocInfo{
-        .sType           = vk::StructureType::eMemoryAllocateInfo,
-        .pNext           = nullptr,
-        .allocationSize  = memRequirements.size,
-        .memoryTypeIndex = FindMemoryType(physicalDevice, memRequirements.memoryTypeBits, createInfo.memoryProperty),
+    const vk::ImageMemoryRequirementsInfo2 requirementsInfo{
+        .sType = vk::StructureType::eImageMemoryRequirementsInfo2,
+        .pNext = nullptr,
+        .image = image.image,
+    };
+    const auto requirements{device.device.getImageMemoryRequirements2<vk::MemoryRequirements2, vk::MemoryDedicatedRequirements>(requirementsInfo, dispatch.dispatch)};
+    const vk::MemoryRequirements& memRequirements{requirements.get<vk::MemoryRequirements2>().memoryRequirements};
+    const vk::MemoryDedicatedRequirements& dedicated{requirements.get<vk::MemoryDedicatedRequirements>()};
+    const AllocationRequest request{
+        .size           = memRequirements.size,
+        .alignment      = memRequirements.alignment,
+        .memoryTypeBits = memRequirements.memoryTypeBits,
+        .memoryProperty = createInfo.memoryProperty,
+        .memoryUsage    = createInfo.memoryUsage == memory_usage::unknown && (createInfo.usage & static_cast<std::uint32_t>(vk::ImageUsageFlagBits::eTransientAttachment)) != 0U
+                              ? memory_usage::transient
+                              : createInfo.memoryUsage,
+        .isLinear       = static_cast<vk::ImageTiling>(createInfo.tiling) == vk::ImageTiling::eLinear,
+        .isDedicated    = dedicated.requiresDedicatedAllocation || dedicated.prefersDedicatedAllocation,
+        .dedicatedImage = image.image,
     };
-    image.memory = device.device.allocateMemory(allocInfo, nullptr, dispatch.dispatch);
-    device.device.bindImageMemory(image.image, image.memory, 0, dispatch.dispatch);
-    image.layout = imageCI.initialLayout;
+    if (const vk_status status{Allocate(dispatch, device, allocator, request, image.allocation)}; IsError(status)) [[unlikely]]
+    {
+        device.device.destroyImage(image.image, nullptr, dispatch.dispatch);
+        image.image = nullptr;
+        return status;
+    }
+    if (const vk_status status{Bind(dispatch, device, image, image.allocation.memory, image.allocation.offset)}; IsError(status)) [[unlikely]]
+    {
+        device.device.destroyImage(image.image, nullptr, dispatch.dispatch);
+        Free(dispatch, device, allocator, image.allocation);
+        image.image = nullptr;
+        return status;
+    }
 
     return vk_status::ok;
 }
 
-inline auto Cleanup(const Dispatch& dispatch, const Device& device, Image& image) noexcept -> void
+inline auto Cleanup(const Dispatch& dispatch, const Device& device, Allocator& allocator, Image& image) noexcept -> void
 {
-    device.device.freeMemory(image.memory, nullptr, dispatch.dispatch);
     device.device.destroyImage(image.image, nullptr, dispatch.dispatch);
-    image.image  = nullptr;
-    image.memory = nullptr;
+    Free(dispatch, device, allocator, image.allocation);
+    image.image = nullptr;
 }
 
 } // namespace deer_vulkan
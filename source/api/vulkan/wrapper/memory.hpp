@@ -0,0 +1,47 @@
+#pragma once
+#include "../deer_vulkan_core.hpp"
+#include "device.hpp"
+#include "dispatch.hpp"
+#include "physical_device.hpp"
+
+namespace deer_vulkan
+{
+
+// A raw device allocation that resources are bound into, rather than each owning their own.
+struct DeviceMemory
+{
+    vk::DeviceMemory memory{nullptr};
+    std::uint64_t size{};
+    std::uint32_t memoryType{};
+};
+
+[[nodiscard]] inline auto Initialize(const Dispatch& dispatch, const Device& device, const PhysicalDevice& physicalDevice, const std::uint64_t size, const std::uint32_t memoryTypeBits,
+                                     const std::uint32_t memoryProperty, const memory_usage usage, DeviceMemory& memory) noexcept -> vk_status
+{
+    const std::uint32_t memoryType{FindMemoryType(physicalDevice, memoryTypeBits, memoryProperty, usage)};
+    if (memoryType == g_noMemoryType) [[unlikely]]
+    {
+        return vk_status::out_of_device_memory;
+    }
+    const vk::MemoryAllocateInfo allocInfo{
+        .sType           = vk::StructureType::eMemoryAllocateInfo,
+        .pNext           = nullptr,
+        .allocationSize  = size,
+        .memoryTypeIndex = memoryType,
+    };
+    if (const vk_status status{FromVkResult(device.device.allocateMemory(&allocInfo, nullptr, &memory.memory, dispatch.dispatch))}; IsError(status)) [[unlikely]]
+    {
+        return status;
+    }
+    memory.size       = size;
+    memory.memoryType = memoryType;
+    return vk_status::ok;
+}
+
+inline auto Cleanup(const Dispatch& dispatch, const Device& device, DeviceMemory& memory) noexcept -> void
+{
+    device.device.freeMemory(memory.memory, nullptr, dispatch.dispatch);
+    memory.memory = nullptr;
+    memory.size   = 0U;
+}
+} // namespace deer_vulkan
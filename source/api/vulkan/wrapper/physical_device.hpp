@@ -13,9 +13,11 @@ struct PhysicalDevice
     std::uint32_t graphicsQueueFamily{0};
     std::uint32_t computeQueueFamily{0};
     std::uint32_t presentQueueFamily{0};
+    std::uint32_t transferQueueFamily{0};
     std::uint32_t graphicsQueueIdx{0};
     std::uint32_t computeQueueIdx{0};
     std::uint32_t presentQueueIdx{0};
+    std::uint32_t transferQueueIdx{0};
     vk::Format depthFormat{vk::Format::eUndefined};
 
     vk::PhysicalDeviceProperties2 deviceProperties{};
@@ -24,18 +26,72 @@ struct PhysicalDevice
     std::vector<vk::QueueFamilyProperties2> queueFamilyProperties{};
 };
 
-[[nodiscard]] inline auto FindMemoryType(const PhysicalDevice& physicalDevice, const std::uint32_t memoryType, const std::uint32_t memoryProperty) noexcept -> std::uint32_t
+// What memory is for, which decides between the memory types that have the properties asked for. Raw values match fawn_vision::memory_usage.
+enum class memory_usage : std::uint8_t
 {
-    for (std::uint32_t i{}; i < physicalDevice.deviceMemoryProperties.memoryProperties.memoryTypeCount; ++i)
+    unknown    = 0, // the first type with the properties asked for
+    gpu_only   = 1, // only the device touches it: device local, and not host visible while there is plain video memory
+    cpu_only   = 2, // staging the host writes once and the device copies out of: host visible system memory
+    cpu_to_gpu = 3, // rewritten by the host every frame and read by the device: device local and host visible (resizable BAR) when that heap is big enough
+    gpu_to_cpu = 4, // written by the device and read back by the host: host cached
+    transient  = 5, // attachments that never leave the tile: lazily allocated when the device has it
+};
+
+constexpr std::uint32_t g_noMemoryType{~0U};
+constexpr std::uint64_t g_barWindowSize{256ULL << 20U}; // a device local, host visible heap no bigger than this is the fixed BAR window, not resizable BAR
+
+// How well a memory type suits a usage, higher being better; -1 when it cannot be used for it at all. What a usage needs outweighs what it merely
+// prefers. Lazily allocated and protected memory are only used when asked for, lazily allocated memory also by transient usage.
+[[nodiscard]] constexpr auto MemoryTypeScore(const memory_usage usage, const vk::MemoryPropertyFlags flags, const vk::MemoryPropertyFlags requested,
+                                             const std::uint64_t heapSize) noexcept -> std::int32_t
+{
+    const bool isDeviceLocal{static_cast<bool>(flags & vk::MemoryPropertyFlagBits::eDeviceLocal)};
+    const bool isHostVisible{static_cast<bool>(flags & vk::MemoryPropertyFlagBits::eHostVisible)};
+    const bool isHostCoherent{static_cast<bool>(flags & vk::MemoryPropertyFlagBits::eHostCoherent)};
+    const bool isHostCached{static_cast<bool>(flags & vk::MemoryPropertyFlagBits::eHostCached)};
+    const bool isLazy{static_cast<bool>(flags & vk::MemoryPropertyFlagBits::eLazilyAllocated)};
+    const vk::MemoryPropertyFlags unasked{flags & ~requested};
+    if ((unasked & vk::MemoryPropertyFlagBits::eLazilyAllocated && usage != memory_usage::transient) || (unasked & vk::MemoryPropertyFlagBits::eProtected))
+    {
+        return -1;
+    }
+    switch (usage)
+    {
+    case memory_usage::gpu_only: return (isDeviceLocal ? 4 : 0) + (isHostVisible ? 0 : 1);
+    case memory_usage::cpu_only: return isHostVisible ? (isDeviceLocal ? 0 : 4) + (isHostCoherent ? 2 : 0) + (isHostCached ? 0 : 1) : -1;
+    case memory_usage::cpu_to_gpu:
+        // The BAR window is left for whoever asks for it outright; it is too small to put a frame's worth of data in next to everything else.
+        return isHostVisible ? (isDeviceLocal ? (heapSize > g_barWindowSize ? 8 : 0) : 4) + (isHostCoherent ? 2 : 0) + (isHostCached ? 0 : 1) : -1;
+    case memory_usage::gpu_to_cpu: return isHostVisible ? (isHostCached ? 4 : 0) + (isHostCoherent ? 2 : 0) + (isDeviceLocal ? 0 : 1) : -1;
+    case memory_usage::transient: return (isLazy ? 8 : 0) + (isDeviceLocal ? 4 : 0) + (isHostVisible ? 0 : 1);
+    case memory_usage::unknown: [[fallthrough]];
+    default: return 0;
+    }
+}
+
+// The best-scoring of the allowed memory types that has every property asked for; the first of equals. g_noMemoryType when none qualifies.
+[[nodiscard]] inline auto FindMemoryType(const PhysicalDevice& physicalDevice, const std::uint32_t memoryType, const std::uint32_t memoryProperty,
+                                         const memory_usage usage = memory_usage::unknown) noexcept -> std::uint32_t
+{
+    const vk::PhysicalDeviceMemoryProperties& properties{physicalDevice.deviceMemoryProperties.memoryProperties};
+    std::uint32_t best{g_noMemoryType};
+    std::int32_t bestScore{-1};
+    for (std::uint32_t i{}; i < properties.memoryTypeCount; ++i)
     {
-        if ((memoryType & (1 << i))
-            && (static_cast<std::uint32_t>(physicalDevice.deviceMemoryProperties.memoryProperties.memoryTypes[i].propertyFlags) & memoryProperty) == memoryProperty)
+        const vk::MemoryPropertyFlags flags{properties.memoryTypes[i].propertyFlags};
+        if ((memoryType & (1U << i)) == 0U || (static_cast<std::uint32_t>(flags) & memoryProperty) != memoryProperty)
         {
-            return i;
+            continue;
+        }
+        const std::int32_t score{MemoryTypeScore(usage, flags, vk::MemoryPropertyFlags{memoryProperty}, properties.memoryHeaps[properties.memoryTypes[i].heapIndex].size)};
+        if (score > bestScore)
+        {
+            best      = i;
+            bestScore = score;
         }
     }
 
-    return 0;
+    return best;
 }
 
 [[nodiscard]] inline auto FindDepthFormat(const Dispatch& dispatch, const PhysicalDevice& physicalDevice) noexcept -> vk::Format
@@ -63,6 +119,7 @@ struct PhysicalDevice
     std::optional<std::uint32_t> graphicsFamily;
     std::optional<std::uint32_t> presentFamily;
     std::optional<std::uint32_t> computeFamily;
+    std::optional<std::uint32_t> transferFamily;
     std::optional<std::uint32_t> sharedFamily; // supports graphics + present + has queueCount >= 2
 
     for (std::uint32_t i = 0; i < queueFamilies.size(); ++i)
@@ -70,6 +127,7 @@ struct PhysicalDevice
         const auto& family     = queueFamilies[i];
         const bool hasGraphics = static_cast<bool>(family.queueFlags & vk::QueueFlagBits::eGraphics);
         const bool hasCompute  = static_cast<bool>(family.queueFlags & vk::QueueFlagBits::eCompute);
+        const bool hasTransfer = static_cast<bool>(family.queueFlags & vk::QueueFlagBits::eTransfer);
         const bool hasPresent  = SDL_Vulkan_GetPresentationSupport(instance.instance, device, i);
 
         // Prefer a single family that does graphics+present with room for 2 queues
@@ -93,6 +151,12 @@ struct PhysicalDevice
         {
             computeFamily = i;
         }
+
+        // A transfer-only family is the copy engine; uploads on it run next to rendering instead of in between
+        if (hasTransfer && !hasGraphics && !hasCompute && !transferFamily.has_value())
+        {
+            transferFamily = i;
+        }
     }
 
     // Resolve: shared family beats separate graphics+present
@@ -100,11 +164,6 @@ struct PhysicalDevice
     {
         physicalDevice.graphicsQueueFamily = sharedFamily.value();
         physicalDevice.presentQueueFamily  = sharedFamily.value();
-        physicalDevice.computeQueueFamily  = sharedFamily.value();
-
-        physicalDevice.graphicsQueueIdx = 0U;
-        physicalDevice.computeQueueIdx  = 1U;
-        physicalDevice.presentQueueIdx  = 1U;
     }
     else
     {
@@ -126,6 +185,23 @@ struct PhysicalDevice
     // Compute: dedicated family > fallback to graphics family
     physicalDevice.physicalDevice     = device;
     physicalDevice.computeQueueFamily = computeFamily.value_or(physicalDevice.graphicsQueueFamily);
+    // Transfer: dedicated family > fallback to graphics family, where it still gets a queue of its own if the family has one to spare
+    physicalDevice.transferQueueFamily = transferFamily.value_or(physicalDevice.graphicsQueueFamily);
+
+    // Graphics, compute and transfer each take the next free queue of their family; a family that runs out hands out its last queue again.
+    // Presenting from the graphics family reuses the graphics queue.
+    std::vector<std::uint32_t> usedQueues(queueFamilies.size(), 0U);
+    const auto nextQueue = [&usedQueues, &queueFamilies](const std::uint32_t family)
+    {
+        const std::uint32_t index{std::min(usedQueues[family], queueFamilies[family].queueCount - 1U)};
+        usedQueues[family] = index + 1U;
+        return index;
+    };
+    physicalDevice.graphicsQueueIdx = nextQueue(physicalDevice.graphicsQueueFamily);
+    physicalDevice.computeQueueIdx  = nextQueue(physicalDevice.computeQueueFamily);
+    physicalDevice.transferQueueIdx = nextQueue(physicalDevice.transferQueueFamily);
+    physicalDevice.presentQueueIdx =
+        physicalDevice.presentQueueFamily == physicalDevice.graphicsQueueFamily ? physicalDevice.graphicsQueueIdx : nextQueue(physicalDevice.presentQueueFamily);
     physicalDevice.depthFormat        = FindDepthFormat(dispatch, physicalDevice);
     if (physicalDevice.depthFormat == vk::Format::eUndefined)
     {
@@ -139,8 +215,15 @@ struct PhysicalDevice
     return vk_status::ok;
 }
 
+// Also lists the present modes the surface supports, for the swap chain to pick from.
 inline auto GetSurfaceCapabilities(const Dispatch& dispatch, const PhysicalDevice& physicalDevice, Surface& surface) noexcept -> vk_status
 {
-    return FromVkResult(physicalDevice.physicalDevice.getSurfaceCapabilitiesKHR(surface.surface, &surface.capabilities, dispatch.dispatch));
+    if (const vk_status status{FromVkResult(physicalDevice.physicalDevice.getSurfaceCapabilitiesKHR(surface.surface, &surface.capabilities, dispatch.dispatch))};
+        IsError(status))
+    {
+        return status;
+    }
+    surface.presentModes = physicalDevice.physicalDevice.getSurfacePresentModesKHR(surface.surface, dispatch.dispatch);
+    return vk_status::ok;
 }
 } // namespace deer_vulkan
@@ -0,0 +1,86 @@
+#pragma once
+#include "../deer_vulkan_core.hpp"
+
+#include "command.hpp"
+#include "device.hpp"
+#include "dispatch.hpp"
+#include "physical_device.hpp"
+
+namespace deer_vulkan
+{
+
+// A pool of timestamp queries.
+struct QueryPool
+{
+    vk::QueryPool pool{nullptr};
+    std::uint32_t count{};
+};
+
+[[nodiscard]] inline auto Initialize(const Dispatch& dispatch, const Device& device, const std::uint32_t count, QueryPool& queryPool) noexcept -> vk_status
+{
+    const vk::QueryPoolCreateInfo createInfo{
+        .sType              = vk::StructureType::eQueryPoolCreateInfo,
+        .pNext              = nullptr,
+        .flags              = {},
+        .queryType          = vk::QueryType::eTimestamp,
+        .queryCount         = count,
+        .pipelineStatistics = {},
+    };
+
+    if (const vk_status status{FromVkResult(device.device.createQueryPool(&createInfo, nullptr, &queryPool.pool, dispatch.dispatch))}; IsError(status)) [[unlikely]]
+    {
+        queryPool = {};
+        return status;
+    }
+    queryPool.count = count;
+    return vk_status::ok;
+}
+
+inline auto Cleanup(const Dispatch& dispatch, const Device& device, QueryPool& queryPool) noexcept -> void
+{
+    if (queryPool.pool == nullptr)
+    {
+        return;
+    }
+    device.device.destroyQueryPool(queryPool.pool, nullptr, dispatch.dispatch);
+    queryPool.pool  = nullptr;
+    queryPool.count = 0U;
+}
+
+// Must be recorded outside a rendering scope, before the queries are written again.
+inline void ResetQueries(const Dispatch& dispatch, const CommandBuffer& commandBuffer, const QueryPool& queryPool, const std::uint32_t first, const std::uint32_t count) noexcept
+{
+    commandBuffer.commandBuffer.front().resetQueryPool(queryPool.pool, first, count, dispatch.dispatch);
+}
+
+// stage is a raw VkPipelineStageFlags2 value: the timestamp is taken once every earlier command has gone past it.
+inline void WriteTimestamp(const Dispatch& dispatch, const CommandBuffer& commandBuffer, const QueryPool& queryPool, const std::uint64_t stage, const std::uint32_t query) noexcept
+{
+    commandBuffer.commandBuffer.front().writeTimestamp2(static_cast<vk::PipelineStageFlags2>(stage), queryPool.pool, query, dispatch.dispatch);
+}
+
+// Reads [first, first + count) without waiting. Every query takes two values: the timestamp, then a non-zero availability word once it was written.
+[[nodiscard]] inline auto GetTimestamps(const Dispatch& dispatch, const Device& device, const QueryPool& queryPool, const std::uint32_t first, const std::uint32_t count,
+                                        std::span<std::uint64_t> results) noexcept -> vk_status
+{
+    constexpr std::uint64_t stride{2U * sizeof(std::uint64_t)};
+    if (results.size() < 2U * count)
+    {
+        return vk_status::incomplete;
+    }
+    return FromVkResult(device.device.getQueryPoolResults(queryPool.pool, first, count, count * stride, results.data(), stride,
+                                                          vk::QueryResultFlagBits::e64 | vk::QueryResultFlagBits::eWithAvailability, dispatch.dispatch));
+}
+
+// Nanoseconds per timestamp tick.
+[[nodiscard]] inline auto TimestampPeriod(const PhysicalDevice& physicalDevice) noexcept -> float
+{
+    return physicalDevice.deviceProperties.properties.limits.timestampPeriod;
+}
+
+// Bits a timestamp written on the family actually has; 0 means the family cannot write timestamps.
+[[nodiscard]] inline auto TimestampValidBits(const PhysicalDevice& physicalDevice, const std::uint32_t family) noexcept -> std::uint32_t
+{
+    return family < physicalDevice.queueFamilyProperties.size() ? physicalDevice.queueFamilyProperties[family].queueFamilyProperties.timestampValidBits : 0U;
+}
+} // namespace deer_vulkan
@@ -16,6 +16,14 @@ struct Queue
     std::uint32_t familyIndex{};
 };
 
+// One semaphore wait or signal of a submit. value is ignored for binary semaphores.
+struct SemaphoreSubmit
+{
+    const Semaphore* semaphore{nullptr};
+    std::uint64_t value{};
+    std::uint64_t stageMask{static_cast<std::uint64_t>(vk::PipelineStageFlagBits2::eAllCommands)};
+};
+
 [[nodiscard]] inline auto Initialize(const Dispatch& dispatch, const Device& device, const std::uint32_t familyIdx, const std::uint32_t queueIdx, Queue& queue) noexcept
     -> vk_status
 {
@@ -42,7 +50,8 @@ inline auto WaitIdle(const Dispatch& dispatch, const Queue& queue) noexcept -> v
     queue.queue.waitIdle(dispatch.dispatch);
 }
 
-[[nodiscard]] inline auto Present(const Dispatch& dispatch, const Queue& queue, const SwapChain& swapchain, const Semaphore& waitSemaphore) noexcept -> vk_status
+[[nodiscard]] inline auto Present(const Dispatch& dispatch, const Queue& queue, const SwapChain& swapchain, const std::uint32_t imageIndex, const Semaphore& waitSemaphore) noexcept
+    -> vk_status
 {
     const vk::PresentInfoKHR presentInfo{
         .sType              = vk::StructureType::ePresentInfoKHR,
@@ -51,13 +60,18 @@ inline auto WaitIdle(const Dispatch& dispatch, const Queue& queue) noexcept -> v
         .pWaitSemaphores    = &waitSemaphore.semaphore,
         .swapchainCount     = 1,
         .pSwapchains        = &swapchain.swapChain,
-        .pImageIndices      = &swapchain.currentFrameIdx,
+        .pImageIndices      = &imageIndex,
         .pResults           = nullptr,
     };
 
     return FromVkResult(queue.queue.presentKHR(presentInfo, dispatch.dispatch));
 }
 
+[[nodiscard]] inline auto Present(const Dispatch& dispatch, const Queue& queue, const SwapChain& swapchain, const Semaphore& waitSemaphore) noexcept -> vk_status
+{
+    return Present(dispatch, queue, swapchain, swapchain.currentFrameIdx, waitSemaphore);
+}
+
 [[nodiscard]] inline auto QueueSubmit(const Dispatch& dispatch, const Queue& queue, const CommandBuffer& commandBuffer, const Semaphore* pSemaphore = nullptr,
                                       const std::optional<uint64_t> waitValue = std::nullopt, const std::optional<uint64_t> signalValue = std::nullopt) noexcept -> vk_status
 {
@@ -101,4 +115,76 @@ inline auto WaitIdle(const Dispatch& dispatch, const Queue& queue) noexcept -> v
     };
     return FromVkResult(queue.queue.submit2(1U, &submitInfo, nullptr, dispatch.dispatch));
 }
+
+// Submits the command buffers in order. The waits apply before the first one and the signals after the last one; above a chunk's worth of command buffers
+// the work goes out as several submits, which still signal only once everything before them in submission order has completed.
+[[nodiscard]] inline auto QueueSubmit(const Dispatch& dispatch, const Queue& queue, const std::span<const CommandBuffer* const> commandBuffers,
+                                      const std::span<const SemaphoreSubmit> waits, const std::span<const SemaphoreSubmit> signals) noexcept -> vk_status
+{
+    constexpr std::size_t maxSemaphores{8U};
+    if (waits.size() > maxSemaphores || signals.size() > maxSemaphores)
+    {
+        return vk_status::too_many_objects;
+    }
+
+    const auto toSubmitInfo = [](const SemaphoreSubmit& submit) {
+        return vk::SemaphoreSubmitInfo{
+            .sType       = vk::StructureType::eSemaphoreSubmitInfo,
+            .pNext       = nullptr,
+            .semaphore   = submit.semaphore->semaphore,
+            .value       = submit.semaphore->isTimeline ? submit.value : 0U,
+            .stageMask   = static_cast<vk::PipelineStageFlags2>(submit.stageMask),
+            .deviceIndex = 0,
+        };
+    };
+
+    std::array<vk::SemaphoreSubmitInfo, maxSemaphores> waitInfos{};
+    std::array<vk::SemaphoreSubmitInfo, maxSemaphores> signalInfos{};
+    std::ranges::transform(waits, waitInfos.begin(), toSubmitInfo);
+    std::ranges::transform(signals, signalInfos.begin(), toSubmitInfo);
+
+    constexpr std::size_t chunkSize{32U};
+    std::array<vk::CommandBufferSubmitInfo, chunkSize> commandBufferInfos{};
+    std::size_t first{};
+    do
+    {
+        const std::size_t count{std::min(chunkSize, commandBuffers.size() - first)};
+        for (std::size_t i{}; i < count; ++i)
+        {
+            commandBufferInfos[i] = vk::CommandBufferSubmitInfo{
+                .sType         = vk::StructureType::eCommandBufferSubmitInfo,
+                .pNext         = nullptr,
+                .commandBuffer = commandBuffers[first + i]->commandBuffer.front(),
+                .deviceMask    = 0,
+            };
+        }
+
+        const bool isFirst{first == 0U};
+        const bool isLast{first + count == commandBuffers.size()};
+        const vk::SubmitInfo2 submitInfo{
+            .sType                    = vk::StructureType::eSubmitInfo2,
+            .pNext                    = nullptr,
+            .flags                    = {},
+            .waitSemaphoreInfoCount   = isFirst ? static_cast<std::uint32_t>(waits.size()) : 0U,
+            .pWaitSemaphoreInfos      = waitInfos.data(),
+            .commandBufferInfoCount   = static_cast<std::uint32_t>(count),
+            .pCommandBufferInfos      = commandBufferInfos.data(),
+            .signalSemaphoreInfoCount = isLast ? static_cast<std::uint32_t>(signals.size()) : 0U,
+            .pSignalSemaphoreInfos    = signalInfos.data(),
+        };
+        if (const vk_status status{FromVkResult(queue.queue.submit2(1U, &submitInfo, nullptr, dispatch.dispatch))}; IsError(status)) [[unlikely]]
+        {
+            return status;
+        }
+        first += count;
+    } while (first < commandBuffers.size());
+    return vk_status::ok;
+}
+
+[[nodiscard]] inline auto QueueSubmit(const Dispatch& dispatch, const Queue& queue, const CommandBuffer& commandBuffer, const std::span<const SemaphoreSubmit> waits,
+                                      const std::span<const SemaphoreSubmit> signals) noexcept -> vk_status
+{
+    const CommandBuffer* pCommandBuffer{&commandBuffer};
+    return QueueSubmit(dispatch, queue, std::span{&pCommandBuffer, 1U}, waits, signals);
+}
 } // namespace deer_vulkan
@@ -53,6 +53,21 @@ inline auto Cleanup(const Dispatch& dispatch, const Device& device, const Semaph
     return FromVkResult(device.device.waitSemaphores(semaphoreWaitInfo, ~0ULL, dispatch.dispatch));
 }
 
+[[nodiscard]] inline auto Wait(const Dispatch& dispatch, const Device& device, const Semaphore& semaphore, const std::uint64_t value, const std::uint64_t timeout = ~0ULL) noexcept
+    -> vk_status
+{
+    const vk::SemaphoreWaitInfo semaphoreWaitInfo{
+        .sType          = vk::StructureType::eSemaphoreWaitInfo,
+        .pNext          = nullptr,
+        .flags          = {},
+        .semaphoreCount = 1,
+        .pSemaphores    = &semaphore.semaphore,
+        .pValues        = &value,
+    };
+
+    return FromVkResult(device.device.waitSemaphores(semaphoreWaitInfo, timeout, dispatch.dispatch));
+}
+
 [[nodiscard]] inline auto Signal(const Dispatch& dispatch, const Device& device, const Semaphore& semaphore, const std::uint64_t value) noexcept -> vk_status
 {
     const vk::SemaphoreSignalInfo semaphoreSignalInfo{
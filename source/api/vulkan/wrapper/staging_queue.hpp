@@ -0,0 +1,354 @@
+#pragma once
+#include "../deer_vulkan_core.hpp"
+#include "allocator.hpp"
+#include "buffer.hpp"
+#include "command.hpp"
+#include "device.hpp"
+#include "dispatch.hpp"
+#include "image.hpp"
+#include "semaphore.hpp"
+
+namespace deer_vulkan
+{
+constexpr std::uint32_t g_stagingBatchCount{4U}; // batches that can be on the device at once
+constexpr std::uint64_t g_stagingAlignment{16U}; // of every staged range; a multiple of the texel size of every format up to 16 bytes per texel
+
+// One copy out of staging memory: into [dstOffset, dstOffset + size) of a buffer, or into mip 0 of every layer of an image.
+struct StagingCopy
+{
+    Buffer* pBuffer{nullptr};
+    Image* pImage{nullptr};
+    Buffer overflow{}; // staging memory of its own, for data the ring had no room for; freed once the copy completed
+    std::uint64_t srcOffset{};
+    std::uint64_t dstOffset{};
+    std::uint64_t size{};
+    std::uint32_t width{};
+    std::uint32_t height{};
+    std::uint32_t depth{};
+    std::uint32_t finalLayout{}; // raw VkImageLayout the image ends up in
+    bool generateMips{};         // blits the mips below mip 0, on the graphics queue
+};
+
+// Copies that go out together. transfer does the copies on the transfer queue; graphics takes the results over on the graphics family and does
+// what only a graphics queue can: mip generation and the final layouts.
+struct StagingBatch
+{
+    CommandBuffer transfer{};
+    CommandBuffer graphics{};
+    std::vector<StagingCopy> copies{};
+    std::uint64_t stagingEnd{}; // the ring is free up to here once the copies completed
+};
+
+// A host visible ring that loading threads copy their data into, and the batches that move it to where it belongs. Batch n signals value n on both
+// timelines: transferTimeline once its copies are done, timeline once the graphics family took them over. Every copy staged before batch n went out is
+// part of it, so that value is the copy's ticket.
+struct StagingQueue
+{
+    std::mutex mutex{}; // guards the ring, pending, submittedValue and copiedValue; the batches are only touched by the thread that submits them
+    Buffer buffer{};
+    std::uint64_t head{}; // bytes ever reserved; the ring position is head % buffer.size
+    std::uint64_t tail{}; // bytes ever released
+    std::vector<StagingCopy> pending{};
+    std::array<StagingBatch, g_stagingBatchCount> batches{};
+    CommandPool transferPool{};
+    CommandPool graphicsPool{};
+    Semaphore transferTimeline{};
+    Semaphore timeline{};
+    std::uint64_t submittedValue{};            // last batch whose copies were submitted
+    std::uint64_t copiedValue{};               // last batch whose copies completed and whose staging memory was released
+    std::atomic<std::uint64_t> readyValue{};   // last batch whose graphics part was submitted; whatever is submitted later sees its results
+    std::uint64_t completedValue{};            // last batch the device finished altogether; its command buffers can be recorded again
+    std::uint64_t waitedValue{};               // last ready value a frame waited for
+    std::uint32_t transferFamily{};
+    std::uint32_t graphicsFamily{};
+};
+
+[[nodiscard]] inline auto Batch(StagingQueue& staging, const std::uint64_t value) noexcept -> StagingBatch&
+{
+    return staging.batches[(value - 1U) % g_stagingBatchCount];
+}
+
+[[nodiscard]] inline auto HasOwnershipTransfer(const StagingQueue& staging) noexcept -> bool
+{
+    return staging.transferFamily != staging.graphicsFamily;
+}
+
+[[nodiscard]] inline auto Initialize(const Dispatch& dispatch, const Device& device, Allocator& allocator, const std::uint64_t size, const std::uint32_t transferFamily,
+                                     const std::uint32_t graphicsFamily, StagingQueue& staging) noexcept -> vk_status
+{
+    staging.transferFamily = transferFamily;
+    staging.graphicsFamily = graphicsFamily;
+    const BufferCreateInfo createInfo{
+        .size           = AlignUp(size, g_stagingAlignment),
+        .usage          = static_cast<std::uint32_t>(vk::BufferUsageFlagBits::eTransferSrc),
+        .memoryProperty = static_cast<std::uint32_t>(vk::MemoryPropertyFlagBits::eHostVisible),
+        .memoryUsage    = memory_usage::cpu_only, // only copied from, so it stays out of the BAR window
+    };
+    if (const vk_status status{Initialize(dispatch, device, allocator, createInfo, staging.buffer)}; IsError(status)) [[unlikely]]
+    {
+        return status;
+    }
+    if (const vk_status status{Initialize(dispatch, device, transferFamily, staging.transferPool)}; IsError(status)) [[unlikely]]
+    {
+        return status;
+    }
+    if (const vk_status status{Initialize(dispatch, device, graphicsFamily, staging.graphicsPool)}; IsError(status)) [[unlikely]]
+    {
+        return status;
+    }
+    for (StagingBatch& batch : staging.batches)
+    {
+        if (const vk_status status{CreateCommandBuffer(dispatch, device, staging.transferPool, 1U, batch.transfer)}; IsError(status)) [[unlikely]]
+        {
+            return status;
+        }
+        if (const vk_status status{CreateCommandBuffer(dispatch, device, staging.graphicsPool, 1U, batch.graphics)}; IsError(status)) [[unlikely]]
+        {
+            return status;
+        }
+    }
+    if (const vk_status status{Initialize(dispatch, device, /*isTimeline=*/true, staging.transferTimeline)}; IsError(status)) [[unlikely]]
+    {
+        return status;
+    }
+    return Initialize(dispatch, device, /*isTimeline=*/true, staging.timeline);
+}
+
+// The device has to be done with every batch.
+inline auto Cleanup(const Dispatch& dispatch, const Device& device, Allocator& allocator, StagingQueue& staging) noexcept -> void
+{
+    for (StagingBatch& batch : staging.batches)
+    {
+        for (StagingCopy& copy : batch.copies)
+        {
+            Cleanup(dispatch, device, allocator, copy.overflow);
+        }
+        batch.copies.clear();
+        Cleanup(dispatch, device, staging.transferPool, batch.transfer);
+        Cleanup(dispatch, device, staging.graphicsPool, batch.graphics);
+    }
+    for (StagingCopy& copy : staging.pending)
+    {
+        Cleanup(dispatch, device, allocator, copy.overflow);
+    }
+    staging.pending.clear();
+    Cleanup(dispatch, device, staging.transferPool);
+    Cleanup(dispatch, device, staging.graphicsPool);
+    Cleanup(dispatch, device, staging.transferTimeline);
+    Cleanup(dispatch, device, staging.timeline);
+    Cleanup(dispatch, device, allocator, staging.buffer);
+    staging.transferPool     = {};
+    staging.graphicsPool     = {};
+    staging.transferTimeline = {};
+    staging.timeline         = {};
+    staging.head             = 0U;
+    staging.tail             = 0U;
+    staging.submittedValue   = 0U;
+    staging.copiedValue      = 0U;
+    staging.readyValue.store(0U, std::memory_order_relaxed);
+    staging.completedValue = 0U;
+    staging.waitedValue    = 0U;
+}
+
+// Copies data into the ring, or into staging memory of its own when the ring is full, and queues copy for the next batch. Never waits for the device,
+// so loading threads keep going however far the uploads are behind. Safe to call from any thread; value is the ticket of the copy.
+[[nodiscard]] inline auto Stage(const Dispatch& dispatch, const Device& device, Allocator& allocator, StagingQueue& staging, const std::span<const std::byte> data,
+                                StagingCopy copy, std::uint64_t& value) noexcept -> vk_status
+{
+    const std::uint64_t size{AlignUp(data.size(), g_stagingAlignment)};
+    const std::uint64_t capacity{staging.buffer.size};
+
+    const std::scoped_lock lock{staging.mutex};
+    const std::uint64_t position{staging.head % capacity};
+    const std::uint64_t skipped{position + size > capacity ? capacity - position : 0U}; // a range never wraps around the end of the ring
+    const Buffer* pSource{&staging.buffer};
+    if (staging.head + skipped + size - staging.tail <= capacity)
+    {
+        staging.head += skipped;
+        copy.srcOffset = staging.head % capacity;
+        staging.head += size;
+    }
+    else
+    {
+        const BufferCreateInfo createInfo{
+            .size           = size,
+            .usage          = static_cast<std::uint32_t>(vk::BufferUsageFlagBits::eTransferSrc),
+            .memoryProperty = static_cast<std::uint32_t>(vk::MemoryPropertyFlagBits::eHostVisible),
+            .memoryUsage    = memory_usage::cpu_only,
+        };
+        if (const vk_status status{Initialize(dispatch, device, allocator, createInfo, copy.overflow)}; IsError(status)) [[unlikely]]
+        {
+            return status;
+        }
+        copy.srcOffset = 0U;
+        pSource        = &copy.overflow;
+    }
+    std::memcpy(pSource->allocation.pMapped + copy.srcOffset, data.data(), data.size());
+    Flush(dispatch, device, pSource->allocation, copy.srcOffset, data.size());
+
+    copy.size = data.size();
+    staging.pending.emplace_back(std::move(copy));
+    value = staging.submittedValue + 1U;
+    return vk_status::ok;
+}
+
+// Catches up with the device: releases the staging memory of batches whose copies completed and frees up batches it finished altogether.
+[[nodiscard]] inline auto Reclaim(const Dispatch& dispatch, const Device& device, Allocator& allocator, StagingQueue& staging) noexcept -> vk_status
+{
+    // A batch completes only after its copies, so reading completion first never sees it ahead of the copies. One submit may signal both
+    // when the transfer queue is the graphics queue, and the host can observe the two signals in either order.
+    std::uint64_t completedValue{};
+    std::uint64_t copiedValue{};
+    if (const vk_status status{GetValue(dispatch, device, staging.timeline, completedValue)}; IsError(status)) [[unlikely]]
+    {
+        return status;
+    }
+    if (const vk_status status{GetValue(dispatch, device, staging.transferTimeline, copiedValue)}; IsError(status)) [[unlikely]]
+    {
+        return status;
+    }
+
+    const std::scoped_lock lock{staging.mutex};
+    for (; staging.copiedValue < copiedValue; ++staging.copiedValue)
+    {
+        StagingBatch& batch{Batch(staging, staging.copiedValue + 1U)};
+        staging.tail = batch.stagingEnd;
+        for (StagingCopy& copy : batch.copies)
+        {
+            Cleanup(dispatch, device, allocator, copy.overflow);
+        }
+    }
+    staging.completedValue = std::min(completedValue, staging.copiedValue);
+    return vk_status::ok;
+}
+
+// Moves every pending copy into the next batch and records its transfer part: the copies, then the release of what they wrote to the graphics family.
+// nullptr when nothing is pending or every batch is still on the device; the copies then wait for a later call.
+[[nodiscard]] inline auto BeginTransferBatch(const Dispatch& dispatch, StagingQueue& staging, std::uint64_t& value) noexcept -> StagingBatch*
+{
+    const std::scoped_lock lock{staging.mutex};
+    if (staging.pending.empty() || staging.submittedValue - staging.completedValue == g_stagingBatchCount)
+    {
+        return nullptr;
+    }
+    value = staging.submittedValue + 1U;
+    StagingBatch& batch{Batch(staging, value)};
+    batch.copies.clear();
+    batch.copies.swap(staging.pending);
+    batch.stagingEnd       = staging.head;
+    staging.submittedValue = value;
+
+    constexpr auto transferDst{static_cast<std::uint32_t>(vk::ImageLayout::eTransferDstOptimal)};
+    const CommandBuffer& commandBuffer{batch.transfer};
+    BeginSingleCommand(dispatch, commandBuffer);
+    BarrierBatch barriers{};
+    for (const StagingCopy& copy : batch.copies)
+    {
+        if (copy.pImage != nullptr)
+        {
+            AddTransition(dispatch, commandBuffer, barriers, *copy.pImage, transferDst);
+        }
+    }
+    FlushBarriers(dispatch, commandBuffer, barriers);
+    for (const StagingCopy& copy : batch.copies)
+    {
+        const Buffer& source{copy.overflow.buffer != nullptr ? copy.overflow : staging.buffer};
+        if (copy.pImage != nullptr)
+        {
+            CopyToImage(dispatch, commandBuffer, source, copy.srcOffset, *copy.pImage, copy.width, copy.height, copy.depth);
+        }
+        else
+        {
+            CopyBuffers(dispatch, commandBuffer, source, *copy.pBuffer, copy.size, copy.srcOffset, copy.dstOffset);
+        }
+    }
+    if (HasOwnershipTransfer(staging))
+    {
+        for (const StagingCopy& copy : batch.copies)
+        {
+            if (copy.pImage != nullptr)
+            {
+                AddBarrier(dispatch, commandBuffer, barriers,
+                           ImageBarrier{.image          = copy.pImage,
+                                        .srcStage       = static_cast<std::uint64_t>(vk::PipelineStageFlagBits2::eAllTransfer),
+                                        .srcAccess      = static_cast<std::uint64_t>(vk::AccessFlagBits2::eTransferWrite),
+                                        .oldLayout      = transferDst,
+                                        .newLayout      = transferDst,
+                                        .srcQueueFamily = staging.transferFamily,
+                                        .dstQueueFamily = staging.graphicsFamily});
+            }
+            else
+            {
+                AddBarrier(dispatch, commandBuffer, barriers,
+                           BufferBarrier{.buffer         = copy.pBuffer,
+                                         .srcStage       = static_cast<std::uint64_t>(vk::PipelineStageFlagBits2::eAllTransfer),
+                                         .srcAccess      = static_cast<std::uint64_t>(vk::AccessFlagBits2::eTransferWrite),
+                                         .srcQueueFamily = staging.transferFamily,
+                                         .dstQueueFamily = staging.graphicsFamily});
+            }
+        }
+        FlushBarriers(dispatch, commandBuffer, barriers);
+    }
+    EndCommand(dispatch, commandBuffer);
+    return &batch;
+}
+
+// Records the graphics part of batch value: acquiring what the transfer part released, then mips and final layouts. The batch's copies must have been
+// submitted, and must have completed unless both parts go to the same queue. Afterwards, whatever is submitted behind the graphics part may use them.
+[[nodiscard]] inline auto RecordGraphicsPart(const Dispatch& dispatch, StagingQueue& staging, const std::uint64_t value) noexcept -> StagingBatch&
+{
+    StagingBatch& batch{Batch(staging, value)};
+    const CommandBuffer& commandBuffer{batch.graphics};
+    const bool isOwnershipTransfer{HasOwnershipTransfer(staging)};
+    const std::uint32_t srcFamily{isOwnershipTransfer ? staging.transferFamily : vk::QueueFamilyIgnored};
+    const std::uint32_t dstFamily{isOwnershipTransfer ? staging.graphicsFamily : vk::QueueFamilyIgnored};
+    constexpr auto transferDst{static_cast<std::uint32_t>(vk::ImageLayout::eTransferDstOptimal)};
+    BeginSingleCommand(dispatch, commandBuffer);
+    BarrierBatch barriers{};
+    for (const StagingCopy& copy : batch.copies)
+    {
+        if (copy.pBuffer != nullptr)
+        {
+            // Also orders the copies against later reads when they ran on this very queue.
+            AddBarrier(dispatch, commandBuffer, barriers,
+                       BufferBarrier{.buffer         = copy.pBuffer,
+                                     .srcStage       = isOwnershipTransfer ? 0U : static_cast<std::uint64_t>(vk::PipelineStageFlagBits2::eAllTransfer),
+                                     .srcAccess      = isOwnershipTransfer ? 0U : static_cast<std::uint64_t>(vk::AccessFlagBits2::eTransferWrite),
+                                     .dstStage       = static_cast<std::uint64_t>(vk::PipelineStageFlagBits2::eAllCommands),
+                                     .dstAccess      = static_cast<std::uint64_t>(vk::AccessFlagBits2::eMemoryRead),
+                                     .srcQueueFamily = srcFamily,
+                                     .dstQueueFamily = dstFamily});
+        }
+        else if (isOwnershipTransfer)
+        {
+            AddBarrier(dispatch, commandBuffer, barriers,
+                       ImageBarrier{.image          = copy.pImage,
+                                    .dstStage       = static_cast<std::uint64_t>(vk::PipelineStageFlagBits2::eAllTransfer),
+                                    .dstAccess      = static_cast<std::uint64_t>(vk::AccessFlagBits2::eTransferRead | vk::AccessFlagBits2::eTransferWrite),
+                                    .oldLayout      = transferDst,
+                                    .newLayout      = transferDst,
+                                    .srcQueueFamily = srcFamily,
+                                    .dstQueueFamily = dstFamily});
+        }
+    }
+    FlushBarriers(dispatch, commandBuffer, barriers);
+    for (const StagingCopy& copy : batch.copies)
+    {
+        if (copy.pImage == nullptr)
+        {
+            continue;
+        }
+        if (copy.generateMips && copy.pImage->mipCount > 1U)
+        {
+            static_cast<void>(GenerateMips(dispatch, commandBuffer, *copy.pImage, copy.width, copy.height, copy.pImage->mipCount, copy.finalLayout));
+        }
+        else
+        {
+            AddTransition(dispatch, commandBuffer, barriers, *copy.pImage, copy.finalLayout);
+        }
+    }
+    FlushBarriers(dispatch, commandBuffer, barriers);
+    EndCommand(dispatch, commandBuffer);
+    return batch;
+}
+} // namespace deer_vulkan
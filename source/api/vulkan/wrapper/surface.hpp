@@ -8,6 +8,7 @@ struct Surface
 {
     vk::SurfaceKHR surface{nullptr};
     vk::SurfaceCapabilitiesKHR capabilities{};
+    std::vector<vk::PresentModeKHR> presentModes{};
 };
 
 [[nodiscard]] inline auto Initialize(SDL_Window* pWindow, const Instance& instance, Surface& surface) noexcept -> vk_status
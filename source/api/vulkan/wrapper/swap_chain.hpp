@@ -9,6 +9,14 @@
 namespace deer_vulkan
 {
 
+// What a swap chain asks for. presentMode is a raw VkPresentModeKHR value; imageCount 0 asks for one image more than the surface minimum,
+// so the GPU has one to render to while another waits for vblank. Both are bent to what the surface supports.
+struct SwapChainSettings
+{
+    std::uint32_t presentMode{static_cast<std::uint32_t>(vk::PresentModeKHR::eFifo)};
+    std::uint32_t imageCount{};
+};
+
 struct SwapChain
 {
     std::vector<Image> images{};
@@ -17,8 +25,32 @@ struct SwapChain
     vk::Format imageFormat{vk::Format::eB8G8R8A8Srgb};
     vk::Extent2D extent{};
     std::uint32_t currentFrameIdx{};
+    SwapChainSettings settings{};                              // kept across Recreate
+    vk::PresentModeKHR presentMode{vk::PresentModeKHR::eFifo}; // what settings.presentMode got
 };
 
+// The requested mode if the surface has it. Otherwise immediate falls back to mailbox, so it still does not wait for vblank,
+// and everything ends at FIFO, the one mode every surface supports.
+[[nodiscard]] inline auto ChoosePresentMode(const Surface& surface, const vk::PresentModeKHR requested) noexcept -> vk::PresentModeKHR
+{
+    if (std::ranges::contains(surface.presentModes, requested))
+    {
+        return requested;
+    }
+    if (requested == vk::PresentModeKHR::eImmediate && std::ranges::contains(surface.presentModes, vk::PresentModeKHR::eMailbox))
+    {
+        return vk::PresentModeKHR::eMailbox;
+    }
+    return vk::PresentModeKHR::eFifo;
+}
+
+[[nodiscard]] inline auto ChooseImageCount(const Surface& surface, const std::uint32_t requested) noexcept -> std::uint32_t
+{
+    const vk::SurfaceCapabilitiesKHR& capabilities{surface.capabilities};
+    const std::uint32_t maxCount{capabilities.maxImageCount == 0U ? ~0U : capabilities.maxImageCount}; // 0: no limit
+    return std::clamp(requested == 0U ? capabilities.minImageCount + 1U : requested, capabilities.minImageCount, maxCount);
+}
+
 [[nodiscard]] inline auto Initialize(const Dispatch& dispatch, const Device& device, const Surface& surface, const std::int32_t width, const std::int32_t height,
                                      SwapChain& swapChain) noexcept -> vk_status
 {
@@ -33,12 +65,13 @@ struct SwapChain
     }
 
     constexpr auto imageFormat{vk::Format::eB8G8R8A8Srgb};
+    swapChain.presentMode = ChoosePresentMode(surface, static_cast<vk::PresentModeKHR>(swapChain.settings.presentMode));
     const vk::SwapchainCreateInfoKHR swapchainCI{
         .sType                 = vk::StructureType::eSwapchainCreateInfoKHR,
         .pNext                 = nullptr,
         .flags                 = {},
         .surface               = surface.surface,
-        .minImageCount         = surface.capabilities.minImageCount,
+        .minImageCount         = ChooseImageCount(surface, swapChain.settings.imageCount),
         .imageFormat           = imageFormat,
         .imageColorSpace       = vk::ColorSpaceKHR::eSrgbNonlinear,
         .imageExtent           = swapChainExtent,
@@ -49,7 +82,7 @@ struct SwapChain
         .pQueueFamilyIndices   = nullptr,
         .preTransform          = surface.capabilities.currentTransform,
         .compositeAlpha        = vk::CompositeAlphaFlagBitsKHR::eOpaque,
-        .presentMode           = vk::PresentModeKHR::eFifo,
+        .presentMode           = swapChain.presentMode,
         .clipped               = vk::True,
         .oldSwapchain          = swapChain.swapChain,
     };
@@ -72,7 +105,9 @@ struct SwapChain
     swapChain.imageViews.resize(imageCount);
     for (std::uint32_t i = 0; i < imageCount; i++)
     {
-        swapChain.images[i].image = images[i];
+        swapChain.images[i].image  = images[i];
+        swapChain.images[i].width  = swapChain.extent.width;
+        swapChain.images[i].height = swapChain.extent.height;
         if (const vk_status status{Initialize(dispatch, device, swapChain.images[i], viewCI, swapChain.imageViews[i])}; IsError(status))
         {
             return status;
@@ -113,7 +148,9 @@ inline auto Cleanup(const Dispatch& dispatch, const Device& device, SwapChain& s
     device.device.destroySwapchainKHR(swapChain.swapChain, nullptr, dispatch.dispatch);
 }
 
-[[nodiscard]] inline auto NextImage(const Dispatch& dispatch, const Device& device, SwapChain& swapChain, const Semaphore& semaphore) noexcept -> vk_status
+// Leaves swapChain alone, so another thread can acquire while the current image is still being recorded to.
+[[nodiscard]] inline auto NextImage(const Dispatch& dispatch, const Device& device, const SwapChain& swapChain, const Semaphore& semaphore, std::uint32_t& imageIndex) noexcept
+    -> vk_status
 {
     const vk::AcquireNextImageInfoKHR acquireInfo{.sType      = vk::StructureType::eAcquireNextImageInfoKHR,
                                                   .pNext      = nullptr,
@@ -122,7 +159,12 @@ inline auto Cleanup(const Dispatch& dispatch, const Device& device, SwapChain& s
                                                   .semaphore  = semaphore.semaphore,
                                                   .fence      = nullptr,
                                                   .deviceMask = 1U};
-    return FromVkResult(device.device.acquireNextImage2KHR(&acquireInfo, &swapChain.currentFrameIdx, dispatch.dispatch));
+    return FromVkResult(device.device.acquireNextImage2KHR(&acquireInfo, &imageIndex, dispatch.dispatch));
+}
+
+[[nodiscard]] inline auto NextImage(const Dispatch& dispatch, const Device& device, SwapChain& swapChain, const Semaphore& semaphore) noexcept -> vk_status
+{
+    return NextImage(dispatch, device, swapChain, semaphore, swapChain.currentFrameIdx);
 }
 
 [[nodiscard]] constexpr auto CurrentImage(const SwapChain& swapChain) noexcept -> const Image&
@@ -0,0 +1,88 @@
+#pragma once
+#include "../deer_vulkan_core.hpp"
+#include "allocator.hpp"
+#include "buffer.hpp"
+#include "device.hpp"
+#include "dispatch.hpp"
+#include "physical_device.hpp"
+
+namespace deer_vulkan
+{
+// One persistently mapped buffer split in a partition per frame in flight. Data that only lives for a frame is bumped into the current
+// partition, which is handed out again once the frame that used it last completed. Vertex, index, uniform and storage data can all come from it.
+struct UploadRing
+{
+    Buffer buffer{};
+    std::uint64_t partitionSize{};
+    std::uint64_t alignment{16U}; // of every allocation; covers dynamic uniform and storage offsets as well as vertex data
+    std::uint32_t partition{};
+    std::atomic<std::uint64_t> head{}; // bytes handed out from the current partition
+};
+
+// Memory for one frame: written through pData, read by the device from buffer at offset.
+struct UploadAllocation
+{
+    std::byte* pData{nullptr};
+    const Buffer* pBuffer{nullptr};
+    std::uint64_t offset{};
+    std::uint64_t size{};
+};
+
+[[nodiscard]] inline auto Initialize(const Dispatch& dispatch, const Device& device, Allocator& allocator, const PhysicalDevice& physicalDevice, const std::uint64_t partitionSize,
+                                     const std::uint32_t partitionCount, UploadRing& ring) noexcept -> vk_status
+{
+    const vk::PhysicalDeviceLimits& limits{physicalDevice.deviceProperties.properties.limits};
+    ring.alignment     = std::max({ring.alignment, limits.minUniformBufferOffsetAlignment, limits.minStorageBufferOffsetAlignment});
+    ring.partitionSize = AlignUp(partitionSize, ring.alignment);
+    ring.partition     = 0U;
+    ring.head.store(0U, std::memory_order_relaxed);
+
+    constexpr vk::BufferUsageFlags usage{vk::BufferUsageFlagBits::eVertexBuffer | vk::BufferUsageFlagBits::eIndexBuffer | vk::BufferUsageFlagBits::eUniformBuffer
+                                         | vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eTransferSrc};
+    const BufferCreateInfo createInfo{
+        .size           = ring.partitionSize * partitionCount,
+        .usage          = static_cast<std::uint32_t>(usage),
+        .memoryProperty = static_cast<std::uint32_t>(vk::MemoryPropertyFlagBits::eHostVisible),
+        .memoryUsage    = memory_usage::cpu_to_gpu, // read straight from the ring, so video memory when the whole of it is mappable
+    };
+    return Initialize(dispatch, device, allocator, createInfo, ring.buffer);
+}
+
+inline auto Cleanup(const Dispatch& dispatch, const Device& device, Allocator& allocator, UploadRing& ring) noexcept -> void
+{
+    Cleanup(dispatch, device, allocator, ring.buffer);
+    ring.partitionSize = 0U;
+}
+
+// Starts handing out a partition from its start. The device has to be done with whatever the partition held before.
+inline auto BeginPartition(UploadRing& ring, const std::uint32_t partition) noexcept -> void
+{
+    ring.partition = partition;
+    ring.head.store(0U, std::memory_order_relaxed);
+}
+
+// Bumps size bytes off the current partition. Safe to call from several threads at once; out_of_pool_memory once the partition is full.
+[[nodiscard]] inline auto Allocate(UploadRing& ring, const std::uint64_t size, UploadAllocation& allocation) noexcept -> vk_status
+{
+    const std::uint64_t alignedSize{AlignUp(size, ring.alignment)};
+    const std::uint64_t offset{ring.head.fetch_add(alignedSize, std::memory_order_relaxed)};
+    if (offset + alignedSize > ring.partitionSize || ring.buffer.allocation.pMapped == nullptr) [[unlikely]]
+    {
+        return vk_status::out_of_pool_memory;
+    }
+    const std::uint64_t bufferOffset{ring.partition * ring.partitionSize + offset};
+    allocation = {
+        .pData   = ring.buffer.allocation.pMapped + bufferOffset,
+        .pBuffer = &ring.buffer,
+        .offset  = bufferOffset,
+        .size    = size,
+    };
+    return vk_status::ok;
+}
+
+// Makes what was written to the allocation visible to the device. Nothing to do for coherent memory.
+inline auto Flush(const Dispatch& dispatch, const Device& device, const UploadAllocation& allocation) noexcept -> void
+{
+    Flush(dispatch, device, allocation.pBuffer->allocation, allocation.offset, allocation.size);
+}
+} // namespace deer_vulkan
@@ -0,0 +1,237 @@
+//
+// Copyright (c) 2026.
+// Author: Joran.
+//
+
+#pragma once
+
+import std;
+
+// Scoped CPU zones with nanosecond timestamps, written to a ring buffer per thread without locking, plus GPU zones fed from the render graph's timestamps.
+// Everything below compiles to nothing unless BALBINO_PROFILE is defined (BALBINO_PROFILER=ON in CMake).
+//
+//   BALBINO_PROFILE_FRAME(frame);      start of a frame; zones opened after it belong to it
+//   BALBINO_PROFILE_ZONE("Name");      measures until the end of the enclosing scope
+//   BALBINO_PROFILE_FUNCTION();        the same, named after the function
+//   Balbino::Profiler::WriteChromeTrace(path, firstFrame, lastFrame);  opens in chrome://tracing and ui.perfetto.dev
+namespace Balbino::Profiler
+{
+[[nodiscard]] inline auto Now() noexcept -> std::uint64_t
+{
+    return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+#ifdef BALBINO_PROFILE
+inline constexpr std::uint64_t g_ringSize{1U << 16U};    // zones a thread keeps before it overwrites its oldest
+inline constexpr std::uint64_t g_frameHistory{1024U};    // frames whose start is remembered, to place GPU zones
+inline constexpr std::uint32_t g_cpuTrack{~0U};
+
+struct Event
+{
+    const char* name{nullptr};
+    std::uint64_t begin{};    // ns, Now()
+    std::uint64_t duration{}; // ns
+    std::uint64_t frame{};
+    std::uint32_t index{~0U};        // appended to the name when set, e.g. the pass of a GPU zone
+    std::uint32_t track{g_cpuTrack}; // g_cpuTrack for the thread that recorded it, otherwise the GPU queue it ran on
+};
+
+// Only its own thread writes to a ring. Readers copy it and drop whatever the writer may have lapped while they were copying.
+struct ThreadRing
+{
+    std::array<Event, g_ringSize> events{};
+    std::atomic<std::uint64_t> head{};
+    std::uint32_t threadId{};
+};
+
+struct State
+{
+    std::mutex mutex{}; // taken when a thread records its first zone and when exporting, never per zone
+    std::vector<std::unique_ptr<ThreadRing>> rings{};
+    std::array<std::atomic<std::uint64_t>, g_frameHistory> frameBegins{};
+    std::atomic<std::uint64_t> frame{};
+};
+
+[[nodiscard]] inline auto GetState() noexcept -> State&
+{
+    static State state{};
+    return state;
+}
+
+[[nodiscard]] inline auto LocalRing() noexcept -> ThreadRing&
+{
+    thread_local ThreadRing* pRing{nullptr};
+    if (pRing == nullptr) [[unlikely]]
+    {
+        State& state{GetState()};
+        std::lock_guard lock{state.mutex};
+        pRing           = state.rings.emplace_back(std::make_unique<ThreadRing>()).get();
+        pRing->threadId = static_cast<std::uint32_t>(state.rings.size());
+    }
+    return *pRing;
+}
+
+inline auto Record(const Event& event) noexcept -> void
+{
+    ThreadRing& ring{LocalRing()};
+    const std::uint64_t head{ring.head.load(std::memory_order_relaxed)};
+    ring.events[head % g_ringSize] = event;
+    ring.head.store(head + 1U, std::memory_order_release);
+}
+
+inline auto MarkFrame(const std::uint64_t frame) noexcept -> void
+{
+    State& state{GetState()};
+    state.frameBegins[frame % g_frameHistory].store(Now(), std::memory_order_relaxed);
+    state.frame.store(frame, std::memory_order_relaxed);
+}
+
+// GPU and CPU clocks are not calibrated against each other, so a GPU zone is placed relative to the CPU start of the frame that recorded it.
+inline auto RecordGpuZone(const char* name, const std::uint32_t index, const std::uint32_t queue, const std::uint64_t frame, const std::uint64_t beginOffset,
+                          const std::uint64_t duration) noexcept -> void
+{
+    const std::uint64_t frameBegin{GetState().frameBegins[frame % g_frameHistory].load(std::memory_order_relaxed)};
+    Record(Event{.name = name, .begin = frameBegin + beginOffset, .duration = duration, .frame = frame, .index = index, .track = queue});
+}
+
+struct ScopedZone
+{
+    explicit ScopedZone(const char* zoneName) noexcept
+        : name{zoneName}
+        , frame{GetState().frame.load(std::memory_order_relaxed)}
+        , begin{Now()}
+    {
+    }
+    ScopedZone(const ScopedZone&)                        = delete;
+    ScopedZone(ScopedZone&&)                             = delete;
+    auto operator=(const ScopedZone&) -> ScopedZone&     = delete;
+    auto operator=(ScopedZone&&) -> ScopedZone&          = delete;
+    ~ScopedZone() noexcept
+    {
+        Record(Event{.name = name, .begin = begin, .duration = Now() - begin, .frame = frame});
+    }
+
+    const char* name;
+    std::uint64_t frame;
+    std::uint64_t begin;
+};
+
+// Copies what a ring still holds. Events the writer overwrote during the copy are dropped: anything at or before head - g_ringSize once the copy is done.
+inline auto CopyRing(const ThreadRing& ring, std::vector<Event>& events) noexcept -> void
+{
+    const std::uint64_t head{ring.head.load(std::memory_order_acquire)};
+    const std::uint64_t first{head > g_ringSize ? head - g_ringSize : 0U};
+    const std::size_t offset{events.size()};
+    for (std::uint64_t i{first}; i < head; ++i)
+    {
+        events.emplace_back(ring.events[i % g_ringSize]);
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (const std::uint64_t lapped{ring.head.load(std::memory_order_relaxed)}; lapped >= first + g_ringSize)
+    {
+        const auto stale{static_cast<std::ptrdiff_t>(std::min(lapped - g_ringSize + 1U - first, head - first))};
+        events.erase(events.begin() + static_cast<std::ptrdiff_t>(offset), events.begin() + static_cast<std::ptrdiff_t>(offset) + stale);
+    }
+}
+
+inline auto WriteEscaped(std::ostream& stream, const std::string_view text) -> void
+{
+    for (const char character : text)
+    {
+        if (character == '"' || character == '\\')
+        {
+            stream << '\\';
+        }
+        stream << character;
+    }
+}
+
+// Writes every zone of frames [firstFrame, lastFrame] in the Chrome trace event format. CPU threads show up under one process and GPU queues under another.
+// Safe to call while other threads keep recording.
+inline auto WriteChromeTrace(const std::filesystem::path& path, const std::uint64_t firstFrame, const std::uint64_t lastFrame) -> bool
+{
+    std::ofstream stream{path};
+    if (!stream)
+    {
+        return false;
+    }
+
+    std::vector<std::pair<std::uint32_t, std::vector<Event>>> threads{};
+    {
+        State& state{GetState()};
+        std::lock_guard lock{state.mutex};
+        for (const std::unique_ptr<ThreadRing>& ring : state.rings)
+        {
+            CopyRing(*ring, threads.emplace_back(ring->threadId, std::vector<Event>{}).second);
+        }
+    }
+
+    constexpr std::uint32_t cpuProcess{1U};
+    constexpr std::uint32_t gpuProcess{2U};
+    bool isFirst{true};
+    const auto separator = [&stream, &isFirst]
+    {
+        stream << (isFirst ? "\n" : ",\n");
+        isFirst = false;
+    };
+
+    stream << R"({"displayTimeUnit":"ns","traceEvents":[)";
+    separator();
+    stream << std::format(R"({{"name":"process_name","ph":"M","pid":{},"args":{{"name":"CPU"}}}})", cpuProcess);
+    separator();
+    stream << std::format(R"({{"name":"process_name","ph":"M","pid":{},"args":{{"name":"GPU"}}}})", gpuProcess);
+    std::set<std::uint32_t> queues{};
+    for (const auto& [threadId, events] : threads)
+    {
+        separator();
+        stream << std::format(R"({{"name":"thread_name","ph":"M","pid":{},"tid":{},"args":{{"name":"Thread {}"}}}})", cpuProcess, threadId, threadId);
+        for (const Event& event : events)
+        {
+            if (event.frame < firstFrame || event.frame > lastFrame)
+            {
+                continue;
+            }
+            const bool isGpu{event.track != g_cpuTrack};
+            if (isGpu && queues.insert(event.track).second)
+            {
+                separator();
+                stream << std::format(R"({{"name":"thread_name","ph":"M","pid":{},"tid":{},"args":{{"name":"Queue {}"}}}})", gpuProcess, event.track, event.track);
+            }
+
+            separator();
+            stream << R"({"name":")";
+            WriteEscaped(stream, event.name != nullptr ? event.name : "?");
+            if (event.index != ~0U)
+            {
+                stream << ' ' << event.index;
+            }
+            stream << std::format(R"(","cat":"{}","ph":"X","ts":{:.3f},"dur":{:.3f},"pid":{},"tid":{},"args":{{"frame":{}}}}})", isGpu ? "gpu" : "cpu",
+                                  static_cast<double>(event.begin) / 1000.0, static_cast<double>(event.duration) / 1000.0, isGpu ? gpuProcess : cpuProcess,
+                                  isGpu ? event.track : threadId, event.frame);
+        }
+    }
+    stream << "\n]}\n";
+    return static_cast<bool>(stream);
+}
+#else
+inline auto WriteChromeTrace(const std::filesystem::path&, const std::uint64_t, const std::uint64_t) -> bool
+{
+    return false;
+}
+#endif
+} // namespace Balbino::Profiler
+
+#define BALBINO_PROFILE_CONCAT_(a, b) a##b
+#define BALBINO_PROFILE_CONCAT(a, b) BALBINO_PROFILE_CONCAT_(a, b)
+
+#ifdef BALBINO_PROFILE
+#    define BALBINO_PROFILE_FRAME(frame) Balbino::Profiler::MarkFrame(frame)
+#    define BALBINO_PROFILE_ZONE(name) const Balbino::Profiler::ScopedZone BALBINO_PROFILE_CONCAT(balbinoProfileZone, __LINE__){name}
+#    define BALBINO_PROFILE_FUNCTION() BALBINO_PROFILE_ZONE(__func__)
+#    define BALBINO_PROFILE_GPU_ZONE(name, index, queue, frame, beginOffset, duration) Balbino::Profiler::RecordGpuZone(name, index, queue, frame, beginOffset, duration)
+#else
+#    define BALBINO_PROFILE_FRAME(frame) ((void)0)
+#    define BALBINO_PROFILE_ZONE(name) ((void)0)
+#    define BALBINO_PROFILE_FUNCTION() ((void)0)
+#    define BALBINO_PROFILE_GPU_ZONE(name, index, queue, frame, beginOffset, duration) ((void)0)
+#endif
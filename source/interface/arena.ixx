@@ -0,0 +1,101 @@
+//
+// Copyright (c) 2026.
+// Author: Joran.
+//
+
+module;
+
+export module FawnVision:Arena;
+
+import std;
+
+namespace fawn_vision
+{
+// A bump allocator for objects that all go away together. Blocks never move, so pointers into the arena stay valid until it is reset;
+// a reset keeps the blocks, so building the same kind of thing again allocates nothing.
+export struct Arena
+{
+    struct Block
+    {
+        std::unique_ptr<std::byte[]> memory{};
+        std::size_t size{};
+    };
+    struct Destructor
+    {
+        void* pObject{nullptr};
+        void (*pDestroy)(void*) noexcept {nullptr};
+    };
+
+    std::vector<Block> blocks{};
+    std::vector<Destructor> destructors{}; // objects that need one, in creation order
+    std::size_t blockIndex{};              // block allocations come from
+    std::size_t offset{};                  // into that block
+    std::size_t blockSize{16U * 1024U};    // of new blocks; a bigger allocation gets a block of its own size
+};
+
+// nullptr when out of memory.
+export [[nodiscard]] inline auto Allocate(Arena& arena, const std::size_t size, const std::size_t alignment) noexcept -> void*
+{
+    for (; arena.blockIndex < arena.blocks.size(); ++arena.blockIndex, arena.offset = 0U)
+    {
+        Arena::Block& block{arena.blocks[arena.blockIndex]};
+        void* pMemory{block.memory.get() + arena.offset};
+        std::size_t space{block.size - arena.offset};
+        if (std::align(alignment, size, pMemory, space) != nullptr)
+        {
+            arena.offset = block.size - space + size;
+            return pMemory;
+        }
+    }
+
+    const std::size_t blockSize{std::max(arena.blockSize, size + alignment)};
+    std::unique_ptr<std::byte[]> memory{new (std::nothrow) std::byte[blockSize]};
+    if (memory == nullptr) [[unlikely]]
+    {
+        return nullptr;
+    }
+    arena.blocks.emplace_back(Arena::Block{.memory = std::move(memory), .size = blockSize});
+    arena.blockIndex = arena.blocks.size() - 1U;
+    arena.offset     = 0U;
+    return Allocate(arena, size, alignment);
+}
+
+// Constructs a T in the arena; it is destroyed when the arena is reset. nullptr when out of memory.
+export template <class T, class... Args>
+[[nodiscard]] auto Create(Arena& arena, Args&&... args) noexcept -> T*
+{
+    void* pMemory{Allocate(arena, sizeof(T), alignof(T))};
+    if (pMemory == nullptr) [[unlikely]]
+    {
+        return nullptr;
+    }
+    T* pObject{::new (pMemory) T{std::forward<Args>(args)...}};
+    if constexpr (!std::is_trivially_destructible_v<T>)
+    {
+        arena.destructors.emplace_back(Arena::Destructor{.pObject  = pObject,
+                                                         .pDestroy = [](void* pDestroyed) noexcept
+                                                         {
+                                                             static_cast<T*>(pDestroyed)->~T();
+                                                         }});
+    }
+    return pObject;
+}
+
+// Destroys everything created in the arena, newest first, and starts handing out its blocks again from the start.
+export inline auto Reset(Arena& arena) noexcept -> void
+{
+    for (const Arena::Destructor& destructor : std::views::reverse(arena.destructors))
+    {
+        destructor.pDestroy(destructor.pObject);
+    }
+    arena.destructors.clear();
+    arena.blockIndex = 0U;
+    arena.offset     = 0U;
+}
+
+export inline auto Cleanup(Arena& arena) noexcept -> void
+{
+    Reset(arena);
+    arena.blocks.clear();
+}
+} // namespace fawn_vision
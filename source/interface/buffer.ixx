@@ -5,6 +5,7 @@
 
 module;
 #include "api/vulkan/wrapper/buffer.hpp"
+#include "headers/profiler.hpp"
 
 export module FawnVision:Buffer;
 import :Enum;
@@ -73,6 +74,16 @@ export enum class memory_property : std::uint32_t {
     rdma_capable     = 0x00000100,
 };
 
+// What the memory is used for; picks the memory type when no memory_property is asked for. Mirrors deer_vulkan::memory_usage.
+export enum class memory_usage : std::uint8_t {
+    unknown    = 0, // any type with the asked for properties
+    gpu_only   = 1, // written and read by the device only
+    cpu_only   = 2, // staging data the device only copies from
+    cpu_to_gpu = 3, // written by the host every frame and read by the device straight from it
+    gpu_to_cpu = 4, // written by the device and read back by the host
+    transient  = 5, // attachments that never leave the tile
+};
+
 export constexpr buffer_usage operator|(const buffer_usage& lhs, const buffer_usage& rhs)
 {
     using value_t = std::underlying_type_t<buffer_usage>;
@@ -90,29 +101,64 @@ export struct Buffer
     deer_vulkan::Buffer buffer{};
 };
 
+[[nodiscard]] inline auto InitializeBuffer(const Renderer& renderer, const deer_vulkan::BufferCreateInfo& createInfo, Buffer& buffer) noexcept -> gfx_status
+{
+    BALBINO_PROFILE_ZONE("Initialize Buffer");
+    GFX_CHECK(deer_vulkan::Initialize(renderer.dispatch, renderer.device, renderer.allocator, createInfo, buffer.buffer), "Something went wronge while initializing the buffer");
+
+    return gfx_status::ok;
+}
+
 export [[nodiscard]] inline auto Initialize(const Renderer& renderer, const uint64_t size, const buffer_usage bufferUsage, const memory_property memoryProperties,
                                             Buffer& buffer) noexcept -> gfx_status
 {
-    const deer_vulkan::BufferCreateInfo createInfo{
-        .size{size},
-        .usage{static_cast<std::uint32_t>(bufferUsage)},
-        .memoryProperty{static_cast<std::uint32_t>(memoryProperties)},
-    };
-
-    GFX_CHECK(deer_vulkan::Initialize(renderer.dispatch, renderer.device, renderer.physical, createInfo, buffer.buffer), "Something went wronge while initializing the buffer");
+    return InitializeBuffer(renderer,
+                            {
+                                .size{size},
+                                .usage{static_cast<std::uint32_t>(bufferUsage)},
+                                .memoryProperty{static_cast<std::uint32_t>(memoryProperties)},
+                            },
+                            buffer);
+}
 
-    return gfx_status::ok;
+// Lets the memory type follow from how the buffer is used: cpu_to_gpu lands in video memory when all of it is host visible (resizable BAR).
+export [[nodiscard]] inline auto Initialize(const Renderer& renderer, const uint64_t size, const buffer_usage bufferUsage, const memory_usage memoryUsage, Buffer& buffer) noexcept
+    -> gfx_status
+{
+    return InitializeBuffer(renderer,
+                            {
+                                .size{size},
+                                .usage{static_cast<std::uint32_t>(bufferUsage)},
+                                .memoryUsage{static_cast<deer_vulkan::memory_usage>(memoryUsage)},
+                            },
+                            buffer);
 }
 
 export inline auto Cleanup(const Renderer& renderer, Buffer& buffer) noexcept -> void
 {
-    deer_vulkan::Cleanup(renderer.dispatch, renderer.device, buffer.buffer);
+    deer_vulkan::Cleanup(renderer.dispatch, renderer.device, renderer.allocator, buffer.buffer);
 }
 
+// Fails when the buffer is not host visible; such a buffer is filled through the staging queue instead.
 export template <typename T, auto Size = std::dynamic_extent>
-auto CopyData(const Renderer& renderer, const Buffer& buffer, const std::span<const T, Size> data) noexcept -> void
+[[nodiscard]] auto CopyData(const Renderer& renderer, const Buffer& buffer, const std::span<const T, Size> data) noexcept -> gfx_status
+{
+    GFX_CHECK(deer_vulkan::CopyData(renderer.dispatch, renderer.device, buffer.buffer, data), "copying {} bytes into a buffer that is not host visible", data.size_bytes());
+
+    return gfx_status::ok;
+}
+
+// A host visible buffer's memory as Ts, mapped once when the buffer was created. Writes to memory that is not host_coherent need a Flush.
+export template <typename T>
+[[nodiscard]] auto Mapped(const Buffer& buffer) noexcept -> std::span<T>
+{
+    return deer_vulkan::Mapped<T>(buffer.buffer);
+}
+
+// Only does something for memory that is not host_coherent, and then only for the bytes written.
+export inline auto Flush(const Renderer& renderer, const Buffer& buffer, const std::uint64_t offset, const std::uint64_t size) noexcept -> void
 {
-    deer_vulkan::CopyData(renderer.dispatch, renderer.device, buffer.buffer, data);
+    deer_vulkan::Flush(renderer.dispatch, renderer.device, buffer.buffer, offset, size);
 }
 
 } // namespace fawn_vision
@@ -39,8 +39,8 @@ inline void Initialize(RenderGraph& renderGraph, DepthOnlyPass& depthOnlyPass)
     SetRenderFunc<DepthPassData>(renderGraph, depthOnlyPass.renderPassHandle,
                                  [](const DepthPassData* data, const RenderPassContext& ctx) noexcept
                                  {
-                                     SetViewport(ctx, 0, 0, 1920, 1080);
-                                     SetScissor(ctx, 1920, 1080, 0, 0);
+                                     SetViewport(ctx, 0, 0, static_cast<float>(ctx.width), static_cast<float>(ctx.height));
+                                     SetScissor(ctx, ctx.width, ctx.height, 0, 0);
                                      SetDepthTestEnable(ctx, true);
                                      SetDepthWriteEnable(ctx, true);
                                      SetColorWriteMask(ctx, static_cast<color_component>(0)); // Disable color writing
@@ -5,6 +5,7 @@
 
 module;
 #include "api/vulkan/wrapper/descriptor.hpp"
+#include "api/vulkan/wrapper/upload_ring.hpp"
 
 export module FawnVision:Descriptor;
 import :Enum;
@@ -111,7 +112,15 @@ export inline void UpdateDescriptorSet(const Renderer& renderer, const Descripto
 
 export inline void BindTextureToDescriptor(Descriptor& descriptor, const Texture& texture, const std::uint32_t binding) noexcept
 {
-    deer_vulkan::BindImage(descriptor.descriptor, texture.sampler, texture.view, texture.image, binding);
+    deer_vulkan::BindImage(descriptor.descriptor, texture.sampler, texture.view, static_cast<std::uint32_t>(texture.layout), binding);
+}
+
+// Points a uniform_buffer_dynamic or storage_buffer_dynamic binding at the renderer's upload ring, range bytes wide. The part it reads is picked
+// per draw by the dynamic offset BindDescriptor is given, so the set is written once rather than every frame.
+export inline void BindUploadRingToDescriptor(const Renderer& renderer, Descriptor& descriptor, const std::uint32_t binding, const std::uint64_t range,
+                                              const descriptor_type type = descriptor_type::uniform_buffer_dynamic) noexcept
+{
+    deer_vulkan::BindBuffer(descriptor.descriptor, renderer.uploadRing.buffer, 0U, range, binding, static_cast<std::uint32_t>(type));
 }
 
 } // namespace fawn_vision
@@ -44,6 +44,80 @@ export enum class image_layout : std::uint32_t {
     attachment_feedback_loop_optimal_ext         = 1000339000,
 };
 
+export enum class attachment_load_op : std::uint32_t {
+    load      = 0,
+    clear     = 1,
+    dont_care = 2,
+};
+
+export enum class attachment_store_op : std::uint32_t {
+    store     = 0,
+    dont_care = 1,
+    none      = 1000301000,
+};
+
+export enum class pipeline_stage : std::uint64_t {
+    none                    = 0,
+    top_of_pipe             = 0x00000001,
+    draw_indirect           = 0x00000002,
+    vertex_input            = 0x00000004,
+    vertex_shader           = 0x00000008,
+    fragment_shader         = 0x00000080,
+    early_fragment_tests    = 0x00000100,
+    late_fragment_tests     = 0x00000200,
+    color_attachment_output = 0x00000400,
+    compute_shader          = 0x00000800,
+    all_transfer            = 0x00001000,
+    bottom_of_pipe          = 0x00002000,
+    host                    = 0x00004000,
+    all_graphics            = 0x00008000,
+    all_commands            = 0x00010000,
+};
+
+export constexpr pipeline_stage operator|(const pipeline_stage& lhs, const pipeline_stage& rhs)
+{
+    using value_t = std::underlying_type_t<pipeline_stage>;
+    return static_cast<pipeline_stage>(static_cast<value_t>(lhs) | static_cast<value_t>(rhs));
+}
+
+export enum class memory_access : std::uint64_t {
+    none                           = 0,
+    indirect_command_read          = 0x00000001,
+    index_read                     = 0x00000002,
+    vertex_attribute_read          = 0x00000004,
+    uniform_read                   = 0x00000008,
+    input_attachment_read          = 0x00000010,
+    shader_read                    = 0x00000020,
+    shader_write                   = 0x00000040,
+    color_attachment_read          = 0x00000080,
+    color_attachment_write         = 0x00000100,
+    depth_stencil_attachment_read  = 0x00000200,
+    depth_stencil_attachment_write = 0x00000400,
+    transfer_read                  = 0x00000800,
+    transfer_write                 = 0x00001000,
+    host_read                      = 0x00002000,
+    host_write                     = 0x00004000,
+    memory_read                    = 0x00008000,
+    memory_write                   = 0x00010000,
+    shader_sampled_read            = 0x100000000,
+    shader_storage_read            = 0x200000000,
+    shader_storage_write           = 0x400000000,
+};
+
+export constexpr memory_access operator|(const memory_access& lhs, const memory_access& rhs)
+{
+    using value_t = std::underlying_type_t<memory_access>;
+    return static_cast<memory_access>(static_cast<value_t>(lhs) | static_cast<value_t>(rhs));
+}
+
+// Values match VkPresentModeKHR.
+export enum class present_mode : std::uint32_t {
+    immediate    = 0, // no waiting for vblank; tears
+    mailbox      = 1, // no tearing; a newer frame replaces the queued one
+    fifo         = 2, // no tearing; every frame waits its turn
+    fifo_relaxed = 3, // fifo, but a late frame is shown at once and may tear
+};
+
 export enum class gfx_status : std::int8_t {
     ok         = 0,
     regenerate = 1,  // swapchain out of date / suboptimal — recreate and retry
@@ -6,6 +6,7 @@
 module;
 export module FawnVision;
 
+export import :Arena;
 export import :Buffer;
 export import :Descriptor;
 export import :Enum;
@@ -15,5 +16,8 @@ export import :RenderGraph;
 export import :RenderPass;
 export import :RenderPassContext;
 export import :Shader;
+export import :StaticRenderGraph;
+export import :SubmitThread;
 export import :Texture;
 export import :Window;
+export import :WorkerPool;
@@ -4,6 +4,8 @@
 //
 
 module;
+#include "headers/profiler.hpp"
+
 export module FawnVision:Mesh;
 import :Buffer;
 import :Enum;
@@ -21,21 +23,40 @@ export struct Mesh
     Buffer vertexBuffer{};
     std::uint32_t indexCount{0U};
     std::uint32_t vertexCount{0U};
+    UploadTicket upload{}; // of both buffers; see IsUploaded
 };
 
 // ---------------------------------------------------------------------------
 // Internal helpers — not exported
 // ---------------------------------------------------------------------------
 
+// Device local, filled through the staging queue; the mesh's ticket moves up to the copy's.
+[[nodiscard]] inline auto CreateStagedBuffer(const Renderer& renderer, Mesh& mesh, const std::span<const std::byte> data, const buffer_usage usage, Buffer& buffer) noexcept
+    -> gfx_status
+{
+    if (Initialize(renderer, data.size(), usage | buffer_usage::transfer_dst, memory_usage::gpu_only, buffer) != gfx_status::ok)
+    {
+        return gfx_status::not_ok;
+    }
+
+    UploadTicket ticket{};
+    if (StageBuffer(renderer, data, buffer.buffer, 0U, ticket) != gfx_status::ok) [[unlikely]]
+    {
+        Cleanup(renderer, buffer);
+        return gfx_status::not_ok;
+    }
+    mesh.upload.value = std::max(mesh.upload.value, ticket.value);
+    return gfx_status::ok;
+}
+
 template <std::integral Integer, std::size_t IE = std::dynamic_extent>
 [[nodiscard]] auto CreateIndexBuffer(const Renderer& renderer, Mesh& mesh, const std::span<const Integer, IE> indices) noexcept -> gfx_status
 {
-    if (Initialize(renderer, indices.size_bytes(), buffer_usage::index_buffer, memory_property::host_visible | memory_property::host_coherent, mesh.indexBuffer) != gfx_status::ok)
+    if (CreateStagedBuffer(renderer, mesh, std::as_bytes(indices), buffer_usage::index_buffer, mesh.indexBuffer) != gfx_status::ok)
     {
         return gfx_status::not_ok;
     }
 
-    CopyData<Integer, IE>(renderer, mesh.indexBuffer, indices);
     mesh.indexCount = static_cast<std::uint32_t>(indices.size());
     return gfx_status::ok;
 }
@@ -43,12 +64,11 @@ template <std::integral Integer, std::size_t IE = std::dynamic_extent>
 template <typename Vertex, std::size_t VE = std::dynamic_extent>
 [[nodiscard]] auto CreateVertexBuffer(const Renderer& renderer, Mesh& mesh, const std::span<const Vertex, VE> vertices) noexcept -> gfx_status
 {
-    if (Initialize(renderer, vertices.size_bytes(), buffer_usage::vertex_buffer, memory_property::host_visible | memory_property::host_coherent, mesh.vertexBuffer) != gfx_status::ok)
+    if (CreateStagedBuffer(renderer, mesh, std::as_bytes(vertices), buffer_usage::vertex_buffer, mesh.vertexBuffer) != gfx_status::ok)
     {
         return gfx_status::not_ok;
     }
 
-    CopyData<Vertex, VE>(renderer, mesh.vertexBuffer, vertices);
     mesh.vertexCount = static_cast<std::uint32_t>(vertices.size());
     return gfx_status::ok;
 }
@@ -57,9 +77,11 @@ template <typename Vertex, std::size_t VE = std::dynamic_extent>
 // Public API
 // ---------------------------------------------------------------------------
 
+// Returns once the data is staged; frames may draw the mesh once IsUploaded(renderer, mesh.upload), and it has to stay where it is until then.
 export template <std::integral Integer, std::size_t IE = std::dynamic_extent, typename Vertex, std::size_t VE = std::dynamic_extent>
 [[nodiscard]] auto Initialize(const Renderer& renderer, Mesh& mesh, const std::span<const Integer, IE> indices, const std::span<const Vertex, VE> vertices) noexcept -> gfx_status
 {
+    BALBINO_PROFILE_ZONE("Initialize Mesh");
     if (CreateIndexBuffer<Integer, IE>(renderer, mesh, indices) != gfx_status::ok) [[unlikely]]
     {
         return gfx_status::not_ok;
@@ -79,6 +101,7 @@ export inline auto Cleanup(const Renderer& renderer, Mesh& mesh) noexcept -> voi
     Cleanup(renderer, mesh.vertexBuffer);
     mesh.indexCount  = 0U;
     mesh.vertexCount = 0U;
+    mesh.upload      = {};
 }
 
 export template <std::integral Integer, std::size_t IE = std::dynamic_extent>
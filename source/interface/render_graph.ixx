@@ -5,9 +5,15 @@
 
 module;
 #include "api/vulkan/wrapper/command.hpp"
+#include "api/vulkan/wrapper/event.hpp"
+#include "api/vulkan/wrapper/memory.hpp"
+#include "api/vulkan/wrapper/query_pool.hpp"
 #include "api/vulkan/wrapper/queue.hpp"
+#include "headers/profiler.hpp"
 
 export module FawnVision:RenderGraph;
+import :Arena;
+import :Buffer;
 import :Enum;
 import :Texture;
 import :Renderer;
@@ -50,289 +56,2341 @@ export struct RenderPassHandle
     }
 };
 
+export struct TextureHandle
+{
+    std::uint32_t index{~0U};
+
+    [[nodiscard]] constexpr auto IsValid() const noexcept -> bool
+    {
+        return index != ~0U;
+    }
+};
+
+export struct BufferHandle
+{
+    std::uint32_t index{~0U};
+
+    [[nodiscard]] constexpr auto IsValid() const noexcept -> bool
+    {
+        return index != ~0U;
+    }
+};
+
+// Resource 0 is the swap chain image of the current frame; everything else is imported by the user or a graph transient.
+export struct GraphResource
+{
+    Texture* texture{nullptr};
+    deer_vulkan::Image* image{nullptr};
+    deer_vulkan::Buffer* buffer{nullptr};
+    std::uint32_t transient{~0U}; // index into RenderGraph::transients
+    bool isExported{false};       // read outside the graph, so passes writing it are never culled
+};
+
+export struct GraphBarrier
+{
+    std::uint32_t resource{};
+    std::uint64_t srcStage{};
+    std::uint64_t srcAccess{};
+    std::uint64_t dstStage{};
+    std::uint64_t dstAccess{};
+    image_layout oldLayout{image_layout::undefined};
+    image_layout newLayout{image_layout::undefined};
+    std::uint32_t srcQueueFamily{~0U}; // ~0U is VK_QUEUE_FAMILY_IGNORED; two different families make this half of an ownership transfer
+    std::uint32_t dstQueueFamily{~0U};
+};
+
+// A render target that only lives within a frame. Every plan that uses it realizes its own image, sharing memory with the plan's other transients
+// whose lifetimes do not overlap; texture holds the handles of the active plan's image, so pointers to it stay valid across plans.
+export struct TransientTexture
+{
+    RenderTextureCreateInfo createInfo{};
+    Texture texture{};
+    std::uint32_t resource{~0U};
+    float swapChainScale{}; // above 0, createInfo's size follows the swap chain extent times this
+};
+
+// A transient whose size follows the swap chain, e.g. scale 0.5 for a half resolution target.
+export struct SwapChainRelativeTextureInfo
+{
+    format imageFormat{};
+    image_aspect aspect{};
+    float scale{1.0F};
+};
+
+// An image the graph let go of while a frame in flight may still use it; destroyed once the frame timeline passes frameValue.
+export struct RetiredTexture
+{
+    Texture texture{};
+    std::uint64_t frameValue{};
+};
+
+// Transient memory no plan uses any more, kept for the next plan that needs a block. Usable once the frame timeline passes frameValue.
+export struct PooledMemory
+{
+    deer_vulkan::DeviceMemory memory{};
+    std::uint64_t frameValue{};
+    std::uint64_t pooledFrame{}; // RenderGraph::frameCount when it was pooled
+};
+
+// GPU time of one pass in the latest frame whose timestamps came back. beginMilliseconds counts from the first timestamp of that frame on the pass's queue;
+// timestamps of different queues cannot be compared.
+export struct GpuPassTiming
+{
+    float beginMilliseconds{};
+    float milliseconds{};
+    std::uint64_t frame{}; // RenderGraph::frameCount of the frame it was measured in; 0 when the pass never was
+};
+
+// The timestamp queries of one frame slot: a begin and an end for every compiled pass, in compiled order.
+export struct TimestampFrame
+{
+    deer_vulkan::QueryPool queryPool{};
+    std::vector<std::uint32_t> passes{}; // indices of what the last submitted frame of the slot measured; empty when there is nothing to read back
+    std::uint64_t frame{};
+};
+
+export constexpr std::uint32_t g_noBatch{~0U};
+export constexpr std::uint32_t g_previousFrameBatch{~0U - 1U};
+export constexpr std::uint32_t g_maxCachedPlans{8U};   // inactive plans kept around; the least recently used one goes first
+export constexpr std::uint64_t g_memoryPoolFrames{8U}; // frames pooled memory waits for a taker before it is freed
+
+// A run of compiled passes that share a queue, handed over in one submit. Every rendering scope in it is recorded into a command buffer of its own.
+// waitBatch holds, per queue, the latest batch whose timeline signal this one waits for; g_previousFrameBatch waits for that queue's last submit of the previous frame.
+export struct SubmitBatch
+{
+    std::uint32_t firstPass{};
+    std::uint32_t passCount{};
+    std::uint32_t firstScope{};
+    std::uint32_t scopeCount{};
+    std::uint8_t queueId{g_graphicsQueueId};
+    std::array<std::uint32_t, g_queueCount> waitBatch{g_noBatch, g_noBatch, g_noBatch};
+};
+
+export constexpr TextureHandle g_swapChainTexture{0U};
+
+// A barrier with whole rendering scopes between the last access before it and the first one after it. Its event is set at the end of setScope and
+// waited for at the start of waitScope, so the scopes in between keep the GPU busy while it resolves instead of draining the pipeline at waitScope.
+export struct SplitBarrier
+{
+    GraphBarrier barrier{};
+    std::uint32_t setScope{};
+    std::uint32_t waitScope{};
+};
+
+// What a plan found out about one resource.
+export struct PlanResource
+{
+    image_layout startLayout{image_layout::undefined}; // layout the compiled barriers expect at the start of a frame
+    image_layout endLayout{image_layout::undefined};   // layout a frame leaves it in; undefined when no compiled pass uses it
+    bool discardOnFirstUse{false};                      // first use overwrites everything, so the old layout is irrelevant
+};
+
+// How a raster pass begins and ends its attachments: load what an earlier pass left, clear what starts here,
+// and only store what a later pass, a later frame or someone outside the graph still needs.
+export struct AttachmentOps
+{
+    attachment_load_op colorLoad{attachment_load_op::clear};
+    attachment_store_op colorStore{attachment_store_op::store};
+    attachment_load_op depthLoad{attachment_load_op::clear};
+    attachment_store_op depthStore{attachment_store_op::store};
+};
+
+// One transient as a plan realizes it.
+export struct PlanTransient
+{
+    Texture texture{};
+    std::uint32_t firstPass{~0U}; // first and last compiled pass that uses it
+    std::uint32_t lastPass{~0U};
+    std::uint32_t block{~0U};            // index into CompiledPlan::transientMemory
+    std::uint32_t aliasPredecessor{~0U}; // resource that used the block last before this one, possibly in the previous frame
+    std::uint8_t queueMask{};            // queues that use it; only transients of one and the same queue share memory
+    bool isAttachmentOnly{true};         // no pass touches it other than as its color or depth target
+    bool isRealized{false};
+};
+
+// Everything compiling one configuration of the graph produces: pass order, queue batches, barriers and transient placement.
+// Plans are cached by the configuration they were built for, so toggling back to an earlier one only swaps it in.
+export struct CompiledPlan
+{
+    std::vector<std::uint64_t> signature{}; // the configuration it was compiled for; hash only narrows down the candidates
+    std::uint64_t hash{};
+    std::uint64_t lastFrameValue{}; // graphics timeline value that ends the last frame that used it
+
+    std::vector<std::uint32_t> compiled{}; // indices into RenderGraph::passes, in execution order
+    std::vector<SubmitBatch> batches{};
+    std::vector<std::uint32_t> passBatches{};   // batch of every compiled pass
+    std::vector<AttachmentOps> attachmentOps{}; // of every compiled pass
+
+    // Scope s runs compiled passes [scopeOffsets[s], scopeOffsets[s + 1]): consecutive raster passes on the same targets share one rendering scope.
+    std::vector<std::uint32_t> scopeOffsets{};
+    std::vector<PlanResource> resources{};
+    std::vector<PlanTransient> transients{};
+    std::vector<deer_vulkan::DeviceMemory> transientMemory{};
+
+    // Barriers recorded before compiled pass i live in [barrierOffsets[i], barrierOffsets[i + 1]); the extra last range runs after the final pass.
+    std::vector<GraphBarrier> barriers{};
+    std::vector<std::uint32_t> barrierOffsets{};
+    std::vector<SplitBarrier> splitBarriers{}; // taken out of barriers; split barrier i uses event i of the frame slot
+    std::uint64_t swapChainWaitStage{};
+    std::uint32_t presentBatch{g_noBatch}; // records the final range, which hands the swap chain image to present
+
+    // Release halves of queue family ownership transfers, recorded at the end of batch b: [releaseOffsets[b], releaseOffsets[b + 1]).
+    std::vector<GraphBarrier> releaseBarriers{};
+    std::vector<std::uint32_t> releaseOffsets{};
+};
+
+// What one recording worker builds its barrier calls in.
+export struct RecordScratch
+{
+    std::vector<deer_vulkan::ImageBarrier> imageBarriers{};
+    std::vector<deer_vulkan::BufferBarrier> bufferBarriers{};
+};
+
 export struct RenderGraph
 {
-    std::vector<RenderPassBase*> passes{};
-    std::vector<RenderPassBase*> compiled{};
-    bool dirty{true};
-};
+    std::vector<RenderPass> passes{}; // indexed by RenderPassHandle and by compiled plans
+    Arena arena{};                    // pass data
+    std::vector<GraphResource> resources = std::vector<GraphResource>(1U);
+    std::deque<TransientTexture> transients{}; // deque: resources point into it
+
+    CompiledPlan plan{};                  // the active plan
+    std::vector<CompiledPlan> planCache{}; // plans of earlier configurations, parked without transient memory
+    std::vector<std::uint64_t> signature{};
+    std::vector<std::uint64_t> batchSignalValues{};
+
+    // Swap chain extent the relative transients are sized for, and what resizes and evictions left behind.
+    std::uint32_t swapChainWidth{};
+    std::uint32_t swapChainHeight{};
+    std::vector<RetiredTexture> retiredTextures{};
+    std::vector<PooledMemory> memoryPool{};
+    std::uint64_t completedFrameValue{}; // frame timeline value the GPU had reached when the frame began
+    std::uint64_t frameCount{};
+
+    // Per frame slot timestamps, and what they resolved to per pass (indexed like passes).
+    std::array<TimestampFrame, deer_vulkan::maxFramesInFlight> timestamps{};
+    std::vector<GpuPassTiming> gpuTimings{};
+    std::vector<std::uint64_t> timestampResults{};
+
+    // Per frame slot, one per split barrier of the largest plan so far.
+    std::array<std::vector<deer_vulkan::Event>, deer_vulkan::maxFramesInFlight> events{};
+
+    // Filled while recording a frame: per rendering scope, and per worker.
+    std::vector<const deer_vulkan::CommandBuffer*> scopeCommandBuffers{};
+    std::vector<gfx_status> scopeStatus{};
+    std::vector<RecordScratch> scratch{};
+    bool dirty{true};
+};
+
+// ---------------------------------------------------------------------------
+// Pass registration
+// ---------------------------------------------------------------------------
+
+[[nodiscard]] inline auto PassOf(RenderGraph& renderGraph, const RenderPassHandle& handle) noexcept -> RenderPass*
+{
+    return handle.index < renderGraph.passes.size() ? &renderGraph.passes[handle.index] : nullptr;
+}
+
+// The pass at position i of the active plan.
+[[nodiscard]] inline auto CompiledPass(const RenderGraph& renderGraph, const std::uint32_t i) noexcept -> const RenderPass*
+{
+    return &renderGraph.passes[renderGraph.plan.compiled[i]];
+}
+
+// Render functions of different passes may run at the same time on different threads, each with its own command buffer in the context.
+// The function is stored inside the pass, so whatever it captures has to fit in its InlineFunction; capture pointers, not state.
+export template <class PassData, class RenderFunc>
+auto SetRenderFunc(RenderGraph& renderGraph, RenderPassHandle& handle, RenderFunc&& renderFunc) noexcept -> void
+{
+    if (RenderPass* pass{PassOf(renderGraph, handle)}; pass != nullptr) [[likely]]
+    {
+        pass->renderFunction = [function = std::forward<RenderFunc>(renderFunc)](const void* pData, const RenderPassContext& ctx)
+        {
+            function(static_cast<const PassData*>(pData), ctx);
+        };
+    }
+}
+
+inline auto AddRenderPass(RenderGraph& renderGraph, const bool isCompute, void* pData) noexcept -> RenderPassHandle
+{
+    const std::size_t idx{renderGraph.passes.size()};
+    renderGraph.passes.emplace_back(RenderPass{.data = pData, .index = static_cast<std::uint32_t>(idx), .isCompute = isCompute});
+    renderGraph.dirty = true;
+    return RenderPassHandle{idx};
+}
+
+// The pass data lives in the graph's arena until CleanupRenderGraph.
+export template <class PassData>
+[[nodiscard]] auto AddComputeRenderPass(RenderGraph& renderGraph, PassData*& passData) noexcept -> RenderPassHandle
+{
+    passData = Create<PassData>(renderGraph.arena);
+    if (passData == nullptr) [[unlikely]]
+    {
+        return {};
+    }
+    return AddRenderPass(renderGraph, /*isCompute=*/true, passData);
+}
+
+export template <class PassData>
+[[nodiscard]] auto AddRasterRenderPass(RenderGraph& renderGraph, PassData*& passData) noexcept -> RenderPassHandle
+{
+    passData = Create<PassData>(renderGraph.arena);
+    if (passData == nullptr) [[unlikely]]
+    {
+        return {};
+    }
+    return AddRenderPass(renderGraph, /*isCompute=*/false, passData);
+}
+
+// ---------------------------------------------------------------------------
+// Resource declaration
+// ---------------------------------------------------------------------------
+
+[[nodiscard]] constexpr auto StageBits(const pipeline_stage stage) noexcept -> std::uint64_t
+{
+    return static_cast<std::uint64_t>(stage);
+}
+
+[[nodiscard]] constexpr auto AccessBits(const memory_access access) noexcept -> std::uint64_t
+{
+    return static_cast<std::uint64_t>(access);
+}
+
+[[nodiscard]] constexpr auto ToResourceUse(const texture_read access) noexcept -> ResourceUse
+{
+    switch (access)
+    {
+    case texture_read::sampled_fragment:
+        return {.stage = StageBits(pipeline_stage::fragment_shader), .access = AccessBits(memory_access::shader_sampled_read), .layout = image_layout::shader_read_only_optimal};
+    case texture_read::sampled_compute:
+        return {.stage = StageBits(pipeline_stage::compute_shader), .access = AccessBits(memory_access::shader_sampled_read), .layout = image_layout::shader_read_only_optimal};
+    case texture_read::storage_compute:
+        return {.stage = StageBits(pipeline_stage::compute_shader), .access = AccessBits(memory_access::shader_storage_read), .layout = image_layout::general};
+    case texture_read::transfer_src:
+        return {.stage = StageBits(pipeline_stage::all_transfer), .access = AccessBits(memory_access::transfer_read), .layout = image_layout::transfer_src_optimal};
+    }
+    return {};
+}
+
+[[nodiscard]] constexpr auto ToResourceUse(const texture_write access) noexcept -> ResourceUse
+{
+    switch (access)
+    {
+    case texture_write::storage_compute:
+        return {.stage   = StageBits(pipeline_stage::compute_shader),
+                .access  = AccessBits(memory_access::shader_storage_write),
+                .layout  = image_layout::general,
+                .isWrite = true};
+    case texture_write::transfer_dst:
+        return {.stage = StageBits(pipeline_stage::all_transfer), .access = AccessBits(memory_access::transfer_write), .layout = image_layout::transfer_dst_optimal, .isWrite = true};
+    }
+    return {};
+}
+
+[[nodiscard]] constexpr auto ToResourceUse(const buffer_read access) noexcept -> ResourceUse
+{
+    switch (access)
+    {
+    case buffer_read::vertex: return {.stage = StageBits(pipeline_stage::vertex_input), .access = AccessBits(memory_access::vertex_attribute_read)};
+    case buffer_read::index: return {.stage = StageBits(pipeline_stage::vertex_input), .access = AccessBits(memory_access::index_read)};
+    case buffer_read::indirect: return {.stage = StageBits(pipeline_stage::draw_indirect), .access = AccessBits(memory_access::indirect_command_read)};
+    case buffer_read::uniform_vertex: return {.stage = StageBits(pipeline_stage::vertex_shader), .access = AccessBits(memory_access::uniform_read)};
+    case buffer_read::uniform_fragment: return {.stage = StageBits(pipeline_stage::fragment_shader), .access = AccessBits(memory_access::uniform_read)};
+    case buffer_read::uniform_compute: return {.stage = StageBits(pipeline_stage::compute_shader), .access = AccessBits(memory_access::uniform_read)};
+    case buffer_read::storage_fragment: return {.stage = StageBits(pipeline_stage::fragment_shader), .access = AccessBits(memory_access::shader_storage_read)};
+    case buffer_read::storage_compute: return {.stage = StageBits(pipeline_stage::compute_shader), .access = AccessBits(memory_access::shader_storage_read)};
+    case buffer_read::transfer_src: return {.stage = StageBits(pipeline_stage::all_transfer), .access = AccessBits(memory_access::transfer_read)};
+    }
+    return {};
+}
+
+[[nodiscard]] constexpr auto ToResourceUse(const buffer_write access) noexcept -> ResourceUse
+{
+    switch (access)
+    {
+    case buffer_write::storage_fragment:
+        return {.stage = StageBits(pipeline_stage::fragment_shader), .access = AccessBits(memory_access::shader_storage_write), .isWrite = true};
+    case buffer_write::storage_compute:
+        return {.stage = StageBits(pipeline_stage::compute_shader), .access = AccessBits(memory_access::shader_storage_write), .isWrite = true};
+    case buffer_write::transfer_dst: return {.stage = StageBits(pipeline_stage::all_transfer), .access = AccessBits(memory_access::transfer_write), .isWrite = true};
+    }
+    return {};
+}
+
+// Importing the same texture or buffer twice returns the same handle.
+export [[nodiscard]] inline auto ImportTexture(RenderGraph& renderGraph, Texture& texture) noexcept -> TextureHandle
+{
+    for (std::uint32_t i{1U}; i < renderGraph.resources.size(); ++i)
+    {
+        if (renderGraph.resources[i].image == &texture.image)
+        {
+            return TextureHandle{i};
+        }
+    }
+    renderGraph.resources.emplace_back(GraphResource{.texture = &texture, .image = &texture.image});
+    renderGraph.dirty = true;
+    return TextureHandle{static_cast<std::uint32_t>(renderGraph.resources.size() - 1U)};
+}
+
+export [[nodiscard]] inline auto ImportBuffer(RenderGraph& renderGraph, Buffer& buffer) noexcept -> BufferHandle
+{
+    for (std::uint32_t i{1U}; i < renderGraph.resources.size(); ++i)
+    {
+        if (renderGraph.resources[i].buffer == &buffer.buffer)
+        {
+            return BufferHandle{i};
+        }
+    }
+    renderGraph.resources.emplace_back(GraphResource{.buffer = &buffer.buffer});
+    renderGraph.dirty = true;
+    return BufferHandle{static_cast<std::uint32_t>(renderGraph.resources.size() - 1U)};
+}
+
+// The texture is created and given memory when the graph is compiled, and only if a compiled pass uses it.
+// Its contents do not survive from one frame to the next.
+export [[nodiscard]] inline auto CreateTransientTexture(RenderGraph& renderGraph, const RenderTextureCreateInfo& createInfo) noexcept -> TextureHandle
+{
+    const auto resource{static_cast<std::uint32_t>(renderGraph.resources.size())};
+    TransientTexture& transient{renderGraph.transients.emplace_back(TransientTexture{.createInfo = createInfo, .resource = resource})};
+    renderGraph.resources.emplace_back(GraphResource{.texture   = &transient.texture,
+                                                     .image     = &transient.texture.image,
+                                                     .transient = static_cast<std::uint32_t>(renderGraph.transients.size() - 1U)});
+    renderGraph.dirty = true;
+    return TextureHandle{resource};
+}
+
+[[nodiscard]] constexpr auto ScaledExtent(const std::uint32_t extent, const float scale) noexcept -> std::uint32_t
+{
+    return std::max(1U, static_cast<std::uint32_t>(static_cast<float>(extent) * scale + 0.5F));
+}
+
+// Re-created by the graph whenever the swap chain changes size. The handle and the texture GetTexture returns stay the same,
+// but the image and views behind it change, so render functions should not hold on to them across frames.
+export [[nodiscard]] inline auto CreateTransientTexture(RenderGraph& renderGraph, const SwapChainRelativeTextureInfo& createInfo) noexcept -> TextureHandle
+{
+    const TextureHandle handle{CreateTransientTexture(renderGraph, RenderTextureCreateInfo{.imageFormat = createInfo.imageFormat,
+                                                                                           .aspect      = createInfo.aspect,
+                                                                                           .width       = ScaledExtent(renderGraph.swapChainWidth, createInfo.scale),
+                                                                                           .height      = ScaledExtent(renderGraph.swapChainHeight, createInfo.scale)})};
+    renderGraph.transients.back().swapChainScale = createInfo.scale;
+    return handle;
+}
+
+// Views and samplers of transients only exist once the graph has been compiled; render functions should look them up here.
+export [[nodiscard]] inline auto GetTexture(const RenderGraph& renderGraph, const TextureHandle& texture) noexcept -> Texture*
+{
+    return texture.index < renderGraph.resources.size() ? renderGraph.resources[texture.index].texture : nullptr;
+}
+
+// Lags the frame being recorded by as many frames as are in flight, so reading them back never waits for the GPU.
+export [[nodiscard]] inline auto GetGpuTiming(const RenderGraph& renderGraph, const RenderPassHandle& handle) noexcept -> GpuPassTiming
+{
+    return handle.index < renderGraph.gpuTimings.size() ? renderGraph.gpuTimings[handle.index] : GpuPassTiming{};
+}
+
+// Every pass's timing, indexed like the handles AddRasterRenderPass and AddComputeRenderPass return.
+export [[nodiscard]] inline auto GetGpuTimings(const RenderGraph& renderGraph) noexcept -> std::span<const GpuPassTiming>
+{
+    return renderGraph.gpuTimings;
+}
+
+// Marks a resource as consumed outside the graph (next frame, CPU read-back, another graph).
+// Without this, the passes that only write it are culled when nothing in the graph reads it.
+export inline auto ExportTexture(RenderGraph& renderGraph, const TextureHandle& texture) noexcept -> void
+{
+    if (texture.index < renderGraph.resources.size()) [[likely]]
+    {
+        renderGraph.resources[texture.index].isExported = true;
+        renderGraph.dirty                               = true;
+    }
+}
+
+export inline auto ExportBuffer(RenderGraph& renderGraph, const BufferHandle& buffer) noexcept -> void
+{
+    if (buffer.index < renderGraph.resources.size()) [[likely]]
+    {
+        renderGraph.resources[buffer.index].isExported = true;
+        renderGraph.dirty                              = true;
+    }
+}
+
+inline auto DeclareUse(RenderGraph& renderGraph, const RenderPassHandle& handle, const std::uint32_t resource, ResourceUse use) noexcept -> void
+{
+    if (RenderPass* pass{PassOf(renderGraph, handle)}; pass != nullptr && resource < renderGraph.resources.size()) [[likely]]
+    {
+        use.resource = resource;
+        pass->uses.emplace_back(use);
+        renderGraph.dirty = true;
+    }
+}
+
+export inline auto ReadTexture(RenderGraph& renderGraph, const RenderPassHandle& handle, const TextureHandle& texture, const texture_read access) noexcept -> void
+{
+    DeclareUse(renderGraph, handle, texture.index, ToResourceUse(access));
+}
+
+export inline auto WriteTexture(RenderGraph& renderGraph, const RenderPassHandle& handle, const TextureHandle& texture, const texture_write access) noexcept -> void
+{
+    DeclareUse(renderGraph, handle, texture.index, ToResourceUse(access));
+}
+
+export inline auto ReadBuffer(RenderGraph& renderGraph, const RenderPassHandle& handle, const BufferHandle& buffer, const buffer_read access) noexcept -> void
+{
+    DeclareUse(renderGraph, handle, buffer.index, ToResourceUse(access));
+}
+
+export inline auto WriteBuffer(RenderGraph& renderGraph, const RenderPassHandle& handle, const BufferHandle& buffer, const buffer_write access) noexcept -> void
+{
+    DeclareUse(renderGraph, handle, buffer.index, ToResourceUse(access));
+}
+
+// ---------------------------------------------------------------------------
+// Pass configuration
+// ---------------------------------------------------------------------------
+
+export inline auto EnableRenderPass(RenderGraph& renderGraph, const RenderPassHandle& handle) noexcept -> void
+{
+    if (RenderPass* pass{PassOf(renderGraph, handle)}; pass != nullptr) [[likely]]
+    {
+        pass->isEnabled   = true;
+        renderGraph.dirty = true;
+    }
+}
+
+export inline auto DisableRenderPass(RenderGraph& renderGraph, const RenderPassHandle& handle) noexcept -> void
+{
+    if (RenderPass* pass{PassOf(renderGraph, handle)}; pass != nullptr) [[likely]]
+    {
+        pass->isEnabled   = false;
+        renderGraph.dirty = true;
+    }
+}
+
+export inline auto SetRenderColorTarget(RenderGraph& renderGraph, const RenderPassHandle& handle, const TextureHandle& color) noexcept -> void
+{
+    Texture* texture{GetTexture(renderGraph, color)};
+    if (RenderPass* pass{PassOf(renderGraph, handle)}; pass != nullptr && texture != nullptr) [[likely]]
+    {
+        pass->colorImage     = &texture->image;
+        pass->colorImageView = &texture->view;
+        pass->colorResource  = color.index;
+        renderGraph.dirty    = true;
+    }
+}
+
+// A read-only depth target is tested against but never written.
+export inline auto SetRenderDepthTarget(RenderGraph& renderGraph, const RenderPassHandle& handle, const TextureHandle& depth, const bool readOnly = false) noexcept -> void
+{
+    Texture* texture{GetTexture(renderGraph, depth)};
+    if (RenderPass* pass{PassOf(renderGraph, handle)}; pass != nullptr && texture != nullptr) [[likely]]
+    {
+        pass->depthImage      = &texture->image;
+        pass->depthImageView  = &texture->view;
+        pass->depthResource   = depth.index;
+        pass->isDepthReadOnly = readOnly;
+        renderGraph.dirty     = true;
+    }
+}
+
+// Only used where the graph clears a target, which is in the pass that uses it first in a frame. Changing them never recompiles the graph.
+export inline auto SetRenderClearValues(RenderGraph& renderGraph, const RenderPassHandle& handle, const std::array<float, 4>& color, const float depth = 0.0F,
+                                        const std::uint32_t stencil = 0U) noexcept -> void
+{
+    if (RenderPass* pass{PassOf(renderGraph, handle)}; pass != nullptr) [[likely]]
+    {
+        pass->clearColor   = color;
+        pass->clearDepth   = depth;
+        pass->clearStencil = stencil;
+    }
+}
+
+export inline auto SetRenderTarget(RenderGraph& renderGraph, const RenderPassHandle& handle, const TextureHandle& color, const TextureHandle& depth) noexcept -> void
+{
+    SetRenderColorTarget(renderGraph, handle, color);
+    SetRenderDepthTarget(renderGraph, handle, depth);
+}
+
+export inline auto SetRenderTarget(RenderGraph& renderGraph, const RenderPassHandle& handle, Texture& color, Texture& depth) noexcept -> void
+{
+    SetRenderTarget(renderGraph, handle, ImportTexture(renderGraph, color), ImportTexture(renderGraph, depth));
+}
+
+export inline auto SetRenderColorTarget(RenderGraph& renderGraph, const RenderPassHandle& handle, Texture& color) noexcept -> void
+{
+    SetRenderColorTarget(renderGraph, handle, ImportTexture(renderGraph, color));
+}
+
+export inline auto SetRenderDepthTarget(RenderGraph& renderGraph, const RenderPassHandle& handle, Texture& depth, const bool readOnly = false) noexcept -> void
+{
+    SetRenderDepthTarget(renderGraph, handle, ImportTexture(renderGraph, depth), readOnly);
+}
+
+// ---------------------------------------------------------------------------
+// Execution
+// ---------------------------------------------------------------------------
+
+// A raster pass without its own targets renders straight into the acquired swap chain image.
+[[nodiscard]] constexpr auto IsSwapChainPass(const RenderPass* renderPass) noexcept -> bool
+{
+    return !renderPass->isCompute && renderPass->colorImage == nullptr && renderPass->depthImage == nullptr;
+}
+
+// Whether one of compiled passes [first, first + count) of the active plan renders to the swap chain.
+[[nodiscard]] inline auto TouchesSwapChain(const RenderGraph& renderGraph, const std::uint32_t first, const std::uint32_t count) noexcept -> bool
+{
+    for (std::uint32_t i{first}; i < first + count; ++i)
+    {
+        if (IsSwapChainPass(CompiledPass(renderGraph, i)))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+// The color target a raster pass renders into.
+[[nodiscard]] constexpr auto ColorTarget(const RenderPass* renderPass) noexcept -> std::uint32_t
+{
+    return IsSwapChainPass(renderPass) ? g_swapChainTexture.index : renderPass->colorResource;
+}
+
+// Compute passes run on the compute queue so they can overlap raster work; the compiled waits keep dependent passes in order.
+[[nodiscard]] constexpr auto QueueOf(const RenderPass* renderPass) noexcept -> std::uint8_t
+{
+    return renderPass->isCompute ? g_computeQueueId : g_graphicsQueueId;
+}
+
+// Attachments plus declared uses, with several uses of one resource folded into a single use.
+inline auto CollectUses(const RenderPass* renderPass, std::vector<ResourceUse>& uses) noexcept -> void
+{
+    uses.clear();
+    const auto add = [&uses](const ResourceUse& use)
+    {
+        const auto it{std::ranges::find(uses, use.resource, &ResourceUse::resource)};
+        if (it == uses.end())
+        {
+            uses.emplace_back(use);
+            return;
+        }
+        it->stage   |= use.stage;
+        it->access  |= use.access;
+        it->isWrite = it->isWrite || use.isWrite;
+        if (it->layout == image_layout::undefined)
+        {
+            it->layout = use.layout;
+        }
+        else if (use.layout != image_layout::undefined && use.layout != it->layout)
+        {
+            // No one layout serves both uses, say sampled while written as an attachment; general serves every use.
+            it->layout = image_layout::general;
+        }
+    };
+
+    if (!renderPass->isCompute)
+    {
+        if (const std::uint32_t color{ColorTarget(renderPass)}; color != ~0U)
+        {
+            add({.resource = color,
+                 .stage    = StageBits(pipeline_stage::color_attachment_output),
+                 .access   = AccessBits(memory_access::color_attachment_read | memory_access::color_attachment_write),
+                 .layout   = image_layout::attachment_optimal,
+                 .isWrite  = true});
+        }
+        if (renderPass->depthResource != ~0U)
+        {
+            const bool readOnly{renderPass->isDepthReadOnly};
+            add({.resource = renderPass->depthResource,
+                 .stage    = StageBits(pipeline_stage::early_fragment_tests | pipeline_stage::late_fragment_tests),
+                 .access   = readOnly ? AccessBits(memory_access::depth_stencil_attachment_read)
+                                      : AccessBits(memory_access::depth_stencil_attachment_read | memory_access::depth_stencil_attachment_write),
+                 .layout   = readOnly ? image_layout::read_only_optimal : image_layout::attachment_optimal,
+                 .isWrite  = !readOnly});
+        }
+    }
+    for (const ResourceUse& use : renderPass->uses)
+    {
+        add(use);
+    }
+}
+
+// What the GPU has done to a resource so far in the compiled frame.
+// Reads and visibility are tracked per queue: a barrier only orders work on its own queue, work on another queue is ordered by a timeline wait.
+struct ResourceState
+{
+    image_layout layout{image_layout::undefined};
+    std::uint64_t writeStage{};
+    std::uint64_t writeAccess{};
+    std::array<std::uint64_t, g_queueCount> readStages{};    // reads since the last write
+    std::array<std::uint64_t, g_queueCount> visibleStages{}; // stages that already see the last write
+    std::array<std::uint64_t, g_queueCount> visibleAccess{};
+    std::array<std::uint32_t, g_queueCount> lastBatch{g_noBatch, g_noBatch, g_noBatch}; // latest access per queue that no other queue has waited for yet
+    std::uint32_t ownerBatch{g_noBatch};                                                   // latest access by the owning queue, where a release goes
+    std::uint8_t writeQueue{g_graphicsQueueId};
+    std::uint8_t ownerQueue{g_graphicsQueueId};
+    bool isUsed{false};
+};
+
+// Where ApplyUse records what crossing queues takes: the waits of each batch and the release half of ownership transfers.
+struct QueueSync
+{
+    std::vector<SubmitBatch>& batches;
+    std::vector<std::vector<GraphBarrier>>& releases; // per batch; the extra last entry per queue is resolved once the plan is complete
+    const std::array<std::uint32_t, g_queueCount>& families;
+};
+
+// Keeps the later of two waits on the same queue; waiting for a batch also covers everything before it.
+constexpr auto MergeWait(std::uint32_t& wait, const std::uint32_t batch) noexcept -> void
+{
+    if (wait == g_noBatch || (wait == g_previousFrameBatch && batch != g_noBatch))
+    {
+        wait = batch;
+    }
+    else if (batch != g_noBatch && batch != g_previousFrameBatch)
+    {
+        wait = std::max(wait, batch);
+    }
+}
+
+// Moves a resource to the state one use on one queue needs and appends the barriers that takes, if any.
+// Reads in the same layout share one barrier; a read only waits when its stage has not seen the last write yet.
+// Without pSync the queues are not tracked, which is enough to find the state a frame ends in.
+inline auto ApplyUse(ResourceState& state, const ResourceUse& use, const std::uint8_t queue, const std::uint32_t batch, const bool isImage, std::vector<GraphBarrier>* pBarriers,
+                     QueueSync* pSync) noexcept -> void
+{
+    const bool layoutChange{isImage && use.layout != state.layout};
+    const bool modifies{layoutChange || use.isWrite};
+    const bool familyChange{pSync != nullptr && pSync->families[state.ownerQueue] != pSync->families[queue]};
+    const bool needsTransfer{familyChange && state.ownerBatch != g_noBatch && !(isImage && state.layout == image_layout::undefined)};
+
+    // Reads wait for the queue that wrote, writes for every queue that touched it, transfers for the owner.
+    bool waited{false};
+    for (std::uint8_t other{}; other < g_queueCount; ++other)
+    {
+        const bool mustWait{modifies || (other == state.writeQueue && state.writeStage != 0U) || (needsTransfer && other == state.ownerQueue)};
+        if (other == queue || state.lastBatch[other] == g_noBatch || !mustWait)
+        {
+            continue;
+        }
+        if (pSync != nullptr)
+        {
+            MergeWait(pSync->batches[batch].waitBatch[other], state.lastBatch[other]);
+        }
+        state.lastBatch[other]  = g_noBatch;
+        state.readStages[other] = 0U;
+        waited                  = true;
+    }
+    if (waited)
+    {
+        // The timeline wait made every write of the other queues available and visible here.
+        state.visibleStages[queue] = ~0ULL;
+        state.visibleAccess[queue] = ~0ULL;
+    }
+
+    const image_layout newLayout{isImage ? use.layout : state.layout};
+    if (needsTransfer)
+    {
+        const std::uint64_t ownerStages{(state.writeQueue == state.ownerQueue ? state.writeStage : 0U) | state.readStages[state.ownerQueue]};
+        const GraphBarrier release{.resource       = use.resource,
+                                   .srcStage       = ownerStages != 0U ? ownerStages : StageBits(pipeline_stage::all_commands),
+                                   .srcAccess      = state.writeQueue == state.ownerQueue ? state.writeAccess : 0U,
+                                   .dstStage       = StageBits(pipeline_stage::none),
+                                   .dstAccess      = AccessBits(memory_access::none),
+                                   .oldLayout      = state.layout,
+                                   .newLayout      = newLayout,
+                                   .srcQueueFamily = pSync->families[state.ownerQueue],
+                                   .dstQueueFamily = pSync->families[queue]};
+        const std::size_t releaseBatch{state.ownerBatch == g_previousFrameBatch ? pSync->batches.size() + state.ownerQueue : state.ownerBatch};
+        pSync->releases[releaseBatch].emplace_back(release);
+        MergeWait(pSync->batches[batch].waitBatch[state.ownerQueue], state.ownerBatch);
+        if (pBarriers != nullptr)
+        {
+            // The acquire half; its source stage chains it to the timeline wait.
+            pBarriers->emplace_back(GraphBarrier{.resource       = use.resource,
+                                                 .srcStage       = use.stage,
+                                                 .srcAccess      = AccessBits(memory_access::none),
+                                                 .dstStage       = use.stage,
+                                                 .dstAccess      = use.access,
+                                                 .oldLayout      = state.layout,
+                                                 .newLayout      = newLayout,
+                                                 .srcQueueFamily = release.srcQueueFamily,
+                                                 .dstQueueFamily = release.dstQueueFamily});
+        }
+    }
+
+    if (needsTransfer || modifies)
+    {
+        const std::uint64_t localStages{(state.writeQueue == queue ? state.writeStage : 0U) | state.readStages[queue]};
+        if (!needsTransfer && pBarriers != nullptr && (layoutChange || localStages != 0U))
+        {
+            pBarriers->emplace_back(GraphBarrier{.resource  = use.resource,
+                                                 .srcStage  = localStages | (waited ? use.stage : 0U),
+                                                 .srcAccess = state.writeQueue == queue ? state.writeAccess : 0U,
+                                                 .dstStage  = use.stage,
+                                                 .dstAccess = use.access,
+                                                 .oldLayout = state.layout,
+                                                 .newLayout = newLayout});
+        }
+        // A layout transition or ownership transfer is a write too; later readers chain behind the stage that waited for it.
+        state.layout        = newLayout;
+        state.writeStage    = use.stage;
+        state.writeAccess   = use.isWrite ? use.access : 0U;
+        state.writeQueue    = queue;
+        state.readStages    = {};
+        state.visibleStages = {};
+        state.visibleAccess = {};
+
+        state.readStages[queue]    = use.isWrite ? 0U : use.stage;
+        state.visibleStages[queue] = use.stage;
+        state.visibleAccess[queue] = use.access;
+    }
+    else
+    {
+        if (state.writeStage != 0U && ((use.stage & ~state.visibleStages[queue]) != 0U || (use.access & ~state.visibleAccess[queue]) != 0U))
+        {
+            if (pBarriers != nullptr)
+            {
+                pBarriers->emplace_back(GraphBarrier{.resource  = use.resource,
+                                                     .srcStage  = state.writeStage,
+                                                     .srcAccess = state.writeAccess,
+                                                     .dstStage  = use.stage,
+                                                     .dstAccess = use.access,
+                                                     .oldLayout = state.layout,
+                                                     .newLayout = state.layout});
+            }
+            state.visibleStages[queue] |= use.stage;
+            state.visibleAccess[queue] |= use.access;
+        }
+        state.readStages[queue] |= use.stage;
+    }
+
+    state.lastBatch[queue] = batch;
+    state.ownerBatch       = batch;
+    state.ownerQueue       = queue;
+}
+
+// The state one frame leaves behind, as the next frame sees it: its accesses now belong to the previous frame's submits.
+[[nodiscard]] constexpr auto CarriedOver(ResourceState state) noexcept -> ResourceState
+{
+    for (std::uint32_t& batch : state.lastBatch)
+    {
+        batch = batch == g_noBatch ? g_noBatch : g_previousFrameBatch;
+    }
+    state.ownerBatch = state.ownerBatch == g_noBatch ? g_noBatch : g_previousFrameBatch;
+    return state;
+}
+
+inline auto CompileBarriers(const Renderer& renderer, RenderGraph& renderGraph) noexcept -> void
+{
+    std::vector<ResourceUse> uses{};
+    std::vector<ResourceState> states(renderGraph.resources.size());
+    std::vector<std::uint64_t> firstStages(renderGraph.resources.size(), 0U);
+    const auto isImage = [&renderGraph](const std::uint32_t resource)
+    {
+        return resource == g_swapChainTexture.index || renderGraph.resources[resource].image != nullptr;
+    };
+
+    renderGraph.plan.resources.assign(renderGraph.resources.size(), PlanResource{});
+    for (SubmitBatch& batch : renderGraph.plan.batches)
+    {
+        batch.waitBatch = {g_noBatch, g_noBatch, g_noBatch};
+    }
+    const std::vector<std::uint32_t>& passBatch{renderGraph.plan.passBatches};
+    std::array<std::uint32_t, g_queueCount> lastBatchOfQueue{g_noBatch, g_noBatch, g_noBatch};
+    for (std::uint32_t b{}; b < renderGraph.plan.batches.size(); ++b)
+    {
+        lastBatchOfQueue[renderGraph.plan.batches[b].queueId] = b;
+    }
+
+    // First walk: the state every resource is left in at the end of a frame, which is the state the next frame starts from.
+    for (std::uint32_t i{}; i < renderGraph.plan.compiled.size(); ++i)
+    {
+        CollectUses(CompiledPass(renderGraph, i), uses);
+        for (const ResourceUse& use : uses)
+        {
+            ResourceState& state{states[use.resource]};
+            if (!state.isUsed)
+            {
+                renderGraph.plan.resources[use.resource].discardOnFirstUse = use.isWrite && use.layout == image_layout::attachment_optimal;
+                firstStages[use.resource]                                  = use.stage;
+                state.isUsed                                               = true;
+            }
+            ApplyUse(state, use, QueueOf(CompiledPass(renderGraph, i)), passBatch[i], isImage(use.resource), nullptr, nullptr);
+        }
+    }
+
+    const std::vector<ResourceState> endStates{states};
+    for (std::uint32_t i{}; i < states.size(); ++i)
+    {
+        ResourceState& state{states[i]};
+        PlanResource& resource{renderGraph.plan.resources[i]};
+        if (i == g_swapChainTexture.index)
+        {
+            // A fresh image every frame; the acquire semaphore wait at the first using stage is all that precedes it.
+            renderGraph.plan.swapChainWaitStage    = firstStages[i];
+            state                                  = ResourceState{.writeStage = firstStages[i], .isUsed = state.isUsed};
+            state.visibleStages[g_graphicsQueueId] = firstStages[i];
+            continue;
+        }
+        if (const std::uint32_t index{renderGraph.resources[i].transient}; index != ~0U)
+        {
+            // Nothing survives in a transient; its first use only waits for whichever resource used the same memory before it.
+            resource.discardOnFirstUse = true;
+            resource.startLayout       = image_layout::undefined;
+            if (const PlanTransient& transient{renderGraph.plan.transients[index]}; state.isUsed && transient.aliasPredecessor != ~0U)
+            {
+                const ResourceState& previous{endStates[transient.aliasPredecessor]};
+                state        = CarriedOver(previous);
+                state.layout = image_layout::undefined;
+                for (const std::uint64_t readStages : previous.readStages)
+                {
+                    state.writeStage |= readStages;
+                }
+                state.readStages = {};
+            }
+            continue;
+        }
+        resource.startLayout = resource.discardOnFirstUse ? image_layout::undefined : state.layout;
+        state                = CarriedOver(state);
+        state.layout         = resource.startLayout;
+    }
+
+    // Second walk: the actual barriers and queue waits, starting from the steady state.
+    std::array<std::uint32_t, g_queueCount> families{};
+    for (std::uint8_t q{}; q < g_queueCount; ++q)
+    {
+        families[q] = renderer.queue[q].familyIndex;
+    }
+    std::vector<std::vector<GraphBarrier>> releases(renderGraph.plan.batches.size() + g_queueCount);
+    QueueSync sync{.batches = renderGraph.plan.batches, .releases = releases, .families = families};
+
+    renderGraph.plan.barriers.clear();
+    renderGraph.plan.barrierOffsets.clear();
+    for (std::uint32_t i{}; i < renderGraph.plan.compiled.size(); ++i)
+    {
+        renderGraph.plan.barrierOffsets.emplace_back(static_cast<std::uint32_t>(renderGraph.plan.barriers.size()));
+        CollectUses(CompiledPass(renderGraph, i), uses);
+        for (const ResourceUse& use : uses)
+        {
+            ApplyUse(states[use.resource], use, QueueOf(CompiledPass(renderGraph, i)), passBatch[i], isImage(use.resource), &renderGraph.plan.barriers, &sync);
+        }
+    }
+
+    for (std::uint32_t i{1U}; i < states.size(); ++i)
+    {
+        renderGraph.plan.resources[i].endLayout = states[i].isUsed && isImage(i) ? states[i].layout : image_layout::undefined;
+    }
+
+    renderGraph.plan.barrierOffsets.emplace_back(static_cast<std::uint32_t>(renderGraph.plan.barriers.size()));
+    renderGraph.plan.presentBatch = g_noBatch;
+    if (const ResourceState& swapChain{states[g_swapChainTexture.index]}; swapChain.isUsed)
+    {
+        renderGraph.plan.barriers.emplace_back(GraphBarrier{.resource  = g_swapChainTexture.index,
+                                                            .srcStage  = swapChain.writeStage | swapChain.readStages[g_graphicsQueueId],
+                                                            .srcAccess = swapChain.writeAccess,
+                                                            .dstStage  = StageBits(pipeline_stage::none),
+                                                            .dstAccess = AccessBits(memory_access::none),
+                                                            .oldLayout = swapChain.layout,
+                                                            .newLayout = image_layout::present_src_khr});
+        renderGraph.plan.presentBatch = swapChain.ownerBatch;
+    }
+    renderGraph.plan.barrierOffsets.emplace_back(static_cast<std::uint32_t>(renderGraph.plan.barriers.size()));
+
+    // Releases for the next frame run at the end of the last batch on the owning queue.
+    for (std::uint8_t q{}; q < g_queueCount; ++q)
+    {
+        if (std::vector<GraphBarrier>& carried{releases[renderGraph.plan.batches.size() + q]}; !carried.empty() && lastBatchOfQueue[q] != g_noBatch)
+        {
+            releases[lastBatchOfQueue[q]].insert(releases[lastBatchOfQueue[q]].end(), carried.begin(), carried.end());
+        }
+    }
+    renderGraph.plan.releaseBarriers.clear();
+    renderGraph.plan.releaseOffsets.clear();
+    for (std::uint32_t b{}; b < renderGraph.plan.batches.size(); ++b)
+    {
+        renderGraph.plan.releaseOffsets.emplace_back(static_cast<std::uint32_t>(renderGraph.plan.releaseBarriers.size()));
+        renderGraph.plan.releaseBarriers.insert(renderGraph.plan.releaseBarriers.end(), releases[b].begin(), releases[b].end());
+    }
+    renderGraph.plan.releaseOffsets.emplace_back(static_cast<std::uint32_t>(renderGraph.plan.releaseBarriers.size()));
+
+    // The last submit signals the end of the frame, so it waits for every other queue's last submit.
+    if (!renderGraph.plan.batches.empty())
+    {
+        SubmitBatch& last{renderGraph.plan.batches.back()};
+        for (std::uint8_t q{}; q < g_queueCount; ++q)
+        {
+            if (q != last.queueId && lastBatchOfQueue[q] != g_noBatch)
+            {
+                MergeWait(last.waitBatch[q], lastBatchOfQueue[q]);
+            }
+        }
+    }
+}
+
+// Attachments are read-modify-write, so a pass that renders into a target also depends on whoever wrote it before.
+[[nodiscard]] constexpr auto ReadsResource(const ResourceUse& use) noexcept -> bool
+{
+    return !use.isWrite || (use.access & AccessBits(memory_access::color_attachment_read | memory_access::depth_stencil_attachment_read)) != 0U;
+}
+
+// Walks the compiled passes back to front from the swap chain and the exported resources, and drops every pass whose writes nobody reads.
+// A pass that declares nothing at all is kept: the graph cannot see what it produces.
+inline auto CullPasses(RenderGraph& renderGraph) noexcept -> void
+{
+    std::vector<bool> isNeeded(renderGraph.resources.size(), false);
+    isNeeded[g_swapChainTexture.index] = true;
+    for (std::uint32_t i{1U}; i < renderGraph.resources.size(); ++i)
+    {
+        isNeeded[i] = renderGraph.resources[i].isExported;
+    }
+
+    std::vector<ResourceUse> uses{};
+    std::vector<bool> isLive(renderGraph.plan.compiled.size(), false);
+    for (std::size_t i{renderGraph.plan.compiled.size()}; i-- > 0U;)
+    {
+        CollectUses(CompiledPass(renderGraph, i), uses);
+        isLive[i] = uses.empty() || std::ranges::any_of(uses,
+                                                        [&isNeeded](const ResourceUse& use)
+                                                        {
+                                                            return use.isWrite && isNeeded[use.resource];
+                                                        });
+        if (!isLive[i])
+        {
+            continue;
+        }
+        for (const ResourceUse& use : uses)
+        {
+            isNeeded[use.resource] = isNeeded[use.resource] || ReadsResource(use);
+        }
+    }
+
+    std::size_t next{};
+    for (std::size_t i{}; i < renderGraph.plan.compiled.size(); ++i)
+    {
+        if (isLive[i])
+        {
+            renderGraph.plan.compiled[next++] = renderGraph.plan.compiled[i];
+        }
+    }
+    renderGraph.plan.compiled.resize(next);
+}
+
+// Reorders the compiled passes so that independent work lands between a producer and its consumer. The barrier between the two then has work to overlap
+// with, and once a whole rendering scope sits in between it becomes a split barrier (see SplitBarriers).
+// Registration order decides the dependencies: a pass follows every earlier pass it shares a resource with where either side writes, and a pass that
+// declares nothing keeps its place relative to all others. Of the passes that are ready, the one that continues the current rendering scope goes first,
+// then one on the same queue, then the one whose inputs were produced longest ago; ties keep registration order.
+inline auto SchedulePasses(RenderGraph& renderGraph) noexcept -> void
+{
+    std::vector<std::uint32_t>& compiled{renderGraph.plan.compiled};
+    const auto count{static_cast<std::uint32_t>(compiled.size())};
+    std::vector<std::vector<std::uint32_t>> successors(count);
+    std::vector<std::uint32_t> pending(count, 0U); // predecessors not scheduled yet
+    const auto addEdge = [&successors, &pending](const std::uint32_t from, const std::uint32_t to)
+    {
+        if (from != ~0U)
+        {
+            successors[from].emplace_back(to);
+            ++pending[to];
+        }
+    };
+
+    std::vector<std::uint32_t> lastWriter(renderGraph.resources.size(), ~0U);
+    std::vector<std::vector<std::uint32_t>> readers(renderGraph.resources.size()); // since the last write
+    std::vector<ResourceUse> uses{};
+    std::uint32_t lastOpaque{~0U};
+    for (std::uint32_t i{}; i < count; ++i)
+    {
+        CollectUses(CompiledPass(renderGraph, i), uses);
+        if (uses.empty())
+        {
+            for (std::uint32_t earlier{lastOpaque == ~0U ? 0U : lastOpaque}; earlier < i; ++earlier)
+            {
+                addEdge(earlier, i);
+            }
+            lastOpaque = i;
+            continue;
+        }
+        addEdge(lastOpaque, i);
+        for (const ResourceUse& use : uses)
+        {
+            addEdge(lastWriter[use.resource], i);
+            if (!use.isWrite)
+            {
+                readers[use.resource].emplace_back(i);
+                continue;
+            }
+            for (const std::uint32_t reader : readers[use.resource])
+            {
+                addEdge(reader, i);
+            }
+            readers[use.resource].clear();
+            lastWriter[use.resource] = i;
+        }
+    }
+
+    const auto continuesScope = [](const RenderPass* previous, const RenderPass* next)
+    {
+        return previous != nullptr && !previous->isCompute && !next->isCompute && ColorTarget(previous) == ColorTarget(next) && previous->depthResource == next->depthResource
+            && previous->isDepthReadOnly == next->isDepthReadOnly;
+    };
+    std::vector<std::uint32_t> readyAt(count, 0U); // position right after its latest predecessor
+    std::vector<bool> isScheduled(count, false);
+    std::vector<std::uint32_t> order{};
+    order.reserve(count);
+    const RenderPass* previous{nullptr};
+    for (std::uint32_t position{}; position < count; ++position)
+    {
+        const auto rank = [&](const std::uint32_t i)
+        {
+            const RenderPass* pass{CompiledPass(renderGraph, i)};
+            return std::tuple{!continuesScope(previous, pass), previous == nullptr || QueueOf(previous) != QueueOf(pass), readyAt[i], i};
+        };
+        std::uint32_t best{~0U};
+        for (std::uint32_t i{}; i < count; ++i)
+        {
+            if (!isScheduled[i] && pending[i] == 0U && (best == ~0U || rank(i) < rank(best)))
+            {
+                best = i;
+            }
+        }
+        isScheduled[best] = true;
+        previous          = CompiledPass(renderGraph, best);
+        order.emplace_back(compiled[best]);
+        for (const std::uint32_t next : successors[best])
+        {
+            --pending[next];
+            readyAt[next] = position + 1U;
+        }
+    }
+    compiled = std::move(order);
+}
+
+inline auto ReleaseTransients(const Renderer& renderer, CompiledPlan& plan) noexcept -> void
+{
+    for (PlanTransient& transient : plan.transients)
+    {
+        if (transient.isRealized)
+        {
+            Cleanup(renderer, transient.texture);
+        }
+    }
+    plan.transients.clear();
+    for (deer_vulkan::DeviceMemory& memory : plan.transientMemory)
+    {
+        Cleanup(renderer.dispatch, renderer.device, memory);
+    }
+    plan.transientMemory.clear();
+}
+
+// Like ReleaseTransients, but for a plan frames in flight may still use: its images are destroyed once the last frame that used it is done,
+// and its memory goes to the pool.
+inline auto RetireTransients(RenderGraph& renderGraph, CompiledPlan& plan) noexcept -> void
+{
+    for (PlanTransient& transient : plan.transients)
+    {
+        if (transient.isRealized)
+        {
+            renderGraph.retiredTextures.emplace_back(RetiredTexture{.texture = transient.texture, .frameValue = plan.lastFrameValue});
+        }
+    }
+    plan.transients.clear();
+    for (const deer_vulkan::DeviceMemory& memory : plan.transientMemory)
+    {
+        if (memory.memory != nullptr)
+        {
+            renderGraph.memoryPool.emplace_back(PooledMemory{.memory = memory, .frameValue = plan.lastFrameValue, .pooledFrame = renderGraph.frameCount});
+        }
+    }
+    plan.transientMemory.clear();
+}
+
+// Retires the memory blocks marked in isRetired, together with all of their occupants, and renumbers the blocks that stay.
+// The plan keeps its passes and lifetimes; RealizeTransients only has to fill in what was retired.
+inline auto RetireBlocks(RenderGraph& renderGraph, CompiledPlan& plan, const std::vector<bool>& isRetired) noexcept -> void
+{
+    std::vector<std::uint32_t> remap(plan.transientMemory.size(), ~0U);
+    std::uint32_t kept{};
+    for (std::uint32_t b{}; b < plan.transientMemory.size(); ++b)
+    {
+        if (isRetired[b])
+        {
+            renderGraph.memoryPool.emplace_back(PooledMemory{.memory = plan.transientMemory[b], .frameValue = plan.lastFrameValue, .pooledFrame = renderGraph.frameCount});
+            continue;
+        }
+        remap[b]                     = kept;
+        plan.transientMemory[kept++] = plan.transientMemory[b];
+    }
+    plan.transientMemory.resize(kept);
+
+    for (PlanTransient& transient : plan.transients)
+    {
+        if (!transient.isRealized)
+        {
+            continue;
+        }
+        if (isRetired[transient.block])
+        {
+            renderGraph.retiredTextures.emplace_back(RetiredTexture{.texture = transient.texture, .frameValue = plan.lastFrameValue});
+            transient.texture          = {};
+            transient.block            = ~0U;
+            transient.aliasPredecessor = ~0U;
+            transient.isRealized       = false;
+            continue;
+        }
+        transient.block = remap[transient.block];
+    }
+}
+
+// Retires every memory block of the plan that holds a swap chain relative transient.
+inline auto RetireSwapChainRelative(RenderGraph& renderGraph, CompiledPlan& plan) noexcept -> void
+{
+    std::vector<bool> isRetired(plan.transientMemory.size(), false);
+    for (std::uint32_t i{}; i < plan.transients.size(); ++i)
+    {
+        if (plan.transients[i].isRealized && renderGraph.transients[i].swapChainScale > 0.0F)
+        {
+            isRetired[plan.transients[i].block] = true;
+        }
+    }
+    RetireBlocks(renderGraph, plan, isRetired);
+}
+
+// Retires all of a plan's blocks as it goes into the cache, so cached plans hold no memory and only the active one does. The next plan takes the blocks from
+// the pool once the frames that used them are done; the parked plan realizes its transients again when it is selected.
+inline auto ParkPlan(RenderGraph& renderGraph, CompiledPlan& plan) noexcept -> void
+{
+    RetireBlocks(renderGraph, plan, std::vector<bool>(plan.transientMemory.size(), true));
+}
+
+// Destroys retired images the GPU is done with and frees pooled memory nobody took for g_memoryPoolFrames frames.
+inline auto CollectRetired(const Renderer& renderer, RenderGraph& renderGraph) noexcept -> void
+{
+    if (renderGraph.retiredTextures.empty() && renderGraph.memoryPool.empty())
+    {
+        return;
+    }
+    GFX_CHECK_VOID(deer_vulkan::GetValue(renderer.dispatch, renderer.device, renderer.timelineSemaphore, renderGraph.completedFrameValue), "reading the frame timeline")
+
+    std::erase_if(renderGraph.retiredTextures,
+                  [&renderer, &renderGraph](RetiredTexture& retired)
+                  {
+                      if (retired.frameValue > renderGraph.completedFrameValue)
+                      {
+                          return false;
+                      }
+                      Cleanup(renderer, retired.texture);
+                      return true;
+                  });
+    std::erase_if(renderGraph.memoryPool,
+                  [&renderer, &renderGraph](PooledMemory& pooled)
+                  {
+                      if (pooled.frameValue > renderGraph.completedFrameValue || renderGraph.frameCount - pooled.pooledFrame < g_memoryPoolFrames)
+                      {
+                          return false;
+                      }
+                      Cleanup(renderer.dispatch, renderer.device, pooled.memory);
+                      return true;
+                  });
+}
+
+// Takes the smallest pooled block that is big enough, of a usable memory type and no longer used by a frame in flight.
+// A block more than twice the size asked for is left for a bigger target.
+[[nodiscard]] inline auto TakePooledMemory(RenderGraph& renderGraph, const std::uint64_t size, const std::uint32_t memoryTypeBits,
+                                           deer_vulkan::DeviceMemory& memory) noexcept -> bool
+{
+    auto best{renderGraph.memoryPool.end()};
+    for (auto it{renderGraph.memoryPool.begin()}; it != renderGraph.memoryPool.end(); ++it)
+    {
+        if (it->frameValue <= renderGraph.completedFrameValue && (memoryTypeBits >> it->memory.memoryType & 1U) != 0U && it->memory.size >= size
+            && it->memory.size / 2U <= size && (best == renderGraph.memoryPool.end() || it->memory.size < best->memory.size))
+        {
+            best = it;
+        }
+    }
+    if (best == renderGraph.memoryPool.end())
+    {
+        return false;
+    }
+    memory = best->memory;
+    renderGraph.memoryPool.erase(best);
+    return true;
+}
+
+inline auto ComputeTransientLifetimes(RenderGraph& renderGraph) noexcept -> void
+{
+    renderGraph.plan.transients.assign(renderGraph.transients.size(), PlanTransient{});
+
+    constexpr std::uint64_t attachmentAccess{AccessBits(memory_access::color_attachment_read | memory_access::color_attachment_write
+                                                        | memory_access::depth_stencil_attachment_read | memory_access::depth_stencil_attachment_write)};
+    std::vector<ResourceUse> uses{};
+    for (std::uint32_t i{}; i < renderGraph.plan.compiled.size(); ++i)
+    {
+        CollectUses(CompiledPass(renderGraph, i), uses);
+        for (const ResourceUse& use : uses)
+        {
+            if (const std::uint32_t index{renderGraph.resources[use.resource].transient}; index != ~0U)
+            {
+                PlanTransient& transient{renderGraph.plan.transients[index]};
+                transient.firstPass = transient.firstPass == ~0U ? i : transient.firstPass;
+                transient.lastPass  = i;
+                transient.queueMask |= static_cast<std::uint8_t>(1U << QueueOf(CompiledPass(renderGraph, i)));
+                transient.isAttachmentOnly = transient.isAttachmentOnly && (use.access & ~attachmentAccess) == 0U;
+            }
+        }
+    }
+}
+
+// Creates an image for every transient a compiled pass uses that does not have one yet and packs them into as few new memory blocks as their lifetimes allow.
+// Largest first, each goes into the first block whose occupants run on the same single queue and are all dead before it starts or born after it ends.
+// Every occupant sits at offset 0, so the first (largest) one sizes the block and alignment never comes into play. Blocks come from the pool where one fits.
+// Attachment-only transients get blocks of their own, allocated as transient memory so they are lazily allocated where the device supports it.
+[[nodiscard]] inline auto RealizeTransients(const Renderer& renderer, RenderGraph& renderGraph) noexcept -> gfx_status
+{
+    struct MemoryBlock
+    {
+        std::uint64_t size{};
+        std::uint32_t memoryTypeBits{};
+        bool isAttachmentOnly{};
+        std::vector<std::uint32_t> occupants{};
+    };
+
+    std::vector<std::uint32_t> order{};
+    std::vector<deer_vulkan::ImageMemoryRequirements> requirements(renderGraph.plan.transients.size());
+    for (std::uint32_t i{}; i < renderGraph.plan.transients.size(); ++i)
+    {
+        PlanTransient& transient{renderGraph.plan.transients[i]};
+        if (transient.firstPass == ~0U || transient.isRealized)
+        {
+            continue;
+        }
+        GFX_CHECK(deer_vulkan::InitializeUnbound(renderer.dispatch, renderer.device, RenderTargetImageInfo(renderGraph.transients[i].createInfo, transient.isAttachmentOnly),
+                                                 transient.texture.image),
+                  "Failed to Initialize transient image {}.", i)
+        transient.isRealized = true;
+        requirements[i]      = deer_vulkan::GetMemoryRequirements(renderer.dispatch, renderer.device, transient.texture.image);
+        order.emplace_back(i);
+    }
+    std::ranges::stable_sort(order,
+                             [&requirements](const std::uint32_t lhs, const std::uint32_t rhs)
+                             {
+                                 return requirements[lhs].size > requirements[rhs].size;
+                             });
+
+    const auto firstBlock{static_cast<std::uint32_t>(renderGraph.plan.transientMemory.size())};
+    std::vector<MemoryBlock> blocks{};
+    for (const std::uint32_t index : order)
+    {
+        PlanTransient& transient{renderGraph.plan.transients[index]};
+        const auto fits = [&](const MemoryBlock& block)
+        {
+            return (block.memoryTypeBits & requirements[index].memoryTypeBits) != 0U && block.size >= requirements[index].size
+                && block.isAttachmentOnly == transient.isAttachmentOnly
+                && std::ranges::all_of(block.occupants,
+                                       [&](const std::uint32_t other)
+                                       {
+                                           const PlanTransient& occupant{renderGraph.plan.transients[other]};
+                                           return occupant.queueMask == transient.queueMask && std::has_single_bit(transient.queueMask)
+                                               && (occupant.lastPass < transient.firstPass || transient.lastPass < occupant.firstPass);
+                                       });
+        };
+
+        auto it{std::ranges::find_if(blocks, fits)};
+        if (it == blocks.end())
+        {
+            it = blocks.insert(blocks.end(), MemoryBlock{.size             = requirements[index].size,
+                                                         .memoryTypeBits   = requirements[index].memoryTypeBits,
+                                                         .isAttachmentOnly = transient.isAttachmentOnly});
+        }
+        it->memoryTypeBits &= requirements[index].memoryTypeBits;
+        it->occupants.emplace_back(index);
+        transient.block = firstBlock + static_cast<std::uint32_t>(std::distance(blocks.begin(), it));
+    }
+
+    renderGraph.plan.transientMemory.resize(firstBlock + blocks.size());
+    for (std::uint32_t b{firstBlock}; b < renderGraph.plan.transientMemory.size(); ++b)
+    {
+        MemoryBlock& block{blocks[b - firstBlock]};
+        if (!TakePooledMemory(renderGraph, block.size, block.memoryTypeBits, renderGraph.plan.transientMemory[b]))
+        {
+            GFX_CHECK(deer_vulkan::Initialize(renderer.dispatch, renderer.device, renderer.physical, block.size, block.memoryTypeBits,
+                                              static_cast<std::uint32_t>(memory_property::device_local),
+                                              block.isAttachmentOnly ? deer_vulkan::memory_usage::transient : deer_vulkan::memory_usage::gpu_only,
+                                              renderGraph.plan.transientMemory[b]),
+                      "Failed to allocate transient memory block {} ({} bytes).", b, block.size)
+        }
+
+        // In execution order every occupant follows the previous one, and the first follows the last of the frame before.
+        std::ranges::sort(block.occupants, {}, [&renderGraph](const std::uint32_t index) { return renderGraph.plan.transients[index].firstPass; });
+        for (std::size_t o{}; o < block.occupants.size(); ++o)
+        {
+            PlanTransient& transient{renderGraph.plan.transients[block.occupants[o]]};
+            transient.aliasPredecessor = renderGraph.transients[block.occupants[(o + block.occupants.size() - 1U) % block.occupants.size()]].resource;
+
+            GFX_CHECK(deer_vulkan::Bind(renderer.dispatch, renderer.device, transient.texture.image, renderGraph.plan.transientMemory[b].memory, 0U),
+                      "Failed to bind transient image to block {}.", b)
+            if (const gfx_status status{InitializeRenderTargetViews(renderer, renderGraph.transients[block.occupants[o]].createInfo, transient.texture)};
+                status != gfx_status::ok) [[unlikely]]
+            {
+                return status;
+            }
+        }
+    }
+    return gfx_status::ok;
+}
+
+// A target is loaded when an earlier pass of the frame used it and cleared otherwise. Its contents are stored unless it is a transient nobody reads afterwards;
+// imported targets and the swap chain always keep theirs, since the next frame or the outside world may want them. A read-only depth target is loaded and
+// never written back.
+inline auto InferAttachmentOps(RenderGraph& renderGraph) noexcept -> void
+{
+    std::vector<std::uint32_t> firstUse(renderGraph.resources.size(), ~0U);
+    std::vector<std::uint32_t> lastRead(renderGraph.resources.size(), ~0U);
+    std::vector<ResourceUse> uses{};
+    for (std::uint32_t i{}; i < renderGraph.plan.compiled.size(); ++i)
+    {
+        CollectUses(CompiledPass(renderGraph, i), uses);
+        for (const ResourceUse& use : uses)
+        {
+            firstUse[use.resource] = std::min(firstUse[use.resource], i);
+            lastRead[use.resource] = ReadsResource(use) ? i : lastRead[use.resource];
+        }
+    }
+
+    const auto loadOp = [&firstUse](const std::uint32_t resource, const std::uint32_t pass)
+    {
+        return firstUse[resource] < pass ? attachment_load_op::load : attachment_load_op::clear;
+    };
+    const auto storeOp = [&renderGraph, &lastRead](const std::uint32_t resource, const std::uint32_t pass)
+    {
+        const GraphResource& graphResource{renderGraph.resources[resource]};
+        const bool isKept{graphResource.transient == ~0U || graphResource.isExported || (lastRead[resource] != ~0U && lastRead[resource] > pass)};
+        return isKept ? attachment_store_op::store : attachment_store_op::dont_care;
+    };
+
+    renderGraph.plan.attachmentOps.assign(renderGraph.plan.compiled.size(), AttachmentOps{});
+    for (std::uint32_t i{}; i < renderGraph.plan.compiled.size(); ++i)
+    {
+        const RenderPass* renderPass{CompiledPass(renderGraph, i)};
+        if (renderPass->isCompute)
+        {
+            continue;
+        }
+
+        AttachmentOps& ops{renderGraph.plan.attachmentOps[i]};
+        if (const std::uint32_t color{ColorTarget(renderPass)}; color != ~0U)
+        {
+            ops.colorLoad  = loadOp(color, i);
+            ops.colorStore = storeOp(color, i);
+        }
+        if (const std::uint32_t depth{renderPass->depthResource}; depth != ~0U)
+        {
+            ops.depthLoad  = renderPass->isDepthReadOnly ? attachment_load_op::load : loadOp(depth, i);
+            ops.depthStore = renderPass->isDepthReadOnly ? attachment_store_op::none : storeOp(depth, i);
+        }
+    }
+}
+
+// Folds a raster pass into the rendering scope of the pass before it when both render to the same targets in the same way and
+// the only barriers in between are on those targets and keep their layout. Draws within one scope are already ordered on the attachments,
+// so those barriers are dropped; anything else between the two (a layout change, a sampled texture that still needs a barrier) keeps them apart.
+inline auto MergeRenderingScopes(RenderGraph& renderGraph) noexcept -> void
+{
+    CompiledPlan& plan{renderGraph.plan};
+    const auto barriersOf = [&plan](const std::uint32_t pass)
+    {
+        return std::span{plan.barriers}.subspan(plan.barrierOffsets[pass], plan.barrierOffsets[pass + 1U] - plan.barrierOffsets[pass]);
+    };
+    const auto canMerge = [&renderGraph, &plan, &barriersOf](const std::uint32_t pass)
+    {
+        const RenderPass* previous{CompiledPass(renderGraph, pass - 1U)};
+        const RenderPass* current{CompiledPass(renderGraph, pass)};
+        if (previous->isCompute || current->isCompute || plan.passBatches[pass - 1U] != plan.passBatches[pass] || ColorTarget(previous) != ColorTarget(current)
+            || previous->depthResource != current->depthResource || previous->isDepthReadOnly != current->isDepthReadOnly)
+        {
+            return false;
+        }
+        return std::ranges::all_of(barriersOf(pass),
+                                   [current](const GraphBarrier& barrier)
+                                   {
+                                       return (barrier.resource == ColorTarget(current) || barrier.resource == current->depthResource) && barrier.oldLayout == barrier.newLayout
+                                           && barrier.srcQueueFamily == barrier.dstQueueFamily;
+                                   });
+    };
+
+    std::vector<bool> isMerged(plan.compiled.size(), false);
+    plan.scopeOffsets.clear();
+    for (std::uint32_t b{}; b < plan.batches.size(); ++b)
+    {
+        SubmitBatch& batch{plan.batches[b]};
+        batch.firstScope = static_cast<std::uint32_t>(plan.scopeOffsets.size());
+        for (std::uint32_t i{batch.firstPass}; i < batch.firstPass + batch.passCount; ++i)
+        {
+            isMerged[i] = i != batch.firstPass && canMerge(i);
+            if (!isMerged[i])
+            {
+                plan.scopeOffsets.emplace_back(i);
+            }
+        }
+        batch.scopeCount = static_cast<std::uint32_t>(plan.scopeOffsets.size()) - batch.firstScope;
+    }
+    plan.scopeOffsets.emplace_back(static_cast<std::uint32_t>(plan.compiled.size()));
+
+    std::vector<GraphBarrier> barriers{};
+    std::vector<std::uint32_t> offsets{};
+    for (std::uint32_t range{}; range + 1U < plan.barrierOffsets.size(); ++range)
+    {
+        offsets.emplace_back(static_cast<std::uint32_t>(barriers.size()));
+        if (range >= plan.compiled.size() || !isMerged[range])
+        {
+            const std::span<const GraphBarrier> kept{barriersOf(range)};
+            barriers.insert(barriers.end(), kept.begin(), kept.end());
+        }
+    }
+    offsets.emplace_back(static_cast<std::uint32_t>(barriers.size()));
+    plan.barriers       = std::move(barriers);
+    plan.barrierOffsets = std::move(offsets);
+}
+
+// Takes the barriers out of the plan that can be split: those whose resource was last touched at least one whole rendering scope earlier in the same batch.
+// Merged scopes only keep barriers at their start, and a scope is one command buffer, so both halves are recorded outside a rendering scope and on one queue.
+// Ownership transfers and the final present transition stay whole.
+inline auto SplitBarriers(RenderGraph& renderGraph) noexcept -> void
+{
+    CompiledPlan& plan{renderGraph.plan};
+    std::vector<std::uint32_t> scopeOf(plan.compiled.size());
+    for (std::uint32_t scope{}; scope + 1U < plan.scopeOffsets.size(); ++scope)
+    {
+        std::fill(scopeOf.begin() + plan.scopeOffsets[scope], scopeOf.begin() + plan.scopeOffsets[scope + 1U], scope);
+    }
 
-// ---------------------------------------------------------------------------
-// Pass registration
-// ---------------------------------------------------------------------------
+    std::vector<std::uint32_t> lastTouch(renderGraph.resources.size(), ~0U);
+    std::vector<ResourceUse> uses{};
+    std::vector<GraphBarrier> barriers{};
+    std::vector<std::uint32_t> offsets{};
+    plan.splitBarriers.clear();
+    for (std::uint32_t range{}; range + 1U < plan.barrierOffsets.size(); ++range)
+    {
+        offsets.emplace_back(static_cast<std::uint32_t>(barriers.size()));
+        for (std::uint32_t b{plan.barrierOffsets[range]}; b < plan.barrierOffsets[range + 1U]; ++b)
+        {
+            const GraphBarrier& barrier{plan.barriers[b]};
+            const std::uint32_t previous{range < plan.compiled.size() ? lastTouch[barrier.resource] : ~0U};
+            if (previous != ~0U && plan.passBatches[previous] == plan.passBatches[range] && scopeOf[previous] + 1U < scopeOf[range]
+                && barrier.srcQueueFamily == barrier.dstQueueFamily)
+            {
+                plan.splitBarriers.emplace_back(SplitBarrier{.barrier = barrier, .setScope = scopeOf[previous], .waitScope = scopeOf[range]});
+                continue;
+            }
+            barriers.emplace_back(barrier);
+        }
+        if (range < plan.compiled.size())
+        {
+            CollectUses(CompiledPass(renderGraph, range), uses);
+            for (const ResourceUse& use : uses)
+            {
+                lastTouch[use.resource] = range;
+            }
+        }
+    }
+    offsets.emplace_back(static_cast<std::uint32_t>(barriers.size()));
+    plan.barriers       = std::move(barriers);
+    plan.barrierOffsets = std::move(offsets);
+}
 
-export template <class PassData>
-auto SetRenderFunc(RenderGraph& renderGraph, RenderPassHandle& handle, std::function<void(const PassData*, const RenderPassContext&)>&& renderFunc) noexcept -> void
+// Everything after transient placement: barriers, rendering scopes and split barriers, in that order since each reworks the barriers of the one before.
+inline auto CompileSynchronization(const Renderer& renderer, RenderGraph& renderGraph) noexcept -> void
+{
+    CompileBarriers(renderer, renderGraph);
+    MergeRenderingScopes(renderGraph);
+    SplitBarriers(renderGraph);
+}
+
+[[nodiscard]] inline auto CompileRenderGraph(const Renderer& renderer, RenderGraph& renderGraph) noexcept -> gfx_status
 {
-    if (RenderPassBase* base{renderGraph.passes[handle.index]}; base != nullptr) [[likely]]
+    BALBINO_PROFILE_ZONE("CompileRenderGraph");
+    renderGraph.plan.compiled.clear();
+    for (const RenderPass& renderPass : renderGraph.passes)
+    {
+        if (renderPass.isEnabled)
+        {
+            renderGraph.plan.compiled.emplace_back(renderPass.index);
+        }
+    }
+    CullPasses(renderGraph);
+    SchedulePasses(renderGraph);
+
+    // Only a change of queue starts a new batch.
+    renderGraph.plan.batches.clear();
+    renderGraph.plan.passBatches.clear();
+    for (std::uint32_t i{}; i < renderGraph.plan.compiled.size(); ++i)
+    {
+        const std::uint8_t queueId{QueueOf(CompiledPass(renderGraph, i))};
+        if (renderGraph.plan.batches.empty() || renderGraph.plan.batches.back().queueId != queueId)
+        {
+            renderGraph.plan.batches.emplace_back(SubmitBatch{.firstPass = i, .passCount = 0U, .queueId = queueId});
+        }
+        ++renderGraph.plan.batches.back().passCount;
+        renderGraph.plan.passBatches.emplace_back(static_cast<std::uint32_t>(renderGraph.plan.batches.size() - 1U));
+    }
+
+    InferAttachmentOps(renderGraph);
+    ComputeTransientLifetimes(renderGraph);
+    if (const gfx_status status{RealizeTransients(renderer, renderGraph)}; status != gfx_status::ok) [[unlikely]]
     {
-        static_cast<RenderPass<PassData>*>(base)->renderFunction = std::move(renderFunc);
+        return status;
     }
+
+    CompileSynchronization(renderer, renderGraph);
+    return gfx_status::ok;
 }
 
-export template <class PassData>
-[[nodiscard]] auto AddComputeRenderPass(RenderGraph& renderGraph, PassData*& passData) noexcept -> RenderPassHandle
+// The configuration a plan depends on, flattened: the enabled passes with their targets and uses, which resources exist and are exported,
+// and what every transient looks like. Swap chain relative transients count by their scale, so a resize keeps the plans and only re-creates those.
+inline auto BuildSignature(const RenderGraph& renderGraph, std::vector<std::uint64_t>& signature) noexcept -> void
 {
-    const std::size_t idx = renderGraph.passes.size();
+    signature.clear();
+    signature.emplace_back(renderGraph.resources.size());
+    for (const GraphResource& resource : renderGraph.resources)
+    {
+        signature.emplace_back(static_cast<std::uint64_t>(resource.transient) << 32U | (resource.image != nullptr ? 2U : 0U) | (resource.isExported ? 1U : 0U));
+    }
+    for (const TransientTexture& transient : renderGraph.transients)
+    {
+        const RenderTextureCreateInfo& info{transient.createInfo};
+        signature.emplace_back(static_cast<std::uint64_t>(info.imageFormat) << 32U | static_cast<std::uint64_t>(info.aspect));
+        signature.emplace_back(transient.swapChainScale > 0.0F ? std::bit_cast<std::uint32_t>(transient.swapChainScale)
+                                                               : static_cast<std::uint64_t>(info.width) << 32U | info.height);
+    }
+    for (const RenderPass& pass : renderGraph.passes)
+    {
+        const RenderPass* renderPass{&pass};
+        if (!renderPass->isEnabled)
+        {
+            continue;
+        }
+        signature.emplace_back(static_cast<std::uint64_t>(renderPass->index) << 32U | (IsSwapChainPass(renderPass) ? 4U : 0U) | (renderPass->isDepthReadOnly ? 2U : 0U)
+                               | (renderPass->isCompute ? 1U : 0U));
+        signature.emplace_back(static_cast<std::uint64_t>(renderPass->colorResource) << 32U | renderPass->depthResource);
+        for (const ResourceUse& use : renderPass->uses)
+        {
+            signature.emplace_back(static_cast<std::uint64_t>(use.resource) << 32U | static_cast<std::uint64_t>(use.layout) << 1U | (use.isWrite ? 1U : 0U));
+            signature.emplace_back(use.stage);
+            signature.emplace_back(use.access);
+        }
+    }
+}
 
-    auto* rp   = new (std::nothrow) RenderPass<PassData>{};
-    auto* data = new (std::nothrow) PassData{};
-    if (!rp || !data) [[unlikely]]
+// FNV-1a over the signature words.
+[[nodiscard]] constexpr auto HashSignature(const std::span<const std::uint64_t> signature) noexcept -> std::uint64_t
+{
+    constexpr std::uint64_t prime{1099511628211ULL};
+    std::uint64_t hash{14695981039346656037ULL};
+    for (const std::uint64_t value : signature)
     {
-        delete rp;
-        delete data;
-        return {};
+        hash = (hash ^ value) * prime;
     }
+    return hash;
+}
 
-    Initialize(rp, /*isCompute=*/true, static_cast<std::int32_t>(idx), data);
-    passData = rp->data;
-    renderGraph.passes.emplace_back(rp);
-    renderGraph.dirty = true;
-    return RenderPassHandle{idx};
+// Hands the transients the images of the active plan.
+inline auto ActivatePlan(RenderGraph& renderGraph) noexcept -> void
+{
+    for (std::uint32_t i{}; i < renderGraph.transients.size(); ++i)
+    {
+        renderGraph.transients[i].texture = i < renderGraph.plan.transients.size() ? renderGraph.plan.transients[i].texture : Texture{};
+    }
 }
 
-export template <class PassData>
-[[nodiscard]] auto AddRasterRenderPass(RenderGraph& renderGraph, PassData*& passData) noexcept -> RenderPassHandle
+// Drops the least recently used cached plan; its transients go once the last frame that used them is done.
+inline auto EvictPlan(RenderGraph& renderGraph) noexcept -> void
 {
-    const std::size_t idx = renderGraph.passes.size();
+    const auto oldest{std::ranges::min_element(renderGraph.planCache, {}, &CompiledPlan::lastFrameValue)};
+    RetireTransients(renderGraph, *oldest);
+    renderGraph.planCache.erase(oldest);
+}
+
+// Follows a change of the swap chain extent: the relative transients get their new size, and the active plan lets go of the blocks they live in.
+// Nothing waits for the GPU; a plan realizes what it lost the next time it is selected.
+inline auto ResizeTransients(const Renderer& renderer, RenderGraph& renderGraph) noexcept -> void
+{
+    renderGraph.swapChainWidth  = renderer.swapChain.extent.width;
+    renderGraph.swapChainHeight = renderer.swapChain.extent.height;
 
-    auto* rp   = new (std::nothrow) RenderPass<PassData>{};
-    auto* data = new (std::nothrow) PassData{};
-    if (!rp || !data) [[unlikely]]
+    bool hasRelative{false};
+    for (TransientTexture& transient : renderGraph.transients)
     {
-        delete rp;
-        delete data;
-        return {};
+        if (transient.swapChainScale > 0.0F)
+        {
+            transient.createInfo.width  = ScaledExtent(renderGraph.swapChainWidth, transient.swapChainScale);
+            transient.createInfo.height = ScaledExtent(renderGraph.swapChainHeight, transient.swapChainScale);
+            hasRelative                 = true;
+        }
+    }
+    if (!hasRelative)
+    {
+        return;
     }
 
-    Initialize(rp, /*isCompute=*/false, static_cast<std::int32_t>(idx), data);
-    passData = rp->data;
-    renderGraph.passes.emplace_back(rp);
+    RetireSwapChainRelative(renderGraph, renderGraph.plan); // cached plans are parked and hold no blocks
     renderGraph.dirty = true;
-    return RenderPassHandle{idx};
 }
 
-// ---------------------------------------------------------------------------
-// Pass configuration
-// ---------------------------------------------------------------------------
-
-export inline auto EnableRenderPass(RenderGraph& renderGraph, const RenderPassHandle& handle) noexcept -> void
+// Realizes the transients the active plan lost to a resize or to being parked. Aliasing decides which barriers a transient's first use needs, so those are compiled again.
+[[nodiscard]] inline auto RefreshPlan(const Renderer& renderer, RenderGraph& renderGraph) noexcept -> gfx_status
 {
-    if (RenderPassBase* pass{renderGraph.passes[handle.index]}; pass != nullptr) [[likely]]
+    if (std::ranges::any_of(renderGraph.plan.transients,
+                            [](const PlanTransient& transient)
+                            {
+                                return transient.firstPass != ~0U && !transient.isRealized;
+                            }))
     {
-        pass->isEnabled   = true;
-        renderGraph.dirty = true;
+        if (const gfx_status status{RealizeTransients(renderer, renderGraph)}; status != gfx_status::ok) [[unlikely]]
+        {
+            return status;
+        }
+        CompileSynchronization(renderer, renderGraph);
     }
+    ActivatePlan(renderGraph);
+    return gfx_status::ok;
 }
 
-export inline auto DisableRenderPass(RenderGraph& renderGraph, const RenderPassHandle& handle) noexcept -> void
+// Makes the plan for the graph's current configuration the active one. If it already is, or an earlier configuration matches, that plan is swapped in and only realizes
+// the transients it was parked or resized without; only a configuration that was never seen (or fell out of the cache) is compiled. The plan that was active moves into the cache.
+[[nodiscard]] inline auto SelectPlan(const Renderer& renderer, RenderGraph& renderGraph) noexcept -> gfx_status
 {
-    if (RenderPassBase* pass{renderGraph.passes[handle.index]}; pass != nullptr) [[likely]]
+    BuildSignature(renderGraph, renderGraph.signature);
+    const std::uint64_t hash{HashSignature(renderGraph.signature)};
+    const auto matches = [&renderGraph, hash](const CompiledPlan& plan)
     {
-        pass->isEnabled   = false;
+        return plan.hash == hash && plan.signature == renderGraph.signature;
+    };
+
+    const auto fail = [&renderGraph](const gfx_status status)
+    {
+        RetireTransients(renderGraph, renderGraph.plan);
+        renderGraph.plan  = {};
         renderGraph.dirty = true;
+        ActivatePlan(renderGraph);
+        return status;
+    };
+
+    renderGraph.dirty = false;
+    if (!matches(renderGraph.plan))
+    {
+        if (const auto cached{std::ranges::find_if(renderGraph.planCache, matches)}; cached != renderGraph.planCache.end())
+        {
+            std::swap(renderGraph.plan, *cached);
+            ParkPlan(renderGraph, *cached);
+        }
+    }
+    if (matches(renderGraph.plan))
+    {
+        const gfx_status status{RefreshPlan(renderer, renderGraph)};
+        return status == gfx_status::ok ? status : fail(status);
     }
+
+    if (!renderGraph.plan.signature.empty())
+    {
+        if (renderGraph.planCache.size() == g_maxCachedPlans)
+        {
+            EvictPlan(renderGraph);
+        }
+        ParkPlan(renderGraph, renderGraph.plan);
+        renderGraph.planCache.emplace_back(std::move(renderGraph.plan));
+    }
+    renderGraph.plan = CompiledPlan{.signature = renderGraph.signature, .hash = hash};
+    if (const gfx_status status{CompileRenderGraph(renderer, renderGraph)}; status != gfx_status::ok) [[unlikely]]
+    {
+        return fail(status);
+    }
+    ActivatePlan(renderGraph);
+    return gfx_status::ok;
 }
 
-export inline auto SetRenderTarget(RenderGraph& renderGraph, const RenderPassHandle& handle, Texture& color, Texture& depth) noexcept -> void
+// Imported images that were left in another layout than the plan expects (first frame, uploads, ...) are moved there once.
+// Only the subresources that are elsewhere are moved, each from the layout it is tracked in.
+inline auto RecordLayoutFixups(const Renderer& renderer, const RenderGraph& renderGraph, RecordScratch& scratch, const deer_vulkan::CommandBuffer& commandBuffer) noexcept -> void
 {
-    if (RenderPassBase* pass{renderGraph.passes[handle.index]}; pass != nullptr) [[likely]]
+    scratch.imageBarriers.clear();
+    for (std::uint32_t i{1U}; i < renderGraph.resources.size(); ++i)
     {
-        pass->colorImage     = &color.image;
-        pass->colorImageView = &color.view;
-        pass->depthImage     = &depth.image;
-        pass->depthImageView = &depth.view;
-        renderGraph.dirty    = true;
+        const GraphResource& resource{renderGraph.resources[i]};
+        const auto startLayout{static_cast<std::uint32_t>(renderGraph.plan.resources[i].startLayout)};
+        if (resource.image == nullptr || startLayout == static_cast<std::uint32_t>(image_layout::undefined))
+        {
+            continue;
+        }
+        deer_vulkan::ForEachLayoutRun(*resource.image, startLayout, 0U, ~0U, 0U, ~0U,
+                                      [&scratch, &resource, startLayout](const std::uint32_t mipOffset, const std::uint32_t mipCount, const std::uint32_t layerOffset,
+                                                                         const std::uint32_t layerCount, const auto oldLayout)
+                                      {
+                                          scratch.imageBarriers.emplace_back(deer_vulkan::ImageBarrier{
+                                              .image       = resource.image,
+                                              .srcStage    = StageBits(pipeline_stage::all_commands),
+                                              .srcAccess   = AccessBits(memory_access::memory_write),
+                                              .dstStage    = StageBits(pipeline_stage::all_commands),
+                                              .dstAccess   = AccessBits(memory_access::memory_read | memory_access::memory_write),
+                                              .oldLayout   = static_cast<std::uint32_t>(oldLayout),
+                                              .newLayout   = startLayout,
+                                              .mipOffset   = mipOffset,
+                                              .mipCount    = mipCount,
+                                              .layerOffset = layerOffset,
+                                              .layerCount  = layerCount});
+                                      });
     }
+    deer_vulkan::PipelineBarrier(renderer.dispatch, commandBuffer, scratch.imageBarriers, {}, /*trackLayouts=*/false);
 }
 
-export inline auto SetRenderColorTarget(RenderGraph& renderGraph, const RenderPassHandle& handle, Texture& color) noexcept -> void
+// Imported images belong to the graphics queue, so their fixups go at the start of its first scope; scope 0 may well be async compute on another family.
+[[nodiscard]] inline auto LayoutFixupScope(const CompiledPlan& plan) noexcept -> std::uint32_t
 {
-    if (RenderPassBase* pass{renderGraph.passes[handle.index]}; pass != nullptr) [[likely]]
+    const auto it{std::ranges::find(plan.batches, g_graphicsQueueId, &SubmitBatch::queueId)};
+    return it != plan.batches.end() ? it->firstScope : 0U;
+}
+
+// Resolves a compiled barrier against this frame's images; false when it is a buffer barrier and bufferBarrier was filled instead.
+inline auto ResolveBarrier(Renderer& renderer, const RenderGraph& renderGraph, const GraphBarrier& barrier, deer_vulkan::ImageBarrier& imageBarrier,
+                           deer_vulkan::BufferBarrier& bufferBarrier) noexcept -> bool
+{
+    const GraphResource& resource{renderGraph.resources[barrier.resource]};
+    if (deer_vulkan::Image* image{barrier.resource == g_swapChainTexture.index ? &CurrentImage(renderer.swapChain) : resource.image}; image != nullptr)
     {
-        pass->colorImage     = &color.image;
-        pass->colorImageView = &color.view;
-        renderGraph.dirty    = true;
+        imageBarrier = deer_vulkan::ImageBarrier{.image          = image,
+                                                 .srcStage       = barrier.srcStage,
+                                                 .srcAccess      = barrier.srcAccess,
+                                                 .dstStage       = barrier.dstStage,
+                                                 .dstAccess      = barrier.dstAccess,
+                                                 .oldLayout      = static_cast<std::uint32_t>(barrier.oldLayout),
+                                                 .newLayout      = static_cast<std::uint32_t>(barrier.newLayout),
+                                                 .srcQueueFamily = barrier.srcQueueFamily,
+                                                 .dstQueueFamily = barrier.dstQueueFamily};
+        return true;
     }
+    bufferBarrier = deer_vulkan::BufferBarrier{.buffer         = resource.buffer,
+                                               .srcStage       = barrier.srcStage,
+                                               .srcAccess      = barrier.srcAccess,
+                                               .dstStage       = barrier.dstStage,
+                                               .dstAccess      = barrier.dstAccess,
+                                               .srcQueueFamily = barrier.srcQueueFamily,
+                                               .dstQueueFamily = barrier.dstQueueFamily};
+    return false;
 }
 
-export inline auto SetRenderDepthTarget(RenderGraph& renderGraph, const RenderPassHandle& handle, Texture& depth) noexcept -> void
+// Resolves compiled barriers against this frame's images and records them with a single call.
+// The tracked layouts are left alone; ExecuteAll sets them to where the frame ends once every pass is recorded.
+inline auto RecordBarriers(Renderer& renderer, const RenderGraph& renderGraph, RecordScratch& scratch, const deer_vulkan::CommandBuffer& commandBuffer,
+                           const std::span<const GraphBarrier> barriers) noexcept -> void
 {
-    if (RenderPassBase* pass{renderGraph.passes[handle.index]}; pass != nullptr) [[likely]]
+    scratch.imageBarriers.clear();
+    scratch.bufferBarriers.clear();
+    for (const GraphBarrier& barrier : barriers)
     {
-        pass->depthImage     = &depth.image;
-        pass->depthImageView = &depth.view;
-        renderGraph.dirty    = true;
+        deer_vulkan::ImageBarrier imageBarrier{};
+        deer_vulkan::BufferBarrier bufferBarrier{};
+        if (ResolveBarrier(renderer, renderGraph, barrier, imageBarrier, bufferBarrier))
+        {
+            scratch.imageBarriers.emplace_back(imageBarrier);
+        }
+        else
+        {
+            scratch.bufferBarriers.emplace_back(bufferBarrier);
+        }
     }
+    deer_vulkan::PipelineBarrier(renderer.dispatch, commandBuffer, scratch.imageBarriers, scratch.bufferBarriers, /*trackLayouts=*/false);
 }
 
-// ---------------------------------------------------------------------------
-// Execution
-// ---------------------------------------------------------------------------
+inline auto RecordBarriers(Renderer& renderer, const RenderGraph& renderGraph, RecordScratch& scratch, const deer_vulkan::CommandBuffer& commandBuffer,
+                           const std::size_t range) noexcept -> void
+{
+    const std::span<const GraphBarrier> barriers{renderGraph.plan.barriers};
+    RecordBarriers(renderer, renderGraph, scratch, commandBuffer,
+                   barriers.subspan(renderGraph.plan.barrierOffsets[range], renderGraph.plan.barrierOffsets[range + 1U] - renderGraph.plan.barrierOffsets[range]));
+}
 
-constexpr void PreRenderPass(const RenderPassContext& renderPassContext, const RenderPassBase* renderPass) noexcept
+inline auto RecordReleases(Renderer& renderer, const RenderGraph& renderGraph, RecordScratch& scratch, const deer_vulkan::CommandBuffer& commandBuffer,
+                           const std::size_t batch) noexcept -> void
 {
-    deer_vulkan::BeginCommand(renderPassContext.dispatch, renderPassContext.commandBuffer);
-    deer_vulkan::Image* color               = renderPass->colorImage;
-    deer_vulkan::Image* depth               = renderPass->depthImage;
-    const deer_vulkan::ImageView* colorView = renderPass->colorImageView;
-    const deer_vulkan::ImageView* depthView = renderPass->depthImageView;
-    if (!color && !depth)
-    {
-        [[maybe_unused]] deer_vulkan::vk_status status{NextImage(renderPassContext.dispatch, renderPassContext.device, renderPassContext.swapChain, renderPassContext.binarySemaphore)};
-        color     = &CurrentImage(renderPassContext.swapChain);
-        colorView = &CurrentImageView(renderPassContext.swapChain);
-    }
-    if (color)
+    const std::span<const GraphBarrier> releases{renderGraph.plan.releaseBarriers};
+    RecordBarriers(renderer, renderGraph, scratch, commandBuffer,
+                   releases.subspan(renderGraph.plan.releaseOffsets[batch], renderGraph.plan.releaseOffsets[batch + 1U] - renderGraph.plan.releaseOffsets[batch]));
+}
+
+// Sets (isWait = false) or waits for the events of the split barriers that end or start at a scope.
+inline auto RecordSplitBarriers(Renderer& renderer, const RenderGraph& renderGraph, const deer_vulkan::CommandBuffer& commandBuffer, const std::uint32_t scope,
+                                const bool isWait) noexcept -> void
+{
+    const std::vector<deer_vulkan::Event>& events{renderGraph.events[renderer.frameIndex]};
+    for (std::uint32_t i{}; i < renderGraph.plan.splitBarriers.size(); ++i)
     {
-        TransitionImageLayout(renderPassContext.dispatch, renderPassContext.commandBuffer, *color, static_cast<std::uint32_t>(image_layout::color_attachment_optimal));
+        const SplitBarrier& split{renderGraph.plan.splitBarriers[i]};
+        if ((isWait ? split.waitScope : split.setScope) != scope)
+        {
+            continue;
+        }
+        deer_vulkan::ImageBarrier imageBarrier{};
+        deer_vulkan::BufferBarrier bufferBarrier{};
+        const bool isImage{ResolveBarrier(renderer, renderGraph, split.barrier, imageBarrier, bufferBarrier)};
+        const deer_vulkan::ImageBarrier* pImageBarrier{isImage ? &imageBarrier : nullptr};
+        const deer_vulkan::BufferBarrier* pBufferBarrier{isImage ? nullptr : &bufferBarrier};
+        if (isWait)
+        {
+            deer_vulkan::WaitEvent(renderer.dispatch, commandBuffer, events[i], pImageBarrier, pBufferBarrier);
+        }
+        else
+        {
+            deer_vulkan::SetEvent(renderer.dispatch, commandBuffer, events[i], pImageBarrier, pBufferBarrier);
+        }
     }
-    if (depth)
+}
+
+// The layout CollectUses settles on for an attachment: general when the pass also uses it in another layout.
+[[nodiscard]] inline auto AttachmentLayout(const RenderPass* renderPass, const std::uint32_t resource, const image_layout layout) noexcept -> std::uint32_t
+{
+    const bool isShared{std::ranges::any_of(renderPass->uses,
+                                            [resource, layout](const ResourceUse& use) noexcept
+                                            {
+                                                return use.resource == resource && use.layout != image_layout::undefined && use.layout != layout;
+                                            })};
+    return static_cast<std::uint32_t>(isShared ? image_layout::general : layout);
+}
+
+// A merged scope loads like its first pass and stores like its last one.
+inline void PreRenderPass(const RenderPassContext& renderPassContext, const RenderPass* renderPass, const AttachmentOps& firstOps, const AttachmentOps& lastOps) noexcept
+{
+    BALBINO_PROFILE_ZONE("PreRenderPass");
+    if (renderPass->isCompute)
     {
-        TransitionImageLayout(renderPassContext.dispatch, renderPassContext.commandBuffer, *depth, static_cast<std::uint32_t>(image_layout::depth_stencil_attachment_optimal));
+        return;
     }
 
+    const bool isSwapChain{IsSwapChainPass(renderPass)};
+    const image_layout depthLayout{renderPass->isDepthReadOnly ? image_layout::read_only_optimal : image_layout::attachment_optimal};
     deer_vulkan::BeginRender(renderPassContext.dispatch, renderPassContext.commandBuffer,
-                             deer_vulkan::RenderParams{.colorImageView = colorView,
-                                                       .depthImageView = depthView,
-                                                       .clearColor     = {0, 0, 0},
-                                                       .depthClear     = 0,
+                             deer_vulkan::RenderParams{.colorImageView = isSwapChain ? &CurrentImageView(renderPassContext.swapChain) : renderPass->colorImageView,
+                                                       .depthImageView = renderPass->depthImageView,
+                                                       .clearColor     = renderPass->clearColor,
+                                                       .depthClear     = renderPass->clearDepth,
                                                        .xOffset        = 0,
                                                        .yOffset        = 0,
-                                                       .width          = renderPassContext.swapChain.extent.width,
-                                                       .height         = renderPassContext.swapChain.extent.height,
-                                                       .stencilClear   = 0});
+                                                       .width          = renderPassContext.width,
+                                                       .height         = renderPassContext.height,
+                                                       .stencilClear   = renderPass->clearStencil,
+                                                       .colorLoadOp    = static_cast<std::uint32_t>(firstOps.colorLoad),
+                                                       .colorStoreOp   = static_cast<std::uint32_t>(lastOps.colorStore),
+                                                       .depthLoadOp    = static_cast<std::uint32_t>(firstOps.depthLoad),
+                                                       .depthStoreOp   = static_cast<std::uint32_t>(lastOps.depthStore),
+                                                       .colorLayout    = AttachmentLayout(renderPass, ColorTarget(renderPass), image_layout::attachment_optimal),
+                                                       .depthLayout    = AttachmentLayout(renderPass, renderPass->depthResource, depthLayout),
+                                                       .depthReadOnly  = renderPass->isDepthReadOnly});
 }
 
-inline void PostRenderPass(const RenderPassContext& renderPassContext, const RenderPassBase* renderPass) noexcept
+inline void PostRenderPass(const RenderPassContext& renderPassContext, const RenderPass* renderPass) noexcept
 {
-    deer_vulkan::EndRender(renderPassContext.dispatch, renderPassContext.commandBuffer);
-
-    deer_vulkan::Image* color = renderPass->colorImage;
-    deer_vulkan::Image* depth = renderPass->depthImage;
-
-    const bool isSwapChain{!color && !depth};
-    if (isSwapChain)
+    BALBINO_PROFILE_ZONE("PostRenderPass");
+    if (!renderPass->isCompute)
     {
-        deer_vulkan::Image& swapChainImage{deer_vulkan::CurrentImage(renderPassContext.swapChain)};
-        TransitionImageLayout(renderPassContext.dispatch, renderPassContext.commandBuffer, swapChainImage, static_cast<std::uint32_t>(image_layout::present_src_khr));
+        deer_vulkan::EndRender(renderPassContext.dispatch, renderPassContext.commandBuffer);
     }
-    else
+}
+
+// Size of the targets a raster pass renders into: a transient's create info, an imported image's own extent, or the swap chain's.
+[[nodiscard]] inline auto RenderArea(const Renderer& renderer, const RenderGraph& renderGraph, const RenderPass* renderPass) noexcept -> std::array<std::uint32_t, 2>
+{
+    for (const std::uint32_t resource : {ColorTarget(renderPass), renderPass->depthResource})
     {
-        if (color)
+        if (resource == ~0U || resource == g_swapChainTexture.index)
+        {
+            continue;
+        }
+        if (const GraphResource& graphResource{renderGraph.resources[resource]}; graphResource.transient != ~0U)
         {
-            TransitionImageLayout(renderPassContext.dispatch, renderPassContext.commandBuffer, *color, static_cast<std::uint32_t>(image_layout::shader_read_only_optimal));
+            const RenderTextureCreateInfo& info{renderGraph.transients[graphResource.transient].createInfo};
+            return {info.width, info.height};
         }
-        if (depth)
+        else if (graphResource.image != nullptr && graphResource.image->width != 0U)
         {
-            TransitionImageLayout(renderPassContext.dispatch, renderPassContext.commandBuffer, *depth, static_cast<std::uint32_t>(image_layout::depth_stencil_attachment_optimal));
+            return {graphResource.image->width, graphResource.image->height};
         }
     }
+    return {renderer.swapChain.extent.width, renderer.swapChain.extent.height};
+}
+
+// Records one rendering scope into a command buffer of its own, along with whatever its batch records before the first or after the last pass.
+// Runs on a worker: it only allocates from that worker's pools, builds barriers in that worker's scratch and leaves the tracked layouts alone.
+[[nodiscard]] inline auto RecordScope(Renderer& renderer, RenderGraph& renderGraph, const std::uint32_t scope, const std::uint32_t worker) noexcept -> gfx_status
+{
+    BALBINO_PROFILE_ZONE("RecordScope");
+    const CompiledPlan& plan{renderGraph.plan};
+    const std::uint32_t first{plan.scopeOffsets[scope]};
+    const std::uint32_t last{plan.scopeOffsets[scope + 1U] - 1U};
+    const std::uint32_t b{plan.passBatches[first]};
+    const SubmitBatch& batch{plan.batches[b]};
+    RecordScratch& scratch{renderGraph.scratch[worker]};
 
-    // End the command buffer and handle possible failure
-    deer_vulkan::EndCommand(renderPassContext.dispatch, renderPassContext.commandBuffer);
+    const deer_vulkan::CommandBuffer* commandBuffer{nullptr};
+    if (const gfx_status status{NextCommandBuffer(renderer, batch.queueId, worker, commandBuffer)}; status != gfx_status::ok) [[unlikely]]
+    {
+        return status;
+    }
+    renderGraph.scopeCommandBuffers[scope] = commandBuffer;
 
-    // Determine the wait and signal values for synchronization
-    const bool wait{(renderPass->syncMode & SYNC_WAIT) != 0};
-    const bool signal{(renderPass->syncMode & SYNC_SIGNAL) != 0};
+    const auto [width, height]{RenderArea(renderer, renderGraph, CompiledPass(renderGraph, first))};
+    const RenderPassContext renderContext{
+        .dispatch          = renderer.dispatch,
+        .device            = renderer.device,
+        .commandBuffer     = *commandBuffer,
+        .swapChain         = renderer.swapChain,
+        .timelineSemaphore = QueueTimeline(renderer, batch.queueId),
+        .uploadRing        = renderer.uploadRing,
+        .width             = width,
+        .height            = height,
+    };
 
-    if (wait)
+    // Pass i writes queries 2i and 2i + 1. A queue that cannot write timestamps still resets them, so they read back as unavailable.
+    const deer_vulkan::QueryPool& queryPool{renderGraph.timestamps[renderer.frameIndex].queryPool};
+    const bool hasTimestamps{queryPool.count != 0U && deer_vulkan::TimestampValidBits(renderer.physical, renderer.queue[batch.queueId].familyIndex) != 0U};
+    const auto writeTimestamp = [&](const pipeline_stage stage, const std::uint32_t query)
     {
-        if (signal)
+        if (hasTimestamps)
         {
-            if (deer_vulkan::QueueSubmit(renderPassContext.dispatch, *renderPassContext.queue, renderPassContext.commandBuffer, &renderPassContext.timelineSemaphore,
-                                         renderPass->waitValue, renderPass->signalValue)
-                != deer_vulkan::vk_status::ok)
-            {
-                return;
-            }
+            deer_vulkan::WriteTimestamp(renderer.dispatch, *commandBuffer, queryPool, StageBits(stage), query);
         }
-        else
+    };
+
+    deer_vulkan::BeginSingleCommand(renderer.dispatch, *commandBuffer);
+    if (queryPool.count != 0U)
+    {
+        deer_vulkan::ResetQueries(renderer.dispatch, *commandBuffer, queryPool, 2U * first, 2U * (last + 1U - first));
+    }
+    if (scope == LayoutFixupScope(plan))
+    {
+        RecordLayoutFixups(renderer, renderGraph, scratch, *commandBuffer);
+    }
+    RecordSplitBarriers(renderer, renderGraph, *commandBuffer, scope, /*isWait=*/true);
+    RecordBarriers(renderer, renderGraph, scratch, *commandBuffer, first);
+    writeTimestamp(pipeline_stage::top_of_pipe, 2U * first);
+    PreRenderPass(renderContext, CompiledPass(renderGraph, first), plan.attachmentOps[first], plan.attachmentOps[last]);
+    for (std::uint32_t pass{first}; pass <= last; ++pass)
+    {
+        if (pass != first)
         {
-            if (deer_vulkan::QueueSubmit(renderPassContext.dispatch, *renderPassContext.queue, renderPassContext.commandBuffer, &renderPassContext.timelineSemaphore,
-                                         renderPass->waitValue, true)
-                != deer_vulkan::vk_status::ok)
-            {
-                return;
-            }
+            writeTimestamp(pipeline_stage::top_of_pipe, 2U * pass);
+        }
+        Execute(*CompiledPass(renderGraph, pass), renderContext);
+        if (pass != last)
+        {
+            writeTimestamp(pipeline_stage::bottom_of_pipe, 2U * pass + 1U);
         }
     }
-    else if (signal)
+    PostRenderPass(renderContext, CompiledPass(renderGraph, last));
+    writeTimestamp(pipeline_stage::bottom_of_pipe, 2U * last + 1U);
+    RecordSplitBarriers(renderer, renderGraph, *commandBuffer, scope, /*isWait=*/false);
+    if (last + 1U == batch.firstPass + batch.passCount)
     {
-        if (deer_vulkan::QueueSubmit(renderPassContext.dispatch, *renderPassContext.queue, renderPassContext.commandBuffer, &renderPassContext.timelineSemaphore,
-                                     renderPass->signalValue, false)
-            != deer_vulkan::vk_status::ok)
+        RecordReleases(renderer, renderGraph, scratch, *commandBuffer, b);
+        if (b == plan.presentBatch)
         {
-            return;
+            RecordBarriers(renderer, renderGraph, scratch, *commandBuffer, plan.compiled.size());
         }
     }
-    else
+    deer_vulkan::EndCommand(renderer.dispatch, *commandBuffer);
+
+    return gfx_status::ok;
+}
+
+// Reads back the timestamps the current frame slot wrote the last time it was used. BeginFrame already waited for that frame, so this never blocks.
+// Passes whose queries were not written (their queue has no timestamps) keep their previous timing.
+inline auto ResolveTimestamps(const Renderer& renderer, RenderGraph& renderGraph) noexcept -> void
+{
+    TimestampFrame& timestamps{renderGraph.timestamps[renderer.frameIndex]};
+    if (timestamps.passes.empty())
+    {
+        return;
+    }
+
+    const auto queryCount{static_cast<std::uint32_t>(2U * timestamps.passes.size())};
+    renderGraph.timestampResults.assign(2U * queryCount, 0U);
+    renderGraph.gpuTimings.resize(renderGraph.passes.size());
+    const std::span<const std::uint64_t> results{renderGraph.timestampResults};
+    GFX_CHECK_VOID(deer_vulkan::GetTimestamps(renderer.dispatch, renderer.device, timestamps.queryPool, 0U, queryCount, renderGraph.timestampResults),
+                   "reading back {} timestamps", queryCount)
+
+    // Begin and end of pass i, with their availability words: results[4i .. 4i + 3].
+    const auto isAvailable = [&results](const std::size_t pass)
+    {
+        return results[4U * pass + 1U] != 0U && results[4U * pass + 3U] != 0U;
+    };
+    const auto validMask = [&renderer](const std::uint8_t queueId)
+    {
+        const std::uint32_t bits{deer_vulkan::TimestampValidBits(renderer.physical, renderer.queue[queueId].familyIndex)};
+        return bits >= 64U ? ~0ULL : (1ULL << bits) - 1ULL;
+    };
+
+    std::array<std::uint64_t, g_queueCount> frameStart{};
+    std::array<bool, g_queueCount> hasStart{};
+    for (std::size_t i{}; i < timestamps.passes.size(); ++i)
     {
-        if (deer_vulkan::QueueSubmit(renderPassContext.dispatch, *renderPassContext.queue, renderPassContext.commandBuffer) != deer_vulkan::vk_status::ok)
+        if (const std::uint8_t queueId{QueueOf(&renderGraph.passes[timestamps.passes[i]])}; isAvailable(i) && !hasStart[queueId])
         {
-            return;
+            frameStart[queueId] = results[4U * i];
+            hasStart[queueId]   = true;
         }
     }
 
-    // Present to screen if no colour and depth image is provided
-    if (isSwapChain)
+    const double nanosecondsPerTick{static_cast<double>(deer_vulkan::TimestampPeriod(renderer.physical))};
+    for (std::size_t i{}; i < timestamps.passes.size(); ++i)
     {
-        if (deer_vulkan::Present(renderPassContext.dispatch, *renderPassContext.queue, renderPassContext.swapChain, renderPassContext.binarySemaphore)
-            != deer_vulkan::vk_status::ok)
+        const RenderPass* renderPass{&renderGraph.passes[timestamps.passes[i]]};
+        if (!isAvailable(i) || renderPass->index >= renderGraph.gpuTimings.size())
         {
-            return;
+            continue;
         }
+        const std::uint8_t queueId{QueueOf(renderPass)};
+        const std::uint64_t mask{validMask(queueId)};
+        const double begin{static_cast<double>((results[4U * i] - frameStart[queueId]) & mask) * nanosecondsPerTick};
+        const double duration{static_cast<double>((results[4U * i + 2U] - results[4U * i]) & mask) * nanosecondsPerTick};
+        renderGraph.gpuTimings[renderPass->index] = GpuPassTiming{
+            .beginMilliseconds = static_cast<float>(begin * 1e-6),
+            .milliseconds      = static_cast<float>(duration * 1e-6),
+            .frame             = timestamps.frame,
+        };
+        BALBINO_PROFILE_GPU_ZONE("Pass", renderPass->index, queueId, timestamps.frame, static_cast<std::uint64_t>(begin), static_cast<std::uint64_t>(duration));
+    }
+    timestamps.passes.clear();
+}
+
+// Makes sure the current frame slot has a begin and an end query for every compiled pass. The slot's previous frame is done, so its pool can go.
+[[nodiscard]] inline auto PrepareTimestamps(const Renderer& renderer, RenderGraph& renderGraph) noexcept -> gfx_status
+{
+    deer_vulkan::QueryPool& queryPool{renderGraph.timestamps[renderer.frameIndex].queryPool};
+    if (const auto queryCount{static_cast<std::uint32_t>(2U * renderGraph.plan.compiled.size())}; queryPool.count < queryCount)
+    {
+        deer_vulkan::Cleanup(renderer.dispatch, renderer.device, queryPool);
+        GFX_CHECK(deer_vulkan::Initialize(renderer.dispatch, renderer.device, std::bit_ceil(queryCount), queryPool), "creating a pool of {} timestamp queries",
+                  std::bit_ceil(queryCount))
+    }
+    return gfx_status::ok;
+}
 
-        deer_vulkan::NextFrame(renderPassContext.swapChain);
+// Events are only touched by the frame that uses the slot, which BeginFrame already waited for; every wait unsignals its event again.
+[[nodiscard]] inline auto PrepareEvents(const Renderer& renderer, RenderGraph& renderGraph) noexcept -> gfx_status
+{
+    std::vector<deer_vulkan::Event>& events{renderGraph.events[renderer.frameIndex]};
+    while (events.size() < renderGraph.plan.splitBarriers.size())
+    {
+        deer_vulkan::Event event{};
+        GFX_CHECK(deer_vulkan::Initialize(renderer.dispatch, renderer.device, event), "creating split barrier event {}", events.size())
+        events.emplace_back(event);
     }
+    return gfx_status::ok;
+}
 
-    deer_vulkan::WaitIdle(renderPassContext.dispatch, *renderPassContext.queue);
+// The recorded barriers did not touch the tracked layouts; once recording is done they jump straight to where the frame leaves every image.
+inline auto ApplyEndLayouts(Renderer& renderer, const RenderGraph& renderGraph) noexcept -> void
+{
+    for (std::uint32_t i{1U}; i < renderGraph.resources.size(); ++i)
+    {
+        const GraphResource& resource{renderGraph.resources[i]};
+        if (const image_layout endLayout{renderGraph.plan.resources[i].endLayout}; resource.image != nullptr && endLayout != image_layout::undefined)
+        {
+            deer_vulkan::SetLayout(*resource.image, static_cast<std::uint32_t>(endLayout));
+        }
+    }
+    if (renderGraph.plan.presentBatch != g_noBatch)
+    {
+        deer_vulkan::SetLayout(CurrentImage(renderer.swapChain), static_cast<std::uint32_t>(image_layout::present_src_khr));
+    }
 }
 
-export constexpr void ExecuteAll(Renderer& renderer, RenderGraph& renderGraph) noexcept
+// Records and submits one frame. The rendering scopes are recorded in parallel on the renderer's workers, each into its own command buffer from the worker's pool,
+// and every batch submits its scopes' command buffers in graph order, signalling the timeline of its queue.
+// Batches on other queues are waited for only where the plan found a dependency; the last submit joins them all and ends the frame.
+// The CPU only blocks when it catches up with the frame that last used the same slot.
+export [[nodiscard]] inline auto ExecuteAll(Renderer& renderer, RenderGraph& renderGraph) noexcept -> gfx_status
 {
+    ++renderGraph.frameCount;
+    BALBINO_PROFILE_FRAME(renderGraph.frameCount);
+    BALBINO_PROFILE_ZONE("ExecuteAll");
+
+    CollectRetired(renderer, renderGraph);
+    if (renderer.swapChain.extent.width != renderGraph.swapChainWidth || renderer.swapChain.extent.height != renderGraph.swapChainHeight)
+    {
+        ResizeTransients(renderer, renderGraph);
+    }
     if (renderGraph.dirty)
     {
-        renderGraph.compiled.clear();
-        for (RenderPassBase* renderPass : renderGraph.passes)
+        if (const gfx_status status{SelectPlan(renderer, renderGraph)}; status != gfx_status::ok) [[unlikely]]
+        {
+            return status;
+        }
+    }
+
+    if (const gfx_status status{BeginFrame(renderer)}; status != gfx_status::ok) [[unlikely]]
+    {
+        return status;
+    }
+    ResolveTimestamps(renderer, renderGraph);
+    if (const gfx_status status{PrepareTimestamps(renderer, renderGraph)}; status != gfx_status::ok) [[unlikely]]
+    {
+        return status;
+    }
+    if (const gfx_status status{PrepareEvents(renderer, renderGraph)}; status != gfx_status::ok) [[unlikely]]
+    {
+        return status;
+    }
+
+    if (TouchesSwapChain(renderGraph, 0U, static_cast<std::uint32_t>(renderGraph.plan.compiled.size())))
+    {
+        if (const gfx_status status{AcquireImage(renderer)}; status != gfx_status::ok)
+        {
+            return status;
+        }
+    }
+
+    const auto scopeCount{static_cast<std::uint32_t>(renderGraph.plan.scopeOffsets.size()) - 1U};
+    renderGraph.scopeCommandBuffers.assign(scopeCount, nullptr);
+    renderGraph.scopeStatus.assign(scopeCount, gfx_status::ok);
+    renderGraph.scratch.resize(WorkerCount(renderer.workers));
+    auto record = [&renderer, &renderGraph](const std::uint32_t scope, const std::uint32_t worker) noexcept
+    {
+        renderGraph.scopeStatus[scope] = RecordScope(renderer, renderGraph, scope, worker);
+    };
+    Run(renderer.workers, scopeCount, record);
+    if (const auto failed{std::ranges::find_if(renderGraph.scopeStatus,
+                                               [](const gfx_status status)
+                                               {
+                                                   return status != gfx_status::ok;
+                                               })};
+        failed != renderGraph.scopeStatus.end()) [[unlikely]]
+    {
+        return *failed;
+    }
+    ApplyEndLayouts(renderer, renderGraph);
+
+    // Timeline values of the previous frame's last submits, for waits that cross the frame boundary.
+    std::array<std::uint64_t, g_queueCount> previousFrameValues{};
+    for (std::uint8_t q{}; q < g_queueCount; ++q)
+    {
+        previousFrameValues[q] = QueueTimeline(renderer, q).value;
+    }
+    renderGraph.batchSignalValues.resize(renderGraph.plan.batches.size());
+
+    const deer_vulkan::Semaphore& acquireSemaphore{renderer.frames[renderer.acquireSlot].acquireSemaphore};
+    bool waitedForImage{false};
+    bool waitedForUploads{false};
+    for (std::size_t b{}; b < renderGraph.plan.batches.size(); ++b)
+    {
+        const SubmitBatch& batch{renderGraph.plan.batches[b]};
+        const bool isLast{b + 1U == renderGraph.plan.batches.size()};
+        deer_vulkan::Semaphore& timeline{QueueTimeline(renderer, batch.queueId)};
+        const std::span<const deer_vulkan::CommandBuffer* const> commandBuffers{renderGraph.scopeCommandBuffers.data() + batch.firstScope, batch.scopeCount};
+        const bool touchesImage{TouchesSwapChain(renderGraph, batch.firstPass, batch.passCount)};
+
+        std::array<deer_vulkan::SemaphoreSubmit, 2U + g_queueCount> waits{};
+        std::array<deer_vulkan::SemaphoreSubmit, 3> signals{};
+        std::size_t waitCount{};
+        std::size_t signalCount{};
+        if (touchesImage && !waitedForImage)
+        {
+            waits[waitCount++] = {.semaphore = &acquireSemaphore, .value = 0U, .stageMask = renderGraph.plan.swapChainWaitStage};
+            waitedForImage     = true;
+        }
+        if (batch.queueId == g_graphicsQueueId && !waitedForUploads)
+        {
+            waitCount += TakeUploadWait(renderer, waits[waitCount]) ? 1U : 0U;
+            waitedForUploads = true;
+        }
+        for (std::uint8_t q{}; q < g_queueCount; ++q)
         {
-            if (renderPass->isEnabled)
+            if (const std::uint32_t waitBatch{batch.waitBatch[q]}; waitBatch != g_noBatch)
             {
-                renderGraph.compiled.emplace_back(renderPass);
+                waits[waitCount++] = {.semaphore = &QueueTimeline(renderer, q),
+                                      .value     = waitBatch == g_previousFrameBatch ? previousFrameValues[q] : renderGraph.batchSignalValues[waitBatch],
+                                      .stageMask = StageBits(pipeline_stage::all_commands)};
             }
         }
-        std::ranges::sort(renderGraph.compiled,
-                          [](const RenderPassBase* pA, const RenderPassBase* pB)
-                          {
-                              return pA->index < pB->index;
-                          });
-        renderGraph.dirty = false;
-    }
-    for (std::size_t i{}; i < renderGraph.compiled.size(); ++i)
-    {
-        RenderPassBase* renderPass{renderGraph.compiled[i]};
-        const RenderPassContext renderContext{
-            .dispatch          = renderer.dispatch,
-            .device            = renderer.device,
-            .commandBuffer     = renderer.commandBuffer,
-            .swapChain         = renderer.swapChain,
-            .timelineSemaphore = renderer.timelineSemaphore,
-            .binarySemaphore   = renderer.binarySemaphore,
-            .queue             = &renderer.queue[g_presentQueueId],
-        };
-        PreRenderPass(renderContext, renderPass);
-        renderPass->Execute(renderContext);
-        PostRenderPass(renderContext, renderPass);
+
+        const std::uint64_t signalValue{timeline.value + 1U};
+        signals[signalCount++] = {.semaphore = &timeline, .value = signalValue, .stageMask = StageBits(pipeline_stage::all_commands)};
+        const bool signalsFrame{isLast && &timeline != &renderer.timelineSemaphore};
+        if (signalsFrame)
+        {
+            signals[signalCount++] = {.semaphore = &renderer.timelineSemaphore,
+                                      .value     = renderer.timelineSemaphore.value + 1U,
+                                      .stageMask = StageBits(pipeline_stage::all_commands)};
+        }
+        if (isLast && renderer.imageAcquired)
+        {
+            signals[signalCount++] = {.semaphore = &renderer.presentSemaphores[renderer.swapChain.currentFrameIdx],
+                                      .value     = 0U,
+                                      .stageMask = StageBits(pipeline_stage::all_commands)};
+        }
+
+        const deer_vulkan::vk_status submitted{
+            SubmitFrameCommands(renderer, batch.queueId, commandBuffers, std::span{waits.data(), waitCount}, std::span{signals.data(), signalCount})};
+        if (deer_vulkan::IsError(submitted)) [[unlikely]]
+        {
+            // EndFrame will not run, but earlier batches are on the device: the slot must wait for them before its command pools are reset.
+            renderer.frames[renderer.frameIndex].timelineValue = renderer.timelineSemaphore.value;
+        }
+        GFX_CHECK(submitted, "submitting batch {} ({} passes)", b, batch.passCount);
+        timeline.value                   = signalValue;
+        renderGraph.batchSignalValues[b] = signalValue;
+        if (signalsFrame)
+        {
+            ++renderer.timelineSemaphore.value;
+        }
     }
+    renderGraph.plan.lastFrameValue = renderer.timelineSemaphore.value;
+
+    TimestampFrame& timestamps{renderGraph.timestamps[renderer.frameIndex]};
+    timestamps.passes.assign(renderGraph.plan.compiled.begin(), renderGraph.plan.compiled.end());
+    timestamps.frame = renderGraph.frameCount;
+
+    return EndFrame(renderer);
 }
 
-export constexpr void CleanupRenderGraph(RenderGraph& renderGraph) noexcept
+export inline void CleanupRenderGraph(const Renderer& renderer, RenderGraph& renderGraph) noexcept
 {
-    for (const RenderPassBase* renderPass : renderGraph.passes)
+    WaitIdle(renderer);
+    ReleaseTransients(renderer, renderGraph.plan);
+    for (CompiledPlan& plan : renderGraph.planCache)
+    {
+        ReleaseTransients(renderer, plan);
+    }
+    renderGraph.plan = {};
+    renderGraph.planCache.clear();
+    for (RetiredTexture& retired : renderGraph.retiredTextures)
+    {
+        Cleanup(renderer, retired.texture);
+    }
+    for (PooledMemory& pooled : renderGraph.memoryPool)
+    {
+        Cleanup(renderer.dispatch, renderer.device, pooled.memory);
+    }
+    for (TimestampFrame& timestamps : renderGraph.timestamps)
+    {
+        deer_vulkan::Cleanup(renderer.dispatch, renderer.device, timestamps.queryPool);
+        timestamps.passes.clear();
+    }
+    for (std::vector<deer_vulkan::Event>& events : renderGraph.events)
     {
-        delete renderPass;
+        for (deer_vulkan::Event& event : events)
+        {
+            deer_vulkan::Cleanup(renderer.dispatch, renderer.device, event);
+        }
+        events.clear();
     }
-    renderGraph.compiled.clear();
+    renderGraph.gpuTimings.clear();
+    renderGraph.retiredTextures.clear();
+    renderGraph.memoryPool.clear();
+    renderGraph.swapChainWidth  = 0U;
+    renderGraph.swapChainHeight = 0U;
+    renderGraph.transients.clear();
+    renderGraph.scopeCommandBuffers.clear();
+    renderGraph.scopeStatus.clear();
+    renderGraph.resources.resize(1U);
     renderGraph.passes.clear();
+    Reset(renderGraph.arena);
+    renderGraph.dirty = true;
 }
 } // namespace fawn_vision
@@ -8,6 +8,7 @@ module;
 #include "api/vulkan/wrapper/image_view.hpp"
 
 export module FawnVision:RenderPass;
+import :Enum;
 import :RenderPassContext;
 import FawnAlgebra;
 
@@ -15,79 +16,195 @@ import std;
 
 namespace fawn_vision
 {
-export constexpr std::uint8_t SYNC_NONE        = 0U;
-export constexpr std::uint8_t SYNC_WAIT        = 1U;
-export constexpr std::uint8_t SYNC_SIGNAL      = 2U;
-export constexpr std::uint8_t SYNC_WAIT_SIGNAL = SYNC_WAIT | SYNC_SIGNAL;
+export enum class texture_read : std::uint8_t {
+    sampled_fragment,
+    sampled_compute,
+    storage_compute,
+    transfer_src,
+};
+
+// Attachments are declared through SetRender*Target, which also binds them for rendering.
+export enum class texture_write : std::uint8_t {
+    storage_compute,
+    transfer_dst,
+};
+
+export enum class buffer_read : std::uint8_t {
+    vertex,
+    index,
+    indirect,
+    uniform_vertex,
+    uniform_fragment,
+    uniform_compute,
+    storage_fragment,
+    storage_compute,
+    transfer_src,
+};
+
+export enum class buffer_write : std::uint8_t {
+    storage_fragment,
+    storage_compute,
+    transfer_dst,
+};
+
+// One declared access of a pass to a graph resource; stage and access hold pipeline_stage/memory_access bits.
+export struct ResourceUse
+{
+    std::uint32_t resource{~0U};
+    std::uint64_t stage{};
+    std::uint64_t access{};
+    image_layout layout{image_layout::undefined};
+    bool isWrite{};
+};
 
-export struct RenderPassBase
+// A callable kept in place, with no heap allocation and no fallback to one: a callable that does not fit is a compile error.
+// Render functions are called once per pass per frame, so this keeps them next to the pass instead of behind another pointer.
+export template <class Signature, std::size_t Capacity = 48U>
+struct InlineFunction;
+
+export template <class Result, class... Args, std::size_t Capacity>
+struct InlineFunction<Result(Args...), Capacity>
 {
-    virtual ~RenderPassBase()                                       = default;
-    virtual auto Execute(const RenderPassContext&) noexcept -> void = 0;
+    InlineFunction() noexcept = default;
+
+    template <class Callable>
+        requires(!std::same_as<std::remove_cvref_t<Callable>, InlineFunction> && std::is_invocable_r_v<Result, const std::decay_t<Callable>&, Args...>)
+    InlineFunction(Callable&& callable) noexcept
+    {
+        using Stored = std::decay_t<Callable>;
+        static_assert(sizeof(Stored) <= Capacity, "the callable does not fit; capture less (a pointer to the state it needs) or raise the capacity");
+        static_assert(alignof(Stored) <= alignof(std::max_align_t), "over-aligned callables are not supported");
+        static_assert(std::is_nothrow_move_constructible_v<Stored>, "the callable must be nothrow movable");
+
+        ::new (static_cast<void*>(storage.data())) Stored(std::forward<Callable>(callable));
+        pInvoke = [](const void* pCallable, Args... args) noexcept -> Result
+        {
+            return (*static_cast<const Stored*>(pCallable))(std::forward<Args>(args)...);
+        };
+        pManage = [](void* pDestination, void* pSource) noexcept
+        {
+            if (pDestination != nullptr)
+            {
+                ::new (pDestination) Stored(std::move(*static_cast<Stored*>(pSource)));
+            }
+            static_cast<Stored*>(pSource)->~Stored();
+        };
+    }
+
+    InlineFunction(InlineFunction&& other) noexcept
+    {
+        MoveFrom(other);
+    }
+
+    auto operator=(InlineFunction&& other) noexcept -> InlineFunction&
+    {
+        if (this != &other)
+        {
+            Reset();
+            MoveFrom(other);
+        }
+        return *this;
+    }
+
+    InlineFunction(const InlineFunction&)                    = delete;
+    auto operator=(const InlineFunction&) -> InlineFunction& = delete;
+
+    ~InlineFunction() noexcept
+    {
+        Reset();
+    }
+
+    [[nodiscard]] explicit operator bool() const noexcept
+    {
+        return pInvoke != nullptr;
+    }
+
+    auto operator()(Args... args) const noexcept -> Result
+    {
+        return pInvoke(storage.data(), std::forward<Args>(args)...);
+    }
+
+    auto Reset() noexcept -> void
+    {
+        if (pManage != nullptr)
+        {
+            pManage(nullptr, storage.data());
+        }
+        pInvoke = nullptr;
+        pManage = nullptr;
+    }
+
+    alignas(std::max_align_t) std::array<std::byte, Capacity> storage{};
+    Result (*pInvoke)(const void*, Args...) noexcept {nullptr};
+    void (*pManage)(void* pDestination, void* pSource) noexcept {nullptr}; // moves into pDestination (if any), then destroys pSource
+
+private:
+    auto MoveFrom(InlineFunction& other) noexcept -> void
+    {
+        if (other.pManage != nullptr)
+        {
+            other.pManage(storage.data(), other.storage.data());
+        }
+        pInvoke = std::exchange(other.pInvoke, nullptr);
+        pManage = std::exchange(other.pManage, nullptr);
+    }
+};
 
+// Passes live side by side in RenderGraph::passes; their data lives in the graph's arena.
+export struct RenderPass
+{
     // Non-owning — lifetime managed by the texture/swapchain that owns them.
     deer_vulkan::Image* colorImage{nullptr};
     deer_vulkan::Image* depthImage{nullptr};
     const deer_vulkan::ImageView* colorImageView{nullptr};
     const deer_vulkan::ImageView* depthImageView{nullptr};
 
-    std::uint64_t waitValue{0ULL};
-    std::uint64_t signalValue{0ULL};
+    // Declared reads/writes; the attachments above are added to these by the graph compiler.
+    std::vector<ResourceUse> uses{};
+    std::uint32_t colorResource{~0U};
+    std::uint32_t depthResource{~0U};
+
+    // Used when the graph finds that a target starts its life in this pass; the depth default suits a reversed depth buffer.
+    std::array<float, 4> clearColor{0.0F, 0.0F, 0.0F, 1.0F};
+    float clearDepth{0.0F};
+    std::uint32_t clearStencil{};
+
+    // The pass data is handed to the render function as the PassData* it was created as.
+    InlineFunction<void(const void*, const RenderPassContext&)> renderFunction{};
+    void* data{nullptr};
+
     std::uint32_t index{~0U};
-    std::uint8_t syncMode{SYNC_NONE};
     bool isCompute{false};
     bool isEnabled{true};
+    bool isDepthReadOnly{false};
 };
 
-export template <class PassData>
-struct RenderPass final : RenderPassBase
+export inline auto Execute(const RenderPass& renderPass, const RenderPassContext& ctx) noexcept -> void
 {
-    std::function<void(const PassData*, const RenderPassContext&)> renderFunction{};
-    PassData* data{nullptr};
-
-    auto Execute(const RenderPassContext& ctx) noexcept -> void override
+    if (renderPass.data != nullptr && renderPass.renderFunction) [[likely]]
     {
-        if (data != nullptr && renderFunction) [[likely]]
-        {
-            renderFunction(data, ctx);
-        }
+        renderPass.renderFunction(renderPass.data, ctx);
     }
-};
-
-// Initialize a render pass — not constexpr, std::function is not a literal type.
-export template <class PassData>
-auto Initialize(RenderPass<PassData>* renderPass, const bool isComputePass, const std::int32_t passIndex, PassData* passData) noexcept -> void
-{
-    if (renderPass == nullptr) [[unlikely]]
-    {
-        return;
-    }
-    renderPass->isCompute = isComputePass;
-    renderPass->index     = static_cast<std::uint32_t>(passIndex);
-    renderPass->data      = passData;
 }
 
-// Release resets a pass back to default state without deallocating.
-// Caller is responsible for deallocation (CleanupRenderGraph does this).
-export template <class PassData>
-auto Release(RenderPass<PassData>* renderPass) noexcept -> void
+// Release resets a pass back to default state; its data belongs to the graph's arena.
+export inline auto Release(RenderPass& renderPass) noexcept -> void
 {
-    if (renderPass == nullptr) [[unlikely]]
-    {
-        return;
-    }
-    renderPass->renderFunction = nullptr;
-    renderPass->data           = nullptr;
-    renderPass->colorImage     = nullptr;
-    renderPass->depthImage     = nullptr;
-    renderPass->colorImageView = nullptr;
-    renderPass->depthImageView = nullptr;
-    renderPass->waitValue      = 0ULL;
-    renderPass->signalValue    = 0ULL;
-    renderPass->index          = ~0U;
-    renderPass->syncMode       = SYNC_NONE;
-    renderPass->isCompute      = false;
-    renderPass->isEnabled      = false;
+    renderPass.renderFunction.Reset();
+    renderPass.data            = nullptr;
+    renderPass.colorImage      = nullptr;
+    renderPass.depthImage      = nullptr;
+    renderPass.colorImageView  = nullptr;
+    renderPass.depthImageView  = nullptr;
+    renderPass.colorResource   = ~0U;
+    renderPass.depthResource   = ~0U;
+    renderPass.clearColor      = {0.0F, 0.0F, 0.0F, 1.0F};
+    renderPass.clearDepth      = 0.0F;
+    renderPass.clearStencil    = 0U;
+    renderPass.index           = ~0U;
+    renderPass.isCompute       = false;
+    renderPass.isEnabled       = false;
+    renderPass.isDepthReadOnly = false;
+    renderPass.uses.clear();
 }
-
 } // namespace fawn_vision
@@ -6,9 +6,9 @@
 module;
 #include "api/vulkan/wrapper/command.hpp"
 #include "api/vulkan/wrapper/device.hpp"
-#include "api/vulkan/wrapper/queue.hpp"
 #include "api/vulkan/wrapper/semaphore.hpp"
 #include "api/vulkan/wrapper/swap_chain.hpp"
+#include "api/vulkan/wrapper/upload_ring.hpp"
 
 export module FawnVision:RenderPassContext;
 import :Buffer;
@@ -165,8 +165,9 @@ export struct RenderPassContext
     const deer_vulkan::CommandBuffer& commandBuffer;
     deer_vulkan::SwapChain& swapChain;
     const deer_vulkan::Semaphore& timelineSemaphore;
-    const deer_vulkan::Semaphore& binarySemaphore;
-    const deer_vulkan::Queue* queue;
+    deer_vulkan::UploadRing& uploadRing;
+    std::uint32_t width{}; // render area of the pass: the size of its targets
+    std::uint32_t height{};
 };
 
 // ---------------------------------------------------------------------------
@@ -315,6 +316,12 @@ export inline auto BindDescriptor(const RenderPassContext& ctx, const Descriptor
     deer_vulkan::BindDescriptor(ctx.dispatch, ctx.commandBuffer, descriptor.descriptor);
 }
 
+// dynamicOffsets has one entry per uniform_buffer_dynamic or storage_buffer_dynamic binding, in binding order; see DynamicOffset.
+export inline auto BindDescriptor(const RenderPassContext& ctx, const Descriptor& descriptor, const std::span<const std::uint32_t> dynamicOffsets) noexcept -> void
+{
+    deer_vulkan::BindDescriptor(ctx.dispatch, ctx.commandBuffer, descriptor.descriptor, dynamicOffsets);
+}
+
 export inline auto BindMesh(const RenderPassContext& ctx, const Mesh& mesh) noexcept -> void
 {
     deer_vulkan::BindIndexBuffer(ctx.dispatch, ctx.commandBuffer, mesh.indexBuffer.buffer);
@@ -325,10 +332,69 @@ export inline auto BindMesh(const RenderPassContext& ctx, const Mesh& mesh) noex
 // Data upload
 // ---------------------------------------------------------------------------
 
+// Fails when the buffer is not host visible.
 export template <typename T, auto Size = std::dynamic_extent>
-auto CopyData(const RenderPassContext& ctx, const Buffer& buffer, const std::span<const T, Size> data) noexcept -> void
+[[nodiscard]] auto CopyData(const RenderPassContext& ctx, const Buffer& buffer, const std::span<const T, Size> data) noexcept -> gfx_status
+{
+    return ToGfxStatus(deer_vulkan::CopyData(ctx.dispatch, ctx.device, buffer.buffer, data));
+}
+
+// Memory from the renderer's upload ring that stays valid until the frame recording the pass completed. Data that changes every frame goes here
+// instead of into a buffer of its own, which the GPU may still be reading from.
+export struct UploadRange
+{
+    deer_vulkan::UploadAllocation allocation{};
+};
+
+// size bytes for this frame, to be written through Mapped and then flushed. not_ok once the frame used up its partition of the ring.
+export [[nodiscard]] inline auto Allocate(const RenderPassContext& ctx, const std::uint64_t size, UploadRange& range) noexcept -> gfx_status
+{
+    return ToGfxStatus(deer_vulkan::Allocate(ctx.uploadRing, size, range.allocation));
+}
+
+export template <typename T>
+[[nodiscard]] auto Mapped(const UploadRange& range) noexcept -> std::span<T>
+{
+    return {std::bit_cast<T*>(range.allocation.pData), static_cast<std::size_t>(range.allocation.size / sizeof(T))};
+}
+
+export inline auto Flush(const RenderPassContext& ctx, const UploadRange& range) noexcept -> void
+{
+    deer_vulkan::Flush(ctx.dispatch, ctx.device, range.allocation);
+}
+
+// Copies data into the upload ring for this frame.
+export template <typename T, auto Size = std::dynamic_extent>
+[[nodiscard]] auto Upload(const RenderPassContext& ctx, const std::span<const T, Size> data, UploadRange& range) noexcept -> gfx_status
+{
+    if (const gfx_status status{Allocate(ctx, data.size_bytes(), range)}; status != gfx_status::ok) [[unlikely]]
+    {
+        return status;
+    }
+    std::memcpy(range.allocation.pData, data.data(), data.size_bytes());
+    Flush(ctx, range);
+    return gfx_status::ok;
+}
+
+// The offset to bind a uniform_buffer_dynamic or storage_buffer_dynamic descriptor with; see BindUploadRingToDescriptor.
+export [[nodiscard]] inline auto DynamicOffset(const UploadRange& range) noexcept -> std::uint32_t
+{
+    return static_cast<std::uint32_t>(range.allocation.offset);
+}
+
+export inline auto BindBuffer(const RenderPassContext& ctx, const UploadRange& range) noexcept -> void
+{
+    deer_vulkan::BindInstanceBuffer(ctx.dispatch, ctx.commandBuffer, *range.allocation.pBuffer, range.allocation.offset);
+}
+
+export inline auto BindVertexBuffer(const RenderPassContext& ctx, const UploadRange& range) noexcept -> void
+{
+    deer_vulkan::BindVertexBuffer(ctx.dispatch, ctx.commandBuffer, *range.allocation.pBuffer, range.allocation.offset);
+}
+
+export inline auto BindIndexBuffer(const RenderPassContext& ctx, const UploadRange& range) noexcept -> void
 {
-    deer_vulkan::CopyData(ctx.dispatch, ctx.device, buffer.buffer, data);
+    deer_vulkan::BindIndexBuffer(ctx.dispatch, ctx.commandBuffer, *range.allocation.pBuffer, range.allocation.offset);
 }
 
 // ---------------------------------------------------------------------------
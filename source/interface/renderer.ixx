@@ -4,6 +4,7 @@
 //
 
 module;
+#include "api/vulkan/wrapper/allocator.hpp"
 #include "api/vulkan/wrapper/command.hpp"
 #include "api/vulkan/wrapper/device.hpp"
 #include "api/vulkan/wrapper/fence.hpp"
@@ -11,13 +12,17 @@ module;
 #include "api/vulkan/wrapper/physical_device.hpp"
 #include "api/vulkan/wrapper/queue.hpp"
 #include "api/vulkan/wrapper/semaphore.hpp"
+#include "api/vulkan/wrapper/staging_queue.hpp"
 #include "api/vulkan/wrapper/surface.hpp"
 #include "api/vulkan/wrapper/swap_chain.hpp"
+#include "api/vulkan/wrapper/upload_ring.hpp"
 #include "deer_vulkan_core.hpp"
 
 export module FawnVision:Renderer;
 import :Enum;
+import :SubmitThread;
 import :Window;
+import :WorkerPool;
 import FawnAlgebra;
 
 import std;
@@ -28,6 +33,9 @@ export constexpr std::uint8_t g_graphicsQueueId{0};
 export constexpr std::uint8_t g_computeQueueId{1};
 export constexpr std::uint8_t g_presentQueueId{2};
 export constexpr std::uint8_t g_queueCount{3};
+export constexpr std::uint32_t g_maxRecordWorkers{8U}; // threads that record render graph passes, counting the one that calls ExecuteAll
+export constexpr std::uint64_t g_uploadPartitionSize{4ULL << 20U}; // bytes of per-frame data one frame can upload through the upload ring
+export constexpr std::uint64_t g_stagingSize{32ULL << 20U};         // bytes of content the staging ring holds before uploads get staging memory of their own
 
 #define GFX_CHECK(expr, ...)                                                                                                                                                       \
     if (deer_vulkan::vk_status _s = expr; deer_vulkan::IsError(_s)) [[unlikely]]                                                                                                   \
@@ -45,6 +53,43 @@ export constexpr std::uint8_t g_queueCount{3};
         std::println(std::cerr, "[GFX] {}:{} — {} | Hint: {} | Context: {}", __FILE__, __LINE__, _e.message, _e.hint, std::format(__VA_ARGS__));                                   \
     }
 
+// How frames reach the screen. A present mode the surface lacks falls back to the closest one it has (PresentMode tells which);
+// maxFramesAhead caps how many frames the CPU queues before it waits for the GPU, from 1, lowest latency, to deer_vulkan::maxFramesInFlight.
+export struct SwapChainConfig
+{
+    present_mode presentMode{present_mode::fifo};
+    std::uint32_t imageCount{}; // 0: one more than the surface minimum
+    std::uint32_t maxFramesAhead{2U};
+};
+
+// Interactive sessions: no tearing, and the CPU never runs more than one frame ahead of what is on screen.
+export constexpr SwapChainConfig g_lowLatencyConfig{.presentMode = present_mode::mailbox, .imageCount = 0U, .maxFramesAhead = 1U};
+// Benchmarks: nothing waits for vblank and the GPU always has the next frame queued.
+export constexpr SwapChainConfig g_throughputConfig{.presentMode = present_mode::immediate, .imageCount = 3U, .maxFramesAhead = deer_vulkan::maxFramesInFlight};
+
+// Command buffers one worker records for one queue in one frame; the pool belongs to that queue's family and is only ever touched by that worker.
+export struct FrameCommands
+{
+    deer_vulkan::CommandPool commandPool{};
+    std::deque<deer_vulkan::CommandBuffer> commandBuffers{}; // deque: handed out buffers stay put while the worker allocates more
+    std::uint32_t usedCommandBuffers{};
+};
+
+// An upload's place in line. Frames begun once IsUploaded says so may use what it uploaded; value 0 is never waited for.
+export struct UploadTicket
+{
+    std::uint64_t value{};
+};
+
+// Everything one frame in flight owns. A slot is reused once the timeline reaches timelineValue.
+export struct FrameData
+{
+    std::array<std::vector<FrameCommands>, g_queueCount> commands{}; // per queue, per worker; nothing is recorded for the present queue
+    deer_vulkan::Semaphore acquireSemaphore{};
+    std::uint64_t timelineValue{};
+    std::uint64_t acquireWaitValue{}; // graphics timeline value of the last frame that waited for acquireSemaphore
+};
+
 export struct Renderer
 {
     deer_vulkan::Dispatch dispatch{};
@@ -52,13 +97,26 @@ export struct Renderer
     deer_vulkan::PhysicalDevice physical{};
     deer_vulkan::Surface surface{};
     deer_vulkan::Device device{};
+    mutable deer_vulkan::Allocator allocator{}; // buffers and textures are created through a const Renderer&; it does its own locking
     std::array<deer_vulkan::Queue, g_queueCount> queue{};
+    deer_vulkan::Queue transferQueue{};
+    std::uint8_t transferQueueId{g_queueCount}; // the queue the transfer queue turned out to be, g_queueCount when it is one of its own
     deer_vulkan::SwapChain swapChain{};
-    deer_vulkan::Semaphore timelineSemaphore{};
-    deer_vulkan::Semaphore binarySemaphore{};
+    deer_vulkan::Semaphore timelineSemaphore{}; // graphics queue; the last submit of a frame signals it once everything else is done
+    deer_vulkan::Semaphore computeTimelineSemaphore{};
     deer_vulkan::Fence fence{};
     deer_vulkan::CommandPool commandPool{};
     deer_vulkan::CommandBuffer commandBuffer{};
+    std::array<FrameData, deer_vulkan::maxFramesInFlight> frames{};
+    std::vector<deer_vulkan::Semaphore> presentSemaphores{}; // one per swap chain image
+    deer_vulkan::UploadRing uploadRing{};                    // a partition per frame slot, reused once BeginFrame waited for the slot
+    mutable deer_vulkan::StagingQueue staging{};             // content uploads; staged from any thread, submitted by BeginFrame
+    WorkerPool workers{};
+    SubmitThread submitThread{}; // only runs after UseSubmitThread(renderer, true)
+    std::uint32_t frameIndex{};
+    std::uint32_t maxFramesAhead{2U}; // see SwapChainConfig
+    std::uint32_t acquireSlot{}; // frame slot whose acquire semaphore the acquired image signals; not always frameIndex with the submit thread
+    bool imageAcquired{};
 };
 
 // ---------------------------------------------------------------------------
@@ -75,10 +133,40 @@ export struct Renderer
               "compute queue");
     GFX_CHECK(Initialize(renderer.dispatch, renderer.device, renderer.physical.presentQueueFamily, renderer.physical.presentQueueIdx, renderer.queue[g_presentQueueId]),
               "present queue");
+    GFX_CHECK(Initialize(renderer.dispatch, renderer.device, renderer.physical.transferQueueFamily, renderer.physical.transferQueueIdx, renderer.transferQueue),
+              "transfer queue");
+
+    // A device without a queue to spare hands out one of the others again; submits to it then have to go where that queue's submits go.
+    const auto aliased{std::ranges::find_if(renderer.queue,
+                                            [&renderer](const deer_vulkan::Queue& queue)
+                                            {
+                                                return queue.queue == renderer.transferQueue.queue;
+                                            })};
+    renderer.transferQueueId = static_cast<std::uint8_t>(std::distance(renderer.queue.begin(), aliased));
+
+    return gfx_status::ok;
+}
+
+[[nodiscard]] inline auto InitializePresentSemaphores(Renderer& renderer) noexcept -> gfx_status
+{
+    renderer.presentSemaphores.resize(renderer.swapChain.images.size());
+    for (std::size_t i{}; i < renderer.presentSemaphores.size(); ++i)
+    {
+        GFX_CHECK(Initialize(renderer.dispatch, renderer.device, /*isTimeline=*/false, renderer.presentSemaphores[i]), "present semaphore {}", i);
+    }
 
     return gfx_status::ok;
 }
 
+inline auto CleanupPresentSemaphores(Renderer& renderer) noexcept -> void
+{
+    for (const deer_vulkan::Semaphore& semaphore : renderer.presentSemaphores)
+    {
+        Cleanup(renderer.dispatch, renderer.device, semaphore);
+    }
+    renderer.presentSemaphores.clear();
+}
+
 [[nodiscard]] inline auto InitializeComponents(const Window& window, Renderer& renderer) noexcept -> gfx_status
 {
     using namespace deer_vulkan;
@@ -90,48 +178,511 @@ export struct Renderer
 
     GFX_CHECK(Initialize(renderer.dispatch, renderer.device, renderer.surface, window.width, window.height, renderer.swapChain), "swapchain ({}x{})", window.width, window.height);
     GFX_CHECK(Initialize(renderer.dispatch, renderer.device, /*isTimeline=*/true, renderer.timelineSemaphore), "timeline semaphore");
-    GFX_CHECK(Initialize(renderer.dispatch, renderer.device, /*isTimeline=*/false, renderer.binarySemaphore), "binary semaphore");
+    GFX_CHECK(Initialize(renderer.dispatch, renderer.device, /*isTimeline=*/true, renderer.computeTimelineSemaphore), "compute timeline semaphore");
     GFX_CHECK(Initialize(renderer.dispatch, renderer.device, renderer.physical.graphicsQueueFamily, renderer.commandPool), "command pool (family={})",
               renderer.physical.graphicsQueueFamily);
     GFX_CHECK(CreateCommandBuffer(renderer.dispatch, renderer.device, renderer.commandPool, 1U, renderer.commandBuffer), "primary command buffer");
+    GFX_CHECK(Initialize(renderer.dispatch, renderer.device, renderer.allocator, renderer.physical, g_uploadPartitionSize, maxFramesInFlight, renderer.uploadRing),
+              "upload ring ({} bytes per frame)", g_uploadPartitionSize);
+    GFX_CHECK(Initialize(renderer.dispatch, renderer.device, renderer.allocator, g_stagingSize, renderer.physical.transferQueueFamily, renderer.physical.graphicsQueueFamily,
+                         renderer.staging),
+              "staging queue ({} bytes, transfer family={})", g_stagingSize, renderer.physical.transferQueueFamily);
 
-    return gfx_status::ok;
+    Initialize(renderer.workers, std::clamp(std::thread::hardware_concurrency(), 1U, g_maxRecordWorkers) - 1U);
+    const std::uint32_t workerCount{WorkerCount(renderer.workers)};
+    for (std::uint32_t i{}; i < deer_vulkan::maxFramesInFlight; ++i)
+    {
+        FrameData& frame{renderer.frames[i]};
+        frame.commands[g_graphicsQueueId].resize(workerCount);
+        frame.commands[g_computeQueueId].resize(workerCount);
+        for (std::uint32_t w{}; w < workerCount; ++w)
+        {
+            GFX_CHECK(Initialize(renderer.dispatch, renderer.device, renderer.physical.graphicsQueueFamily, frame.commands[g_graphicsQueueId][w].commandPool),
+                      "frame {} worker {} graphics command pool", i, w);
+            GFX_CHECK(Initialize(renderer.dispatch, renderer.device, renderer.physical.computeQueueFamily, frame.commands[g_computeQueueId][w].commandPool),
+                      "frame {} worker {} compute command pool", i, w);
+        }
+        GFX_CHECK(Initialize(renderer.dispatch, renderer.device, /*isTimeline=*/false, frame.acquireSemaphore), "frame {} acquire semaphore", i);
+    }
+
+    return InitializePresentSemaphores(renderer);
 }
 
 inline auto CleanupComponents(Renderer& renderer) noexcept -> void
 {
+    CleanupPresentSemaphores(renderer);
+    for (FrameData& frame : renderer.frames)
+    {
+        for (std::vector<FrameCommands>& queueCommands : frame.commands)
+        {
+            for (FrameCommands& commands : queueCommands)
+            {
+                for (deer_vulkan::CommandBuffer& commandBuffer : commands.commandBuffers)
+                {
+                    Cleanup(renderer.dispatch, renderer.device, commands.commandPool, commandBuffer);
+                }
+                commands.commandBuffers.clear();
+                Cleanup(renderer.dispatch, renderer.device, commands.commandPool);
+            }
+        }
+        Cleanup(renderer.dispatch, renderer.device, frame.acquireSemaphore);
+        frame = {};
+    }
+    Cleanup(renderer.submitThread);
+    Cleanup(renderer.workers);
+    Cleanup(renderer.dispatch, renderer.device, renderer.allocator, renderer.uploadRing);
+    Cleanup(renderer.dispatch, renderer.device, renderer.allocator, renderer.staging);
+    renderer.frameIndex    = 0U;
+    renderer.imageAcquired = false;
+
     Cleanup(renderer.dispatch, renderer.device, renderer.commandPool, renderer.commandBuffer);
     Cleanup(renderer.dispatch, renderer.device, renderer.commandPool);
-    Cleanup(renderer.dispatch, renderer.device, renderer.binarySemaphore);
     Cleanup(renderer.dispatch, renderer.device, renderer.timelineSemaphore);
+    Cleanup(renderer.dispatch, renderer.device, renderer.computeTimelineSemaphore);
+    renderer.timelineSemaphore        = {};
+    renderer.computeTimelineSemaphore = {};
+}
+
+inline auto WaitIdle(const Renderer& renderer) noexcept -> void
+{
+    Flush(renderer.submitThread);
+    for (const deer_vulkan::Queue& queue : renderer.queue)
+    {
+        if (queue.queue != nullptr)
+        {
+            WaitIdle(renderer.dispatch, queue);
+        }
+    }
+    if (renderer.transferQueue.queue != nullptr)
+    {
+        WaitIdle(renderer.dispatch, renderer.transferQueue);
+    }
+}
+
+// Each queue the graph submits to counts its submits on its own timeline.
+[[nodiscard]] inline auto QueueTimeline(Renderer& renderer, const std::uint8_t queueId) noexcept -> deer_vulkan::Semaphore&
+{
+    return queueId == g_computeQueueId ? renderer.computeTimelineSemaphore : renderer.timelineSemaphore;
+}
+
+// Submits right away, or hands the submit to the submit thread when it runs; waits and signals are copied either way.
+[[nodiscard]] inline auto SubmitCommands(Renderer& renderer, const std::uint8_t queueId, const std::span<const deer_vulkan::CommandBuffer* const> commandBuffers,
+                                         const std::span<const deer_vulkan::SemaphoreSubmit> waits, const std::span<const deer_vulkan::SemaphoreSubmit> signals) noexcept
+    -> deer_vulkan::vk_status
+{
+    if (IsRunning(renderer.submitThread))
+    {
+        return AddSubmit(renderer.submitThread, queueId, commandBuffers, waits, signals);
+    }
+    return deer_vulkan::QueueSubmit(renderer.dispatch, renderer.queue[queueId], commandBuffers, waits, signals);
+}
+
+// ---------------------------------------------------------------------------
+// Uploads
+// ---------------------------------------------------------------------------
+
+// Stages a copy into [offset, offset + data.size()) of a buffer that was created with transfer_dst usage. Safe to call from any thread.
+[[nodiscard]] inline auto StageBuffer(const Renderer& renderer, const std::span<const std::byte> data, deer_vulkan::Buffer& buffer, const std::uint64_t offset,
+                                      UploadTicket& ticket) noexcept -> gfx_status
+{
+    GFX_CHECK(Stage(renderer.dispatch, renderer.device, renderer.allocator, renderer.staging, data, deer_vulkan::StagingCopy{.pBuffer = &buffer, .dstOffset = offset},
+                    ticket.value),
+              "staging {} bytes for a buffer", data.size());
+
+    return gfx_status::ok;
+}
+
+// Stages tightly packed texels for mip 0 of every layer of an image that was created with transfer_dst usage. The image ends up in finalLayout,
+// with the mips below mip 0 blitted from it when generateMips is set (which takes transfer_src usage as well). Safe to call from any thread.
+[[nodiscard]] inline auto StageImage(const Renderer& renderer, const std::span<const std::byte> data, deer_vulkan::Image& image, const std::uint32_t width,
+                                     const std::uint32_t height, const std::uint32_t depth, const image_layout finalLayout, const bool generateMips, UploadTicket& ticket) noexcept
+    -> gfx_status
+{
+    const deer_vulkan::StagingCopy copy{
+        .pImage       = &image,
+        .width        = width,
+        .height       = height,
+        .depth        = depth,
+        .finalLayout  = static_cast<std::uint32_t>(finalLayout),
+        .generateMips = generateMips,
+    };
+    GFX_CHECK(Stage(renderer.dispatch, renderer.device, renderer.allocator, renderer.staging, data, copy, ticket.value), "staging {} bytes for a {}x{}x{} image",
+              data.size(), width, height, depth);
+
+    return gfx_status::ok;
+}
+
+// Straight to the transfer queue when it is one of its own, which nothing else submits to; otherwise wherever the queue it shares goes.
+[[nodiscard]] inline auto SubmitTransfer(Renderer& renderer, const deer_vulkan::CommandBuffer& commandBuffer, const std::span<const deer_vulkan::SemaphoreSubmit> signals) noexcept
+    -> deer_vulkan::vk_status
+{
+    const deer_vulkan::CommandBuffer* pCommandBuffer{&commandBuffer};
+    if (renderer.transferQueueId == g_queueCount)
+    {
+        return deer_vulkan::QueueSubmit(renderer.dispatch, renderer.transferQueue, std::span{&pCommandBuffer, 1U}, {}, signals);
+    }
+    return SubmitCommands(renderer, renderer.transferQueueId, std::span{&pCommandBuffer, 1U}, {}, signals);
+}
+
+// Hands the graphics queue the batches whose copies completed, then sends everything staged since the last call to the transfer queue. Never waits:
+// a graphics part only goes out once its copies are done, so the frames behind it are not held up by the transfer queue. When the transfer queue is
+// the graphics queue, there is nothing to overlap and both parts of a batch go out together.
+[[nodiscard]] inline auto SubmitUploads(Renderer& renderer) noexcept -> gfx_status
+{
+    using namespace deer_vulkan;
+    StagingQueue& staging{renderer.staging};
+    GFX_CHECK(Reclaim(renderer.dispatch, renderer.device, renderer.allocator, staging), "reclaiming staging memory");
+
+    const bool isGraphicsQueue{renderer.transferQueueId == g_graphicsQueueId};
+    for (std::uint64_t value{staging.readyValue.load(std::memory_order_relaxed) + 1U}; !isGraphicsQueue && value <= staging.copiedValue; ++value)
+    {
+        const CommandBuffer* pCommandBuffer{&RecordGraphicsPart(renderer.dispatch, staging, value).graphics};
+        const std::array waits{SemaphoreSubmit{.semaphore = &staging.transferTimeline, .value = value}};
+        const std::array signals{SemaphoreSubmit{.semaphore = &staging.timeline, .value = value}};
+        GFX_CHECK(SubmitCommands(renderer, g_graphicsQueueId, std::span{&pCommandBuffer, 1U}, waits, signals), "submitting upload batch {} to the graphics queue", value);
+        staging.readyValue.store(value, std::memory_order_release);
+    }
+
+    std::uint64_t value{};
+    const StagingBatch* pBatch{BeginTransferBatch(renderer.dispatch, staging, value)};
+    if (pBatch == nullptr)
+    {
+        return gfx_status::ok;
+    }
+    if (!isGraphicsQueue)
+    {
+        const std::array signals{SemaphoreSubmit{.semaphore = &staging.transferTimeline, .value = value}};
+        GFX_CHECK(SubmitTransfer(renderer, pBatch->transfer, signals), "submitting upload batch {} ({} copies) to the transfer queue", value, pBatch->copies.size());
+        return gfx_status::ok;
+    }
+
+    static_cast<void>(RecordGraphicsPart(renderer.dispatch, staging, value));
+    const std::array<const CommandBuffer*, 2> commandBuffers{&pBatch->transfer, &pBatch->graphics};
+    const std::array signals{SemaphoreSubmit{.semaphore = &staging.transferTimeline, .value = value}, SemaphoreSubmit{.semaphore = &staging.timeline, .value = value}};
+    GFX_CHECK(SubmitCommands(renderer, g_graphicsQueueId, commandBuffers, {}, signals), "submitting upload batch {} ({} copies)", value, pBatch->copies.size());
+    staging.readyValue.store(value, std::memory_order_release);
+
+    return gfx_status::ok;
+}
+
+// For the first graphics submit of a frame: the wait for the uploads that became ready since the last frame that waited. False when there are none.
+[[nodiscard]] inline auto TakeUploadWait(Renderer& renderer, deer_vulkan::SemaphoreSubmit& wait) noexcept -> bool
+{
+    const std::uint64_t readyValue{renderer.staging.readyValue.load(std::memory_order_relaxed)};
+    if (readyValue == renderer.staging.waitedValue)
+    {
+        return false;
+    }
+    renderer.staging.waitedValue = readyValue;
+    wait                         = {.semaphore = &renderer.staging.timeline, .value = readyValue};
+    return true;
+}
+
+// Whether frames begun from now on may use what the upload wrote. Safe to call from any thread.
+export [[nodiscard]] inline auto IsUploaded(const Renderer& renderer, const UploadTicket ticket) noexcept -> bool
+{
+    return ticket.value <= renderer.staging.readyValue.load(std::memory_order_acquire);
+}
+
+// Blocks until IsUploaded, submitting whatever it takes. For content a frame cannot go without, like what a level needs before its first frame;
+// anything else streams in on its own once BeginFrame submitted it. Call it between frames.
+export [[nodiscard]] inline auto WaitForUpload(Renderer& renderer, const UploadTicket ticket) noexcept -> gfx_status
+{
+    deer_vulkan::StagingQueue& staging{renderer.staging};
+    while (!IsUploaded(renderer, ticket))
+    {
+        if (const gfx_status status{SubmitUploads(renderer)}; status != gfx_status::ok) [[unlikely]]
+        {
+            return status;
+        }
+        QueueFrame(renderer.submitThread); // hands the submit thread what SubmitUploads gave it, if it runs
+        if (IsUploaded(renderer, ticket))
+        {
+            break;
+        }
+
+        // Either the next batch's copies are on the transfer queue, or every batch is in use and the oldest has to finish first.
+        const std::uint64_t next{staging.readyValue.load(std::memory_order_relaxed) + 1U};
+        const bool isCopying{next <= staging.submittedValue};
+        const deer_vulkan::Semaphore& semaphore{isCopying ? staging.transferTimeline : staging.timeline};
+        const std::uint64_t value{isCopying ? next : staging.completedValue + 1U};
+        GFX_CHECK(Wait(renderer.dispatch, renderer.device, semaphore, value), "waiting for upload batch {}", value);
+    }
+
+    return gfx_status::ok;
+}
+
+// ---------------------------------------------------------------------------
+// Frame lifecycle
+// ---------------------------------------------------------------------------
+
+// Waits until no more than maxFramesAhead - 1 earlier frames are still on the GPU, which also frees the current slot.
+// BeginFrame does this anyway; calling it before sampling input keeps that input as fresh as the latency limit allows.
+export [[nodiscard]] inline auto WaitForFrameLatency(const Renderer& renderer) noexcept -> gfx_status
+{
+    const std::uint32_t framesAhead{std::clamp(renderer.maxFramesAhead, 1U, static_cast<std::uint32_t>(deer_vulkan::maxFramesInFlight))};
+    const std::uint32_t slot{(renderer.frameIndex + deer_vulkan::maxFramesInFlight - framesAhead) % deer_vulkan::maxFramesInFlight};
+    const std::uint64_t value{renderer.frames[slot].timelineValue}; // of the frame framesAhead frames back
+    GFX_CHECK(Wait(renderer.dispatch, renderer.device, renderer.timelineSemaphore, value), "waiting on frame {} (value={})", slot, value);
+
+    return gfx_status::ok;
+}
+
+// Waits for the frame latency limit, which frees the current frame slot, recycles the slot's command buffers and upload ring partition, and submits
+// the content uploads staged since the last frame.
+[[nodiscard]] inline auto BeginFrame(Renderer& renderer) noexcept -> gfx_status
+{
+    if (const gfx_status status{WaitForFrameLatency(renderer)}; status != gfx_status::ok) [[unlikely]]
+    {
+        return status;
+    }
+    BeginPartition(renderer.uploadRing, renderer.frameIndex);
+    if (const gfx_status status{SubmitUploads(renderer)}; status != gfx_status::ok) [[unlikely]]
+    {
+        return status;
+    }
+    FrameData& frame{renderer.frames[renderer.frameIndex]};
+    for (std::vector<FrameCommands>& queueCommands : frame.commands)
+    {
+        for (FrameCommands& commands : queueCommands)
+        {
+            Reset(renderer.dispatch, renderer.device, commands.commandPool);
+            commands.usedCommandBuffers = 0U;
+        }
+    }
+
+    return gfx_status::ok;
+}
+
+// Hands out the next command buffer of the current frame for a queue from a worker's pool, allocating one the first time the slot needs it.
+// Safe to call from several workers at once as long as each passes its own index.
+[[nodiscard]] inline auto NextCommandBuffer(Renderer& renderer, const std::uint8_t queueId, const std::uint32_t worker, const deer_vulkan::CommandBuffer*& commandBuffer) noexcept
+    -> gfx_status
+{
+    FrameCommands& commands{renderer.frames[renderer.frameIndex].commands[queueId][worker]};
+    if (commands.usedCommandBuffers == commands.commandBuffers.size())
+    {
+        deer_vulkan::CommandBuffer created{};
+        GFX_CHECK(CreateCommandBuffer(renderer.dispatch, renderer.device, commands.commandPool, 1U, created), "frame {} queue {} worker {} command buffer {}",
+                  renderer.frameIndex, queueId, worker, commands.usedCommandBuffers);
+        commands.commandBuffers.emplace_back(std::move(created));
+    }
+    commandBuffer = &commands.commandBuffers[commands.usedCommandBuffers++];
+
+    return gfx_status::ok;
+}
+
+// Runs on the submit thread. Only touches what stays put while frames are in flight: queues, semaphores and the swap chain handle.
+inline auto ProcessQueuedFrame(void* pContext, QueuedFrame& frame) noexcept -> void
+{
+    Renderer& renderer{*static_cast<Renderer*>(pContext)};
+    deer_vulkan::vk_status status{deer_vulkan::vk_status::ok};
+    for (const QueuedSubmit& submit : frame.submits)
+    {
+        status = deer_vulkan::QueueSubmit(renderer.dispatch, renderer.queue[submit.queueId],
+                                          std::span{frame.commandBuffers}.subspan(submit.firstCommandBuffer, submit.commandBufferCount),
+                                          std::span{submit.waits.data(), submit.waitCount}, std::span{submit.signals.data(), submit.signalCount});
+        ReportStatus(renderer.submitThread, status);
+        if (deer_vulkan::IsError(status)) [[unlikely]]
+        {
+            break; // later submits wait for what this one would have signalled, and so would the present
+        }
+    }
+
+    if (frame.pPresentWait != nullptr && !deer_vulkan::IsError(status))
+    {
+        status = Present(renderer.dispatch, renderer.queue[g_presentQueueId], renderer.swapChain, frame.imageIndex, *frame.pPresentWait);
+        ReportStatus(renderer.submitThread, status);
+    }
+    if (frame.acquireSlot == ~0U)
+    {
+        return;
+    }
+
+    // A swap chain that has to be recreated, or a frame that failed, gets no more images; the frame that wanted one finds out through the status.
+    AcquiredImage acquired{.status     = deer_vulkan::IsError(status) ? status : deer_vulkan::vk_status::out_of_date,
+                           .imageIndex = 0U,
+                           .slot       = frame.acquireSlot};
+    if (status == deer_vulkan::vk_status::ok)
+    {
+        acquired.status = Wait(renderer.dispatch, renderer.device, renderer.timelineSemaphore, frame.acquireAfterValue);
+        if (!deer_vulkan::IsError(acquired.status))
+        {
+            acquired.status = NextImage(renderer.dispatch, renderer.device, renderer.swapChain, renderer.frames[frame.acquireSlot].acquireSemaphore, acquired.imageIndex);
+        }
+    }
+    PublishAcquire(renderer.submitThread, acquired);
+}
+
+// Takes the image the submit thread acquired last. Returns the acquire's own status.
+[[nodiscard]] inline auto TakeQueuedImage(Renderer& renderer) noexcept -> deer_vulkan::vk_status
+{
+    const AcquiredImage acquired{TakeAcquire(renderer.submitThread)};
+    if (!deer_vulkan::IsError(acquired.status))
+    {
+        renderer.swapChain.currentFrameIdx = acquired.imageIndex;
+        renderer.acquireSlot               = acquired.slot;
+        renderer.imageAcquired             = true;
+    }
+    return acquired.status;
+}
+
+// Gives up on the acquired image. Its acquire semaphore may still be signalled, and a new one is the only way to use the slot again.
+[[nodiscard]] inline auto DropAcquiredImage(Renderer& renderer) noexcept -> gfx_status
+{
+    if (!renderer.imageAcquired)
+    {
+        return gfx_status::ok;
+    }
+    renderer.imageAcquired = false;
+    deer_vulkan::Semaphore& semaphore{renderer.frames[renderer.acquireSlot].acquireSemaphore};
+    Cleanup(renderer.dispatch, renderer.device, semaphore);
+    GFX_CHECK(Initialize(renderer.dispatch, renderer.device, /*isTimeline=*/false, semaphore), "frame {} acquire semaphore", renderer.acquireSlot);
+
+    return gfx_status::ok;
+}
+
+// A frame whose submit failed presents nothing, so the image it acquired is dropped; that leaves no signalled semaphore behind for the next frame.
+[[nodiscard]] inline auto SubmitFrameCommands(Renderer& renderer, const std::uint8_t queueId, const std::span<const deer_vulkan::CommandBuffer* const> commandBuffers,
+                                              const std::span<const deer_vulkan::SemaphoreSubmit> waits, const std::span<const deer_vulkan::SemaphoreSubmit> signals) noexcept
+    -> deer_vulkan::vk_status
+{
+    const deer_vulkan::vk_status status{SubmitCommands(renderer, queueId, commandBuffers, waits, signals)};
+    if (deer_vulkan::IsError(status)) [[unlikely]]
+    {
+        static_cast<void>(DropAcquiredImage(renderer));
+    }
+    return status;
+}
+
+// An image acquired by an earlier frame that never got to present it is used again.
+[[nodiscard]] inline auto AcquireImage(Renderer& renderer) noexcept -> gfx_status
+{
+    if (renderer.imageAcquired)
+    {
+        return gfx_status::ok;
+    }
+
+    deer_vulkan::vk_status status{};
+    if (IsRunning(renderer.submitThread))
+    {
+        // Normally acquired already, right after the thread presented the previous frame; otherwise ask for one now and wait.
+        if (!HasQueuedAcquire(renderer.submitThread))
+        {
+            QueuedFrame& frame{OpenFrame(renderer.submitThread)};
+            frame.acquireSlot       = renderer.frameIndex;
+            frame.acquireAfterValue = renderer.frames[renderer.frameIndex].acquireWaitValue;
+            QueueFrame(renderer.submitThread);
+        }
+        status = TakeQueuedImage(renderer);
+    }
+    else
+    {
+        status = NextImage(renderer.dispatch, renderer.device, renderer.swapChain, renderer.frames[renderer.frameIndex].acquireSemaphore);
+        renderer.acquireSlot = renderer.frameIndex;
+    }
+    if (status == deer_vulkan::vk_status::out_of_date)
+    {
+        return gfx_status::regenerate;
+    }
+    GFX_CHECK(status, "acquiring swap chain image");
+    renderer.imageAcquired = true;
+
+    return gfx_status::ok;
+}
+
+// With the submit thread, the frame's submits and present are queued and the thread acquires the next frame's image as soon as it presented,
+// so the next frame does not have to wait for the driver. Problems the thread ran into show up here, a frame or so late.
+[[nodiscard]] inline auto EndFrameOnSubmitThread(Renderer& renderer) noexcept -> gfx_status
+{
+    if (renderer.imageAcquired)
+    {
+        QueuedFrame& frame{OpenFrame(renderer.submitThread)};
+        frame.pPresentWait      = &renderer.presentSemaphores[renderer.swapChain.currentFrameIdx];
+        frame.imageIndex        = renderer.swapChain.currentFrameIdx;
+        frame.acquireSlot       = renderer.frameIndex;
+        frame.acquireAfterValue = renderer.frames[renderer.frameIndex].acquireWaitValue;
+        renderer.imageAcquired  = false;
+    }
+    QueueFrame(renderer.submitThread);
+
+    const deer_vulkan::vk_status status{TakeStatus(renderer.submitThread)};
+    if (status == deer_vulkan::vk_status::out_of_date || status == deer_vulkan::vk_status::suboptimal)
+    {
+        return gfx_status::regenerate;
+    }
+    GFX_CHECK(status, "submit thread");
+
+    return gfx_status::ok;
+}
+
+// Records the slot's timeline value, presents the acquired image (if any) and moves on to the next slot.
+[[nodiscard]] inline auto EndFrame(Renderer& renderer) noexcept -> gfx_status
+{
+    renderer.frames[renderer.frameIndex].timelineValue = renderer.timelineSemaphore.value;
+    renderer.frameIndex                                = (renderer.frameIndex + 1U) % deer_vulkan::maxFramesInFlight;
+    if (renderer.imageAcquired)
+    {
+        renderer.frames[renderer.acquireSlot].acquireWaitValue = renderer.timelineSemaphore.value;
+    }
+    if (IsRunning(renderer.submitThread))
+    {
+        return EndFrameOnSubmitThread(renderer);
+    }
+    if (!renderer.imageAcquired)
+    {
+        return gfx_status::ok;
+    }
+
+    renderer.imageAcquired = false;
+    const deer_vulkan::vk_status status{
+        Present(renderer.dispatch, renderer.queue[g_presentQueueId], renderer.swapChain, renderer.presentSemaphores[renderer.swapChain.currentFrameIdx])};
+    if (status == deer_vulkan::vk_status::out_of_date || status == deer_vulkan::vk_status::suboptimal)
+    {
+        return gfx_status::regenerate;
+    }
+    GFX_CHECK(status, "presenting image {}", renderer.swapChain.currentFrameIdx);
+
+    return gfx_status::ok;
 }
 
 // ---------------------------------------------------------------------------
 // Public API
 // ---------------------------------------------------------------------------
 
-export [[nodiscard]] inline auto CreateRenderer(const Window& window, Renderer& renderer) noexcept -> gfx_status
+inline auto ApplySwapChainConfig(Renderer& renderer, const SwapChainConfig& config) noexcept -> void
+{
+    renderer.swapChain.settings = {.presentMode = static_cast<std::uint32_t>(config.presentMode), .imageCount = config.imageCount};
+    renderer.maxFramesAhead     = config.maxFramesAhead;
+}
+
+export [[nodiscard]] inline auto CreateRenderer(const Window& window, Renderer& renderer, const SwapChainConfig& config = {}) noexcept -> gfx_status
 {
     using namespace deer_vulkan;
+    ApplySwapChainConfig(renderer, config);
     Initialize(renderer.dispatch);
     GFX_CHECK(Initialize(renderer.dispatch, renderer.instance), "instance creation");
     GFX_CHECK(Initialize(window.pWindow, renderer.instance, renderer.surface), "surface creation for window '{}'", std::bit_cast<size_t>(window.pWindow));
     GFX_CHECK(SelectPhysicalDevice(renderer.dispatch, renderer.instance, renderer.physical), "physical device selection");
     GetSurfaceCapabilities(renderer.dispatch, renderer.physical, renderer.surface);
     GFX_CHECK(Initialize(renderer.dispatch, renderer.physical, renderer.device), "logical device selection");
+    Initialize(renderer.physical, renderer.allocator);
 
     return InitializeComponents(window, renderer);
 }
 
 export inline auto ReleaseRenderer(Renderer& renderer) noexcept -> void
 {
+    WaitIdle(renderer);
     CleanupComponents(renderer);
     Cleanup(renderer.dispatch, renderer.device, renderer.swapChain);
     for (auto& q : renderer.queue)
     {
         Cleanup(q);
     }
+    Cleanup(renderer.transferQueue);
 
+    Cleanup(renderer.dispatch, renderer.device, renderer.allocator);
     Cleanup(renderer.dispatch, renderer.device);
     Cleanup(renderer.instance, renderer.surface);
     Cleanup(renderer.dispatch, renderer.instance);
@@ -139,12 +690,57 @@ export inline auto ReleaseRenderer(Renderer& renderer) noexcept -> void
 
 export [[nodiscard]] inline auto RecreateRenderer(const Window& window, Renderer& renderer) noexcept -> gfx_status
 {
-    WaitIdle(renderer.dispatch, renderer.queue[g_presentQueueId]);
+    WaitIdle(renderer);
+    if (HasQueuedAcquire(renderer.submitThread))
+    {
+        static_cast<void>(TakeQueuedImage(renderer));
+    }
+    static_cast<void>(TakeStatus(renderer.submitThread));
+    if (const gfx_status status{DropAcquiredImage(renderer)}; status != gfx_status::ok) [[unlikely]]
+    {
+        return status;
+    }
 
-    CleanupComponents(renderer);
+    // Frame slots survive a resize; only the per-image semaphores follow the swap chain.
+    CleanupPresentSemaphores(renderer);
     GetSurfaceCapabilities(renderer.dispatch, renderer.physical, renderer.surface);
     GFX_CHECK(Recreate(renderer.dispatch, renderer.device, renderer.surface, renderer.swapChain, window.width, window.height), "recreating swap chain");
 
-    return InitializeComponents(window, renderer);
+    return InitializePresentSemaphores(renderer);
+}
+
+// Moves submit, present and acquire to a thread of their own, or back to the thread that calls ExecuteAll. On that thread, the driver blocking in
+// present (or submit) no longer comes out of the frame; frames only wait when they catch up with the GPU or the thread falls a whole queue behind.
+// Call it between frames.
+export inline auto UseSubmitThread(Renderer& renderer, const bool enable) noexcept -> void
+{
+    if (enable == IsRunning(renderer.submitThread))
+    {
+        return;
+    }
+    if (enable)
+    {
+        Initialize(renderer.submitThread, ProcessQueuedFrame, &renderer);
+        return;
+    }
+
+    Cleanup(renderer.submitThread);
+    if (HasQueuedAcquire(renderer.submitThread))
+    {
+        static_cast<void>(TakeQueuedImage(renderer)); // kept for the next frame; a failed acquire is simply made again
+    }
+}
+
+// Switches between latency and throughput setups at run time; the swap chain is recreated with the new present mode and image count.
+export [[nodiscard]] inline auto ConfigureSwapChain(const Window& window, Renderer& renderer, const SwapChainConfig& config) noexcept -> gfx_status
+{
+    ApplySwapChainConfig(renderer, config);
+    return RecreateRenderer(window, renderer);
+}
+
+// The present mode the swap chain ended up with.
+export [[nodiscard]] inline auto PresentMode(const Renderer& renderer) noexcept -> present_mode
+{
+    return static_cast<present_mode>(renderer.swapChain.presentMode);
 }
 } // namespace fawn_vision
@@ -5,6 +5,7 @@
 
 module;
 #include "api/vulkan/wrapper/shader.hpp"
+#include "headers/profiler.hpp"
 
 export module FawnVision:Shader;
 import :Enum;
@@ -47,6 +48,7 @@ export template <auto Size = std::dynamic_extent>
 [[nodiscard]] auto CreateShader(const Renderer& renderer, const std::span<const ShaderData, Size>& shaderCreateInfo, Shader& shader,
                                        const Descriptor* descriptor = nullptr) noexcept -> gfx_status
 {
+    BALBINO_PROFILE_ZONE("Create Shader");
     const std::size_t count = shaderCreateInfo.size();
 
     std::vector<std::uint32_t> stages(count);
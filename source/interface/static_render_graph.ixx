@@ -0,0 +1,699 @@
+//
+// Copyright (c) 2026.
+// Author: Joran.
+//
+
+module;
+#include "api/vulkan/wrapper/command.hpp"
+#include "api/vulkan/wrapper/queue.hpp"
+#include "api/vulkan/wrapper/swap_chain.hpp"
+#include "headers/profiler.hpp"
+
+export module FawnVision:StaticRenderGraph;
+import :Buffer;
+import :Enum;
+import :Renderer;
+import :RenderGraph;
+import :RenderPass;
+import :RenderPassContext;
+import :Texture;
+
+import std;
+
+#define GFX_CHECK(expr, ...)                                                                                                                                                       \
+    if (deer_vulkan::vk_status _s = expr; deer_vulkan::IsError(_s)) [[unlikely]]                                                                                                   \
+    {                                                                                                                                                                              \
+        auto _e = deer_vulkan::GetError(_s);                                                                                                                                       \
+        std::println(std::cerr, "[GFX] {}:{} — {} | Hint: {} | Context: {}", __FILE__, __LINE__, _e.message, _e.hint, std::format(__VA_ARGS__));                                   \
+        return ToGfxStatus(_s);                                                                                                                                                    \
+    }
+
+// A render graph whose passes and resources are fixed when the program is compiled. The graph is a type: pass order, culling, barriers and attachment ops
+// are worked out by the compiler, a dependency that cannot be met does not compile, and executing it is a straight line of inlined pass calls.
+//
+//   struct Lighting
+//   {
+//       static constexpr bool isCompute{false};
+//       static constexpr std::array uses{StaticRead(1U, texture_read::sampled_fragment), StaticColorTarget(0U)};
+//       auto Execute(const RenderPassContext& context) noexcept -> void;
+//   };
+//   using Frame = StaticRenderGraph<StaticResources<StaticResource{.isSwapChain = true}, StaticResource{}>, GBuffer, Lighting>;
+//
+// Passes may be listed in any order: a pass that reads a resource runs after every pass that writes it, passes writing the same resource keep their listed order.
+// Everything runs on the graphics queue in one submit, and raster passes render at the size of the swap chain.
+namespace fawn_vision
+{
+// Resources are numbered by their position in the graph's StaticResources list.
+export struct StaticResource
+{
+    bool isBuffer{false};
+    bool isImported{false};  // holds data from outside the graph, so passes may read it before any pass writes it
+    bool isExported{false};  // read outside the graph, so passes writing it are never culled
+    bool isSwapChain{false}; // the acquired swap chain image; always exported and left ready to present
+};
+
+export template <StaticResource... Resources>
+struct StaticResources
+{
+    static constexpr std::array<StaticResource, sizeof...(Resources)> list{Resources...};
+};
+
+export enum class static_attachment : std::uint8_t {
+    none            = 0,
+    color           = 1,
+    depth           = 2,
+    depth_read_only = 3,
+};
+
+export struct StaticUse
+{
+    ResourceUse use{};
+    static_attachment attachment{static_attachment::none};
+};
+
+export [[nodiscard]] constexpr auto StaticRead(const std::uint32_t resource, const texture_read access) noexcept -> StaticUse
+{
+    ResourceUse use{ToResourceUse(access)};
+    use.resource = resource;
+    return {.use = use};
+}
+
+export [[nodiscard]] constexpr auto StaticWrite(const std::uint32_t resource, const texture_write access) noexcept -> StaticUse
+{
+    ResourceUse use{ToResourceUse(access)};
+    use.resource = resource;
+    return {.use = use};
+}
+
+export [[nodiscard]] constexpr auto StaticRead(const std::uint32_t resource, const buffer_read access) noexcept -> StaticUse
+{
+    ResourceUse use{ToResourceUse(access)};
+    use.resource = resource;
+    return {.use = use};
+}
+
+export [[nodiscard]] constexpr auto StaticWrite(const std::uint32_t resource, const buffer_write access) noexcept -> StaticUse
+{
+    ResourceUse use{ToResourceUse(access)};
+    use.resource = resource;
+    return {.use = use};
+}
+
+export [[nodiscard]] constexpr auto StaticColorTarget(const std::uint32_t resource) noexcept -> StaticUse
+{
+    return {.use        = {.resource = resource,
+                           .stage    = StageBits(pipeline_stage::color_attachment_output),
+                           .access   = AccessBits(memory_access::color_attachment_read | memory_access::color_attachment_write),
+                           .layout   = image_layout::attachment_optimal,
+                           .isWrite  = true},
+            .attachment = static_attachment::color};
+}
+
+export [[nodiscard]] constexpr auto StaticDepthTarget(const std::uint32_t resource, const bool readOnly = false) noexcept -> StaticUse
+{
+    return {.use        = {.resource = resource,
+                           .stage    = StageBits(pipeline_stage::early_fragment_tests | pipeline_stage::late_fragment_tests),
+                           .access   = readOnly ? AccessBits(memory_access::depth_stencil_attachment_read)
+                                                : AccessBits(memory_access::depth_stencil_attachment_read | memory_access::depth_stencil_attachment_write),
+                           .layout   = readOnly ? image_layout::read_only_optimal : image_layout::attachment_optimal,
+                           .isWrite  = !readOnly},
+            .attachment = readOnly ? static_attachment::depth_read_only : static_attachment::depth};
+}
+
+// A pass lists what it touches in a constexpr `uses` array and records its work in a noexcept Execute.
+// Raster passes may also declare constexpr clearColor and clearDepth; the defaults match those of a dynamic pass.
+export template <class Pass>
+concept static_render_pass = std::is_default_constructible_v<Pass> && requires(Pass& pass, const RenderPassContext& context) {
+    { std::span<const StaticUse>{Pass::uses} };
+    { Pass::isCompute } -> std::convertible_to<bool>;
+    { pass.Execute(context) } noexcept;
+};
+
+enum class static_graph_error : std::uint8_t {
+    none,
+    unknown_resource,  // a use names a resource past the end of the list
+    duplicate_use,     // a pass names the same resource twice
+    resource_kind,     // a texture use of a buffer, or the other way around
+    attachment_use,    // a target on a compute pass or on a buffer, a second target of a kind, or a raster pass without any
+    read_before_write, // a read of a resource nothing writes and nothing imports
+    cycle,             // passes that, through their resources, each have to run after the other
+};
+
+struct StaticBarrier
+{
+    GraphBarrier barrier{};
+    bool isTrackedLayout{false}; // leaves the image from the layout it was left in, which is only known when recording
+};
+
+// What the GPU has done to a resource so far in the frame.
+struct StaticResourceState
+{
+    image_layout layout{image_layout::undefined};
+    std::uint64_t writeStage{};
+    std::uint64_t writeAccess{};
+    std::uint64_t readStage{};    // stages that read it since the last write
+    std::uint64_t visibleStage{}; // stages the last write was made visible to
+};
+
+template <std::size_t PassCount, std::size_t ResourceCount, std::size_t BarrierCount>
+struct StaticPlan
+{
+    std::array<std::uint32_t, PassCount> order{};               // listed index of every pass that runs, in execution order
+    std::uint32_t passCount{};                                  // passes that run; the others were culled
+    std::array<StaticBarrier, BarrierCount> barriers{};
+    std::array<std::uint32_t, PassCount + 2U> barrierOffsets{}; // step i records [barrierOffsets[i], barrierOffsets[i + 1]); step passCount is the present transition
+    std::array<AttachmentOps, PassCount> attachmentOps{};       // per step
+    std::array<std::uint32_t, PassCount> colorTargets{};        // per listed pass, ~0U without one
+    std::array<std::uint32_t, PassCount> depthTargets{};
+    std::array<bool, PassCount> isDepthReadOnly{};              // per listed pass
+    std::array<bool, ResourceCount> isUsed{};                   // by a pass that runs
+    std::array<image_layout, ResourceCount> endLayouts{};       // where the frame leaves every image
+    std::uint32_t swapChain{~0U};                               // the swap chain resource, if a pass that runs uses it
+    std::uint64_t swapChainWaitStage{};                         // first stage that touches the acquired image
+    static_graph_error error{static_graph_error::none};
+};
+
+// Moves a resource on to its next use; true when that takes a barrier, which is then filled in.
+// Writes wait for everything before them, reads only for a write they cannot see yet or for a layout change.
+constexpr auto Transition(StaticResourceState& state, const ResourceUse& use, const bool isImage, GraphBarrier& barrier) noexcept -> bool
+{
+    const bool changesLayout{isImage && use.layout != state.layout};
+    barrier = {.resource  = use.resource,
+               .dstStage  = use.stage,
+               .dstAccess = use.access,
+               .oldLayout = state.layout,
+               .newLayout = isImage ? use.layout : image_layout::undefined};
+    if (use.isWrite)
+    {
+        barrier.srcStage  = state.writeStage | state.readStage;
+        barrier.srcAccess = state.writeAccess;
+        state             = {.layout = barrier.newLayout, .writeStage = use.stage, .writeAccess = use.access};
+        return barrier.srcStage != 0U || changesLayout;
+    }
+    if (changesLayout)
+    {
+        barrier.srcStage   = state.writeStage | state.readStage;
+        barrier.srcAccess  = state.writeAccess;
+        state.layout       = barrier.newLayout;
+        state.readStage    = use.stage;
+        state.visibleStage = use.stage;
+        return true;
+    }
+    state.readStage |= use.stage;
+    if (state.writeAccess != 0U && (use.stage & ~state.visibleStage) != 0U)
+    {
+        barrier.srcStage  = state.writeStage;
+        barrier.srcAccess = state.writeAccess;
+        state.visibleStage |= use.stage;
+        return true;
+    }
+    return false;
+}
+
+// Everything ExecuteStatic needs to know, worked out by the compiler. A graph that cannot run reports why in error instead.
+template <class Resources, class... Passes>
+[[nodiscard]] consteval auto PlanStaticGraph()
+{
+    constexpr std::size_t passCount{sizeof...(Passes)};
+    constexpr std::size_t resourceCount{Resources::list.size()};
+    constexpr std::size_t barrierCount{(std::size_t{} + ... + std::size(Passes::uses)) + 1U};
+    using Plan = StaticPlan<passCount, resourceCount, barrierCount>;
+
+    Plan plan{};
+    const std::array<std::span<const StaticUse>, passCount> uses{std::span<const StaticUse>{Passes::uses}...};
+    const std::array<bool, passCount> isCompute{static_cast<bool>(Passes::isCompute)...};
+    const std::array<StaticResource, resourceCount>& resources{Resources::list};
+    const auto fail = [&plan](const static_graph_error error) -> Plan
+    {
+        plan.error = error;
+        return plan;
+    };
+    const auto findUse = [&uses](const std::size_t pass, const std::uint32_t resource) -> const StaticUse*
+    {
+        for (const StaticUse& use : uses[pass])
+        {
+            if (use.use.resource == resource)
+            {
+                return &use;
+            }
+        }
+        return nullptr;
+    };
+
+    std::array<bool, resourceCount> isWritten{};
+    for (std::size_t p{}; p < passCount; ++p)
+    {
+        plan.colorTargets[p] = ~0U;
+        plan.depthTargets[p] = ~0U;
+        for (std::size_t u{}; u < uses[p].size(); ++u)
+        {
+            const StaticUse& use{uses[p][u]};
+            const std::uint32_t r{use.use.resource};
+            if (r >= resourceCount)
+            {
+                return fail(static_graph_error::unknown_resource);
+            }
+            if (findUse(p, r) != &use)
+            {
+                return fail(static_graph_error::duplicate_use);
+            }
+            const bool isImage{!resources[r].isBuffer};
+            if (isImage == (use.use.layout == image_layout::undefined))
+            {
+                return fail(static_graph_error::resource_kind);
+            }
+            if (use.attachment != static_attachment::none)
+            {
+                std::uint32_t& target{use.attachment == static_attachment::color ? plan.colorTargets[p] : plan.depthTargets[p]};
+                if (isCompute[p] || !isImage || target != ~0U || (resources[r].isSwapChain && use.attachment != static_attachment::color))
+                {
+                    return fail(static_graph_error::attachment_use);
+                }
+                target                  = r;
+                plan.isDepthReadOnly[p] = plan.isDepthReadOnly[p] || use.attachment == static_attachment::depth_read_only;
+            }
+            isWritten[r] = isWritten[r] || use.use.isWrite;
+        }
+        if (!isCompute[p] && plan.colorTargets[p] == ~0U && plan.depthTargets[p] == ~0U)
+        {
+            return fail(static_graph_error::attachment_use);
+        }
+    }
+
+    // A reader runs after every writer of what it reads; writers of one resource keep their listed order.
+    std::array<std::array<bool, passCount>, passCount> runsAfter{};
+    for (std::size_t b{}; b < passCount; ++b)
+    {
+        for (const StaticUse& use : uses[b])
+        {
+            const std::uint32_t r{use.use.resource};
+            if (!use.use.isWrite && !isWritten[r] && !resources[r].isImported)
+            {
+                return fail(static_graph_error::read_before_write);
+            }
+            for (std::size_t a{}; a < passCount; ++a)
+            {
+                const StaticUse* other{a != b ? findUse(a, r) : nullptr};
+                runsAfter[b][a] = runsAfter[b][a] || (other != nullptr && other->use.isWrite && (!use.use.isWrite || a < b));
+            }
+        }
+    }
+
+    // Topological order, taking the first listed pass that is ready at every step.
+    std::array<bool, passCount> isPlaced{};
+    std::array<std::uint32_t, passCount> sorted{};
+    for (std::size_t step{}; step < passCount; ++step)
+    {
+        std::size_t next{passCount};
+        for (std::size_t p{}; p < passCount && next == passCount; ++p)
+        {
+            bool isReady{!isPlaced[p]};
+            for (std::size_t a{}; a < passCount && isReady; ++a)
+            {
+                isReady = !runsAfter[p][a] || isPlaced[a];
+            }
+            next = isReady ? p : next;
+        }
+        if (next == passCount)
+        {
+            return fail(static_graph_error::cycle);
+        }
+        isPlaced[next] = true;
+        sorted[step]   = static_cast<std::uint32_t>(next);
+    }
+
+    // Walking back from the end, a pass runs when it writes something that is exported or read by a pass that runs.
+    std::array<bool, resourceCount> isLive{};
+    for (std::size_t r{}; r < resourceCount; ++r)
+    {
+        isLive[r] = resources[r].isExported || resources[r].isSwapChain;
+    }
+    std::array<bool, passCount> isKept{};
+    for (std::size_t step{passCount}; step-- > 0U;)
+    {
+        const std::uint32_t p{sorted[step]};
+        for (const StaticUse& use : uses[p])
+        {
+            isKept[p] = isKept[p] || (use.use.isWrite && isLive[use.use.resource]);
+        }
+        for (const StaticUse& use : uses[p])
+        {
+            isLive[use.use.resource] = isLive[use.use.resource] || isKept[p];
+        }
+    }
+    std::array<std::uint32_t, resourceCount> lastStep{};
+    for (const std::uint32_t p : sorted)
+    {
+        if (isKept[p])
+        {
+            for (const StaticUse& use : uses[p])
+            {
+                plan.isUsed[use.use.resource] = true;
+                lastStep[use.use.resource]    = plan.passCount;
+                if (resources[use.use.resource].isSwapChain)
+                {
+                    plan.swapChain = use.use.resource;
+                }
+            }
+            plan.order[plan.passCount++] = p;
+        }
+    }
+
+    // Runs the frame over a copy of how the previous one left every resource. The first run only finds that end state; the second records the barriers,
+    // so the first use of a resource in a frame also waits for its last use in the frame before.
+    std::array<StaticResourceState, resourceCount> carried{};
+    const auto runFrame = [&](const bool isRecording)
+    {
+        std::array<StaticResourceState, resourceCount> states{carried};
+        std::array<bool, resourceCount> isTouched{};
+        std::uint32_t barrier{};
+        for (std::uint32_t step{}; step < plan.passCount; ++step)
+        {
+            plan.barrierOffsets[step] = barrier;
+            AttachmentOps& ops{plan.attachmentOps[step]};
+            for (const StaticUse& use : uses[plan.order[step]])
+            {
+                const std::uint32_t r{use.use.resource};
+                const StaticResource& resource{resources[r]};
+                StaticResourceState& state{states[r]};
+                const bool isFirstUse{!isTouched[r]};
+                if (isFirstUse && resource.isSwapChain)
+                {
+                    // Chains onto the acquire semaphore, which is waited for at this stage.
+                    state                   = {.writeStage = use.use.stage};
+                    plan.swapChainWaitStage = use.use.stage;
+                }
+                else if (isFirstUse && resource.isImported)
+                {
+                    state = {.writeStage = StageBits(pipeline_stage::all_commands), .writeAccess = AccessBits(memory_access::memory_write)};
+                }
+                else if (isFirstUse)
+                {
+                    state.layout = image_layout::undefined; // nothing reads it before this frame writes it, so its contents can go
+                }
+                isTouched[r] = true;
+
+                StaticBarrier staticBarrier{.isTrackedLayout = isFirstUse && resource.isImported && !resource.isBuffer};
+                if (Transition(state, use.use, !resource.isBuffer, staticBarrier.barrier) || staticBarrier.isTrackedLayout)
+                {
+                    plan.barriers[barrier++] = staticBarrier;
+                }
+
+                const bool isKeptAfter{lastStep[r] != step || resource.isExported || resource.isSwapChain};
+                const attachment_load_op load{isFirstUse && !resource.isImported ? attachment_load_op::clear : attachment_load_op::load};
+                const attachment_store_op store{isKeptAfter ? attachment_store_op::store : attachment_store_op::dont_care};
+                if (use.attachment == static_attachment::color)
+                {
+                    ops.colorLoad  = load;
+                    ops.colorStore = store;
+                }
+                else if (use.attachment != static_attachment::none)
+                {
+                    ops.depthLoad  = load;
+                    ops.depthStore = store;
+                }
+            }
+        }
+
+        plan.barrierOffsets[plan.passCount] = barrier;
+        if (plan.swapChain != ~0U)
+        {
+            StaticResourceState& state{states[plan.swapChain]};
+            plan.barriers[barrier++] = {.barrier = {.resource  = plan.swapChain,
+                                                    .srcStage  = state.writeStage | state.readStage,
+                                                    .srcAccess = state.writeAccess,
+                                                    .dstStage  = StageBits(pipeline_stage::none),
+                                                    .dstAccess = AccessBits(memory_access::none),
+                                                    .oldLayout = state.layout,
+                                                    .newLayout = image_layout::present_src_khr}};
+            state.layout = image_layout::present_src_khr;
+        }
+        plan.barrierOffsets[plan.passCount + 1U] = barrier;
+
+        for (std::size_t r{}; r < resourceCount; ++r)
+        {
+            plan.endLayouts[r] = isTouched[r] && !resources[r].isBuffer ? states[r].layout : image_layout::undefined;
+        }
+        if (!isRecording)
+        {
+            carried = states;
+        }
+    };
+    runFrame(/*isRecording=*/false);
+    runFrame(/*isRecording=*/true);
+
+    return plan;
+}
+
+// The images and buffers a static graph runs on. The swap chain resource is never bound; it is whatever image was acquired this frame.
+export struct StaticBinding
+{
+    deer_vulkan::Image* image{nullptr};
+    const deer_vulkan::ImageView* view{nullptr};
+    deer_vulkan::Buffer* buffer{nullptr};
+};
+
+export template <class Resources, static_render_pass... Passes>
+struct StaticRenderGraph
+{
+    using PassTypes = std::tuple<Passes...>;
+    static constexpr std::array resources{Resources::list};
+    static constexpr auto plan{PlanStaticGraph<Resources, Passes...>()};
+
+    static_assert(std::ranges::count(resources, true, &StaticResource::isSwapChain) <= 1, "a static graph has at most one swap chain resource");
+    static_assert(plan.error != static_graph_error::unknown_resource, "a pass uses a resource the graph does not list");
+    static_assert(plan.error != static_graph_error::duplicate_use, "a pass names the same resource more than once");
+    static_assert(plan.error != static_graph_error::resource_kind, "a texture use names a buffer resource, or a buffer use a texture");
+    static_assert(plan.error != static_graph_error::attachment_use,
+                  "render targets need a raster pass, an image and at most one of each kind (the swap chain only as color); a raster pass needs at least one");
+    static_assert(plan.error != static_graph_error::read_before_write, "a pass reads a resource that no pass writes and that is not imported");
+    static_assert(plan.error != static_graph_error::cycle, "the passes depend on each other in a cycle");
+
+    PassTypes passes{};
+    std::array<StaticBinding, resources.size()> bindings{};
+};
+
+export template <std::uint32_t Resource, class Resources, class... Passes>
+auto BindTexture(StaticRenderGraph<Resources, Passes...>& staticGraph, Texture& texture) noexcept -> void
+{
+    using Graph = StaticRenderGraph<Resources, Passes...>;
+    static_assert(Resource < Graph::resources.size(), "the graph does not list this resource");
+    static_assert(!Graph::resources[Resource].isBuffer && !Graph::resources[Resource].isSwapChain, "only texture resources take a texture");
+    staticGraph.bindings[Resource] = {.image = &texture.image, .view = &texture.view};
+}
+
+export template <std::uint32_t Resource, class Resources, class... Passes>
+auto BindBuffer(StaticRenderGraph<Resources, Passes...>& staticGraph, Buffer& buffer) noexcept -> void
+{
+    using Graph = StaticRenderGraph<Resources, Passes...>;
+    static_assert(Resource < Graph::resources.size(), "the graph does not list this resource");
+    static_assert(Graph::resources[Resource].isBuffer, "only buffer resources take a buffer");
+    staticGraph.bindings[Resource] = {.buffer = &buffer.buffer};
+}
+
+template <class Pass>
+[[nodiscard]] consteval auto StaticClearColor() noexcept -> std::array<float, 4>
+{
+    if constexpr (requires { Pass::clearColor; })
+    {
+        return Pass::clearColor;
+    }
+    return {0.0F, 0.0F, 0.0F, 1.0F};
+}
+
+template <class Pass>
+[[nodiscard]] consteval auto StaticClearDepth() noexcept -> float
+{
+    if constexpr (requires { Pass::clearDepth; })
+    {
+        return Pass::clearDepth;
+    }
+    return 0.0F;
+}
+
+template <class Graph, std::uint32_t Resource>
+[[nodiscard]] inline auto StaticImageView(const Graph& staticGraph, const RenderPassContext& context) noexcept -> const deer_vulkan::ImageView*
+{
+    if constexpr (Resource == ~0U)
+    {
+        return nullptr;
+    }
+    else if constexpr (Graph::resources[Resource].isSwapChain)
+    {
+        return &CurrentImageView(context.swapChain);
+    }
+    else
+    {
+        return staticGraph.bindings[Resource].view;
+    }
+}
+
+// Records the barriers of one step with a single call; the ranges are known, so nothing here allocates.
+template <class Graph, std::uint32_t Step>
+inline auto RecordStaticBarriers(Renderer& renderer, Graph& staticGraph, const deer_vulkan::CommandBuffer& commandBuffer) noexcept -> void
+{
+    constexpr std::uint32_t first{Graph::plan.barrierOffsets[Step]};
+    constexpr std::uint32_t count{Graph::plan.barrierOffsets[Step + 1U] - first};
+    if constexpr (count != 0U)
+    {
+        std::array<deer_vulkan::ImageBarrier, count> imageBarriers{};
+        std::array<deer_vulkan::BufferBarrier, count> bufferBarriers{};
+        std::size_t imageCount{};
+        std::size_t bufferCount{};
+        for (std::uint32_t i{first}; i < first + count; ++i)
+        {
+            const auto& [barrier, isTrackedLayout]{Graph::plan.barriers[i]};
+            const StaticBinding& binding{staticGraph.bindings[barrier.resource]};
+            if (binding.buffer != nullptr)
+            {
+                bufferBarriers[bufferCount++] = {.buffer    = binding.buffer,
+                                                 .srcStage  = barrier.srcStage,
+                                                 .srcAccess = barrier.srcAccess,
+                                                 .dstStage  = barrier.dstStage,
+                                                 .dstAccess = barrier.dstAccess};
+                continue;
+            }
+            deer_vulkan::Image* image{barrier.resource == Graph::plan.swapChain ? &CurrentImage(renderer.swapChain) : binding.image};
+            if (isTrackedLayout && !image->subresourceLayouts.empty()) [[unlikely]]
+            {
+                // left with mips or layers in different layouts; bring those that differ over on their own first
+                deer_vulkan::TransitionImageLayout(renderer.dispatch, commandBuffer, *image, static_cast<std::uint32_t>(barrier.newLayout), 0U, ~0U, 0U, ~0U);
+            }
+            imageBarriers[imageCount++] = {.image     = image,
+                                           .srcStage  = barrier.srcStage,
+                                           .srcAccess = barrier.srcAccess,
+                                           .dstStage  = barrier.dstStage,
+                                           .dstAccess = barrier.dstAccess,
+                                           .oldLayout = isTrackedLayout ? static_cast<std::uint32_t>(image->layout) : static_cast<std::uint32_t>(barrier.oldLayout),
+                                           .newLayout = static_cast<std::uint32_t>(barrier.newLayout)};
+        }
+        deer_vulkan::PipelineBarrier(renderer.dispatch, commandBuffer, std::span{imageBarriers.data(), imageCount}, std::span{bufferBarriers.data(), bufferCount},
+                                     /*trackLayouts=*/false);
+    }
+}
+
+template <class Graph, std::uint32_t Step>
+inline auto RecordStaticStep(Renderer& renderer, Graph& staticGraph, const RenderPassContext& context) noexcept -> void
+{
+    constexpr std::uint32_t pass{Graph::plan.order[Step]};
+    using Pass = std::tuple_element_t<pass, typename Graph::PassTypes>;
+
+    RecordStaticBarriers<Graph, Step>(renderer, staticGraph, context.commandBuffer);
+    if constexpr (Pass::isCompute)
+    {
+        std::get<pass>(staticGraph.passes).Execute(context);
+    }
+    else
+    {
+        constexpr std::uint32_t depth{Graph::plan.depthTargets[pass]};
+        constexpr AttachmentOps ops{Graph::plan.attachmentOps[Step]};
+        deer_vulkan::BeginRender(context.dispatch, context.commandBuffer,
+                                 deer_vulkan::RenderParams{.colorImageView = StaticImageView<Graph, Graph::plan.colorTargets[pass]>(staticGraph, context),
+                                                           .depthImageView = StaticImageView<Graph, depth>(staticGraph, context),
+                                                           .clearColor     = StaticClearColor<Pass>(),
+                                                           .depthClear     = StaticClearDepth<Pass>(),
+                                                           .xOffset        = 0,
+                                                           .yOffset        = 0,
+                                                           .width          = context.width,
+                                                           .height         = context.height,
+                                                           .stencilClear   = 0U,
+                                                           .colorLoadOp    = static_cast<std::uint32_t>(ops.colorLoad),
+                                                           .colorStoreOp   = static_cast<std::uint32_t>(ops.colorStore),
+                                                           .depthLoadOp    = static_cast<std::uint32_t>(ops.depthLoad),
+                                                           .depthStoreOp   = static_cast<std::uint32_t>(ops.depthStore),
+                                                           .depthReadOnly  = Graph::plan.isDepthReadOnly[pass]});
+        std::get<pass>(staticGraph.passes).Execute(context);
+        deer_vulkan::EndRender(context.dispatch, context.commandBuffer);
+    }
+}
+
+template <class Graph, std::uint32_t... Steps>
+inline auto RecordStaticSteps(Renderer& renderer, Graph& staticGraph, const RenderPassContext& context, std::integer_sequence<std::uint32_t, Steps...>) noexcept -> void
+{
+    (RecordStaticStep<Graph, Steps>(renderer, staticGraph, context), ...);
+}
+
+// Records and submits one frame of a static graph: one command buffer, one submit on the graphics queue, no planning.
+// Culled passes are never called; only the resources of the passes that run have to be bound.
+export template <class Resources, class... Passes>
+[[nodiscard]] auto ExecuteStatic(Renderer& renderer, StaticRenderGraph<Resources, Passes...>& staticGraph) noexcept -> gfx_status
+{
+    using Graph = StaticRenderGraph<Resources, Passes...>;
+    constexpr auto& plan{Graph::plan};
+    BALBINO_PROFILE_ZONE("ExecuteStatic");
+
+    for (std::uint32_t r{}; r < Graph::resources.size(); ++r)
+    {
+        const StaticBinding& binding{staticGraph.bindings[r]};
+        if (plan.isUsed[r] && r != plan.swapChain && binding.image == nullptr && binding.buffer == nullptr) [[unlikely]]
+        {
+            std::println(std::cerr, "[GFX] static graph resource {} is used but not bound", r);
+            return gfx_status::not_ok;
+        }
+    }
+
+    if (const gfx_status status{BeginFrame(renderer)}; status != gfx_status::ok) [[unlikely]]
+    {
+        return status;
+    }
+    if constexpr (plan.swapChain != ~0U)
+    {
+        if (const gfx_status status{AcquireImage(renderer)}; status != gfx_status::ok)
+        {
+            return status;
+        }
+    }
+
+    const deer_vulkan::CommandBuffer* commandBuffer{nullptr};
+    if (const gfx_status status{NextCommandBuffer(renderer, g_graphicsQueueId, 0U, commandBuffer)}; status != gfx_status::ok) [[unlikely]]
+    {
+        return status;
+    }
+    const RenderPassContext context{
+        .dispatch          = renderer.dispatch,
+        .device            = renderer.device,
+        .commandBuffer     = *commandBuffer,
+        .swapChain         = renderer.swapChain,
+        .timelineSemaphore = renderer.timelineSemaphore,
+        .uploadRing        = renderer.uploadRing,
+        .width             = renderer.swapChain.extent.width,
+        .height            = renderer.swapChain.extent.height,
+    };
+
+    deer_vulkan::BeginSingleCommand(renderer.dispatch, *commandBuffer);
+    RecordStaticSteps(renderer, staticGraph, context, std::make_integer_sequence<std::uint32_t, plan.passCount>{});
+    RecordStaticBarriers<Graph, plan.passCount>(renderer, staticGraph, *commandBuffer);
+    deer_vulkan::EndCommand(renderer.dispatch, *commandBuffer);
+
+    for (std::uint32_t r{}; r < Graph::resources.size(); ++r)
+    {
+        if (deer_vulkan::Image* image{staticGraph.bindings[r].image}; image != nullptr && plan.endLayouts[r] != image_layout::undefined)
+        {
+            deer_vulkan::SetLayout(*image, static_cast<std::uint32_t>(plan.endLayouts[r]));
+        }
+    }
+    if constexpr (plan.swapChain != ~0U)
+    {
+        deer_vulkan::SetLayout(CurrentImage(renderer.swapChain), static_cast<std::uint32_t>(image_layout::present_src_khr));
+    }
+
+    std::array<deer_vulkan::SemaphoreSubmit, 2> waits{};
+    std::array<deer_vulkan::SemaphoreSubmit, 2> signals{};
+    std::size_t waitCount{};
+    std::size_t signalCount{};
+    if (renderer.imageAcquired)
+    {
+        waits[waitCount++]     = {.semaphore = &renderer.frames[renderer.acquireSlot].acquireSemaphore, .value = 0U, .stageMask = plan.swapChainWaitStage};
+        signals[signalCount++] = {.semaphore = &renderer.presentSemaphores[renderer.swapChain.currentFrameIdx],
+                                  .value     = 0U,
+                                  .stageMask = StageBits(pipeline_stage::all_commands)};
+    }
+    waitCount += TakeUploadWait(renderer, waits[waitCount]) ? 1U : 0U;
+    signals[signalCount++] = {.semaphore = &renderer.timelineSemaphore, .value = renderer.timelineSemaphore.value + 1U, .stageMask = StageBits(pipeline_stage::all_commands)};
+    GFX_CHECK(SubmitFrameCommands(renderer, g_graphicsQueueId, std::span{&commandBuffer, 1U}, std::span{waits.data(), waitCount}, std::span{signals.data(), signalCount}),
+              "submitting the static graph ({} passes)", plan.passCount);
+    ++renderer.timelineSemaphore.value;
+
+    return EndFrame(renderer);
+}
+} // namespace fawn_vision
@@ -0,0 +1,241 @@
+//
+// Copyright (c) 2026.
+// Author: Joran.
+//
+
+module;
+#include "api/vulkan/wrapper/command.hpp"
+#include "api/vulkan/wrapper/queue.hpp"
+#include "api/vulkan/wrapper/semaphore.hpp"
+#include "deer_vulkan_core.hpp"
+
+export module FawnVision:SubmitThread;
+
+import std;
+
+namespace fawn_vision
+{
+export constexpr std::uint32_t g_maxQueuedWaits{5U};
+export constexpr std::uint32_t g_maxQueuedSignals{3U};
+export constexpr std::uint32_t g_submitQueueSize{4U}; // frames the submit thread can fall behind before queueing one waits
+
+// One queue submit of a queued frame; its command buffers are a range of the frame's.
+export struct QueuedSubmit
+{
+    std::array<deer_vulkan::SemaphoreSubmit, g_maxQueuedWaits> waits{};
+    std::array<deer_vulkan::SemaphoreSubmit, g_maxQueuedSignals> signals{};
+    std::uint32_t firstCommandBuffer{};
+    std::uint32_t commandBufferCount{};
+    std::uint8_t waitCount{};
+    std::uint8_t signalCount{};
+    std::uint8_t queueId{};
+};
+
+// Everything the submit thread does for one frame, in this order: the submits, the present, then acquiring an image for a later frame.
+// The vectors keep their capacity, so queueing a frame allocates nothing once every ring entry has been used.
+export struct QueuedFrame
+{
+    std::vector<const deer_vulkan::CommandBuffer*> commandBuffers{};
+    std::vector<QueuedSubmit> submits{};
+    const deer_vulkan::Semaphore* pPresentWait{nullptr}; // presents imageIndex when set
+    std::uint32_t imageIndex{};
+    std::uint32_t acquireSlot{~0U};    // frame slot whose acquire semaphore the next image is acquired with; ~0U acquires nothing
+    std::uint64_t acquireAfterValue{}; // graphics timeline value that has to be reached before that semaphore may be signalled again
+};
+
+// The result of the last acquire the submit thread made.
+export struct AcquiredImage
+{
+    deer_vulkan::vk_status status{deer_vulkan::vk_status::ok};
+    std::uint32_t imageIndex{};
+    std::uint32_t slot{};
+};
+
+// A thread that owns submit, present and acquire, fed through a ring of frames by a single producer without locking.
+// head and tail only ever grow: the thread reads the entries in [tail, head), the producer fills the one at head.
+export struct SubmitThread
+{
+    using process_function = void (*)(void* pContext, QueuedFrame& frame) noexcept;
+
+    std::array<QueuedFrame, g_submitQueueSize> frames{};
+    std::atomic<std::uint64_t> head{};                                      // frames queued; written by the producer only
+    std::atomic<std::uint64_t> tail{};                                      // frames processed; written by the thread only
+    std::atomic<std::uint64_t> acquireCount{};                              // acquires made, bumped after acquired is written
+    std::atomic<deer_vulkan::vk_status> status{deer_vulkan::vk_status::ok}; // first error, or out_of_date/suboptimal, seen by the thread
+    AcquiredImage acquired{};
+    std::uint64_t acquireRequests{};  // acquires the producer asked for; producer only
+    std::uint64_t acquiresTaken{};    // of those, the ones it took; producer only
+    QueuedFrame* pOpenFrame{nullptr}; // frame the producer is filling; producer only
+    process_function pProcess{nullptr};
+    void* pContext{nullptr};
+    std::jthread thread{};
+    std::atomic<bool> isStopping{false};
+};
+
+export [[nodiscard]] inline auto IsRunning(const SubmitThread& submitThread) noexcept -> bool
+{
+    return submitThread.thread.joinable();
+}
+
+inline auto SubmitLoop(SubmitThread& submitThread) noexcept -> void
+{
+    std::uint64_t tail{submitThread.tail.load(std::memory_order_relaxed)};
+    while (true)
+    {
+        submitThread.head.wait(tail, std::memory_order_acquire);
+        if (submitThread.isStopping.load(std::memory_order_acquire))
+        {
+            return;
+        }
+        for (const std::uint64_t head{submitThread.head.load(std::memory_order_acquire)}; tail < head; ++tail)
+        {
+            submitThread.pProcess(submitThread.pContext, submitThread.frames[tail % g_submitQueueSize]);
+            submitThread.tail.store(tail + 1U, std::memory_order_release);
+            submitThread.tail.notify_all();
+        }
+    }
+}
+
+export inline auto Initialize(SubmitThread& submitThread, const SubmitThread::process_function pProcess, void* pContext) noexcept -> void
+{
+    submitThread.pProcess = pProcess;
+    submitThread.pContext = pContext;
+    submitThread.status.store(deer_vulkan::vk_status::ok, std::memory_order_relaxed);
+    submitThread.isStopping.store(false, std::memory_order_relaxed);
+    submitThread.thread = std::jthread{[&submitThread]
+                                       {
+                                           SubmitLoop(submitThread);
+                                       }};
+}
+
+// Returns once the thread processed everything queued so far.
+export inline auto Flush(const SubmitThread& submitThread) noexcept -> void
+{
+    const std::uint64_t head{submitThread.head.load(std::memory_order_relaxed)};
+    for (std::uint64_t tail{submitThread.tail.load(std::memory_order_acquire)}; tail != head; tail = submitThread.tail.load(std::memory_order_acquire))
+    {
+        submitThread.tail.wait(tail, std::memory_order_acquire);
+    }
+}
+
+// Stops the thread once it processed everything queued. A frame that was opened but not queued is dropped.
+export inline auto Cleanup(SubmitThread& submitThread) noexcept -> void
+{
+    if (!IsRunning(submitThread))
+    {
+        return;
+    }
+    Flush(submitThread);
+    submitThread.isStopping.store(true, std::memory_order_release);
+    submitThread.head.fetch_add(1U, std::memory_order_release); // only wakes the thread; it stops before looking at the entry
+    submitThread.head.notify_one();
+    submitThread.thread = {};
+    submitThread.head.store(submitThread.tail.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    submitThread.pOpenFrame = nullptr;
+}
+
+// The frame being filled, claiming the next ring entry first if there is none. Waits while the thread is a whole ring behind.
+export [[nodiscard]] inline auto OpenFrame(SubmitThread& submitThread) noexcept -> QueuedFrame&
+{
+    if (submitThread.pOpenFrame == nullptr)
+    {
+        const std::uint64_t head{submitThread.head.load(std::memory_order_relaxed)};
+        for (std::uint64_t tail{submitThread.tail.load(std::memory_order_acquire)}; head - tail == g_submitQueueSize;
+             tail = submitThread.tail.load(std::memory_order_acquire))
+        {
+            submitThread.tail.wait(tail, std::memory_order_acquire);
+        }
+        QueuedFrame& frame{submitThread.frames[head % g_submitQueueSize]};
+        frame.commandBuffers.clear();
+        frame.submits.clear();
+        frame.pPresentWait      = nullptr;
+        frame.acquireSlot       = ~0U;
+        frame.acquireAfterValue = 0U;
+        submitThread.pOpenFrame = &frame;
+    }
+    return *submitThread.pOpenFrame;
+}
+
+// Hands the open frame to the thread and returns straight away.
+export inline auto QueueFrame(SubmitThread& submitThread) noexcept -> void
+{
+    if (submitThread.pOpenFrame == nullptr)
+    {
+        return;
+    }
+    if (submitThread.pOpenFrame->acquireSlot != ~0U)
+    {
+        ++submitThread.acquireRequests;
+    }
+    submitThread.pOpenFrame = nullptr;
+    submitThread.head.fetch_add(1U, std::memory_order_release);
+    submitThread.head.notify_one();
+}
+
+// Adds a submit to the open frame, copying the waits, signals and command buffer pointers.
+export [[nodiscard]] inline auto AddSubmit(SubmitThread& submitThread, const std::uint8_t queueId, const std::span<const deer_vulkan::CommandBuffer* const> commandBuffers,
+                                           const std::span<const deer_vulkan::SemaphoreSubmit> waits, const std::span<const deer_vulkan::SemaphoreSubmit> signals) noexcept
+    -> deer_vulkan::vk_status
+{
+    if (waits.size() > g_maxQueuedWaits || signals.size() > g_maxQueuedSignals) [[unlikely]]
+    {
+        return deer_vulkan::vk_status::too_many_objects;
+    }
+    QueuedFrame& frame{OpenFrame(submitThread)};
+    QueuedSubmit& submit{frame.submits.emplace_back(QueuedSubmit{.firstCommandBuffer = static_cast<std::uint32_t>(frame.commandBuffers.size()),
+                                                                 .commandBufferCount = static_cast<std::uint32_t>(commandBuffers.size()),
+                                                                 .waitCount          = static_cast<std::uint8_t>(waits.size()),
+                                                                 .signalCount        = static_cast<std::uint8_t>(signals.size()),
+                                                                 .queueId            = queueId})};
+    std::ranges::copy(waits, submit.waits.begin());
+    std::ranges::copy(signals, submit.signals.begin());
+    frame.commandBuffers.insert(frame.commandBuffers.end(), commandBuffers.begin(), commandBuffers.end());
+    return deer_vulkan::vk_status::ok;
+}
+
+// Whether a queued frame asks for an image that has not been taken yet. There is never more than one.
+export [[nodiscard]] inline auto HasQueuedAcquire(const SubmitThread& submitThread) noexcept -> bool
+{
+    return submitThread.acquireRequests != submitThread.acquiresTaken;
+}
+
+// Waits for the queued acquire to be made and takes its result.
+export [[nodiscard]] inline auto TakeAcquire(SubmitThread& submitThread) noexcept -> AcquiredImage
+{
+    for (std::uint64_t count{submitThread.acquireCount.load(std::memory_order_acquire)}; count < submitThread.acquireRequests;
+         count = submitThread.acquireCount.load(std::memory_order_acquire))
+    {
+        submitThread.acquireCount.wait(count, std::memory_order_acquire);
+    }
+    submitThread.acquiresTaken = submitThread.acquireRequests;
+    return submitThread.acquired;
+}
+
+// For the thread: publishes an acquire and wakes a producer waiting for it.
+inline auto PublishAcquire(SubmitThread& submitThread, const AcquiredImage& acquired) noexcept -> void
+{
+    submitThread.acquired = acquired;
+    submitThread.acquireCount.fetch_add(1U, std::memory_order_release);
+    submitThread.acquireCount.notify_all();
+}
+
+// For the thread: keeps the first error until the producer takes it. A positive status such as suboptimal is kept as well, but gives way to an error
+// that comes after it, so it never hides a lost device.
+inline auto ReportStatus(SubmitThread& submitThread, const deer_vulkan::vk_status status) noexcept -> void
+{
+    deer_vulkan::vk_status current{submitThread.status.load(std::memory_order_relaxed)};
+    while (status != deer_vulkan::vk_status::ok && !deer_vulkan::IsError(current) && (current == deer_vulkan::vk_status::ok || deer_vulkan::IsError(status)))
+    {
+        if (submitThread.status.compare_exchange_weak(current, status, std::memory_order_release, std::memory_order_relaxed))
+        {
+            return;
+        }
+    }
+}
+
+// For the producer: what went wrong on the thread since it last asked, if anything.
+export [[nodiscard]] inline auto TakeStatus(SubmitThread& submitThread) noexcept -> deer_vulkan::vk_status
+{
+    return submitThread.status.exchange(deer_vulkan::vk_status::ok, std::memory_order_acquire);
+}
+} // namespace fawn_vision
@@ -8,6 +8,7 @@ module;
 #include "api/vulkan/wrapper/image.hpp"
 #include "api/vulkan/wrapper/image_view.hpp"
 #include "api/vulkan/wrapper/sampler.hpp"
+#include "headers/profiler.hpp"
 
 export module FawnVision:Texture;
 import :Buffer;
@@ -33,15 +34,6 @@ import std;
         std::println(std::cerr, "[GFX] {}:{} — {} | Hint: {} | Context: {}", __FILE__, __LINE__, _e.message, _e.hint, std::format(__VA_ARGS__));                                   \
     }
 
-#define GFX_CHECK_CLEANUP(expr, ...)                                                                                                                                               \
-    if (deer_vulkan::vk_status _s = expr; deer_vulkan::IsError(_s)) [[unlikely]]                                                                                                   \
-    {                                                                                                                                                                              \
-        auto _e = deer_vulkan::GetError(_s);                                                                                                                                       \
-        std::println(std::cerr, "[GFX] {}:{} — {} | Hint: {} | Context: {}", __FILE__, __LINE__, _e.message, _e.hint, std::format(__VA_ARGS__));                                   \
-        Cleanup(renderer, stagingBuffer);                                                                                                                                          \
-        return ToGfxStatus(_s);                                                                                                                                                    \
-    }
-
 namespace fawn_vision
 {
 export enum class component_swizzle : std::uint8_t {
@@ -413,6 +405,7 @@ export struct ImageTextureCreateInfo
     image_tiling tiling{};
     image_usage usage{};
     memory_property memoryProperty{};
+    memory_usage memoryUsage{memory_usage::gpu_only};
     component_swizzle rSwizzle{};
     component_swizzle gSwizzle{};
     component_swizzle bSwizzle{};
@@ -437,6 +430,8 @@ export struct Texture
     deer_vulkan::Image image{};
     deer_vulkan::ImageView view{};
     deer_vulkan::Sampler sampler{};
+    UploadTicket upload{}; // pixel data of an image texture; see IsUploaded
+    image_layout layout{image_layout::shader_read_only_optimal}; // layout descriptors sample it in
 };
 
 // Maps image_view_type → VkImageType (image_type) for ImageCreateInfo.
@@ -452,8 +447,11 @@ export struct Texture
     }
 }
 
+// The pixel data is copied out before this returns; the image fills in on the transfer queue. Frames may sample it once IsUploaded(renderer, texture.upload),
+// and the texture has to stay where it is until then.
 export [[nodiscard]] inline auto Initialize(const Renderer& renderer, const ImageTextureCreateInfo& createInfo, Texture& texture) noexcept -> gfx_status
 {
+    BALBINO_PROFILE_ZONE("Initialize Texture");
     if (createInfo.pixelData.empty()) [[unlikely]]
     {
         return gfx_status::not_ok;
@@ -462,16 +460,13 @@ export [[nodiscard]] inline auto Initialize(const Renderer& renderer, const Imag
     const std::uint32_t idealMip = (createInfo.mipCount == 0U)
         ? static_cast<std::uint32_t>(std::floor(std::log2(static_cast<float>(std::max({createInfo.width, createInfo.height, createInfo.depth}))))) + 1U
         : createInfo.mipCount;
-
-    // Upload via staging buffer
-    Buffer stagingBuffer;
-    if (Initialize(renderer, createInfo.pixelData.size_bytes(), buffer_usage::transfer_src, memory_property::host_visible | memory_property::host_coherent, stagingBuffer) != gfx_status::ok) [[unlikely]]
+    const bool generateMips{createInfo.mipCount != idealMip};
+    image_usage usage{createInfo.usage | image_usage::transfer_dst};
+    if (generateMips)
     {
-        return gfx_status::not_ok;
+        usage = usage | image_usage::transfer_src;
     }
 
-    CopyData(renderer, stagingBuffer, createInfo.pixelData);
-
     const deer_vulkan::ImageCreateInfo imageInfo{
         .format         = static_cast<std::uint32_t>(createInfo.imageFormat),
         .width          = createInfo.width,
@@ -480,27 +475,21 @@ export [[nodiscard]] inline auto Initialize(const Renderer& renderer, const Imag
         .mipCount       = idealMip,
         .arrayCount     = createInfo.arrayCount,
         .sampleCount    = createInfo.sampleCount,
-        .usage          = static_cast<std::uint32_t>(createInfo.usage),
+        .usage          = static_cast<std::uint32_t>(usage),
         .memoryProperty = static_cast<std::uint32_t>(createInfo.memoryProperty),
+        .memoryUsage    = static_cast<deer_vulkan::memory_usage>(createInfo.memoryUsage),
         .imageType      = ViewTypeToImageType(createInfo.imageType),
         .tiling         = static_cast<std::uint8_t>(createInfo.tiling),
     };
 
-    GFX_CHECK_CLEANUP(deer_vulkan::Initialize(renderer.dispatch, renderer.device, renderer.physical, imageInfo, texture.image), "Failed to Initialize image.")
-    deer_vulkan::TransitionImageLayout(renderer.dispatch, renderer.commandBuffer, texture.image, static_cast<std::uint32_t>(image_layout::transfer_dst_optimal),
-                                       createInfo.mipOffset, idealMip, createInfo.layerOffset, createInfo.layerCount);
-    deer_vulkan::CopyToImage(renderer.dispatch, renderer.commandBuffer, stagingBuffer.buffer, texture.image, createInfo.width, createInfo.height, createInfo.depth);
-
-    Cleanup(renderer, stagingBuffer);
-
-    if (createInfo.mipCount == idealMip)
+    GFX_CHECK(deer_vulkan::Initialize(renderer.dispatch, renderer.device, renderer.allocator, imageInfo, texture.image), "Failed to Initialize image.")
+    texture.layout = createInfo.layout;
+    if (const gfx_status status{StageImage(renderer, std::as_bytes(createInfo.pixelData), texture.image, createInfo.width, createInfo.height, createInfo.depth,
+                                           createInfo.layout, generateMips, texture.upload)};
+        status != gfx_status::ok) [[unlikely]]
     {
-        deer_vulkan::TransitionImageLayout(renderer.dispatch, renderer.commandBuffer, texture.image, static_cast<std::uint32_t>(createInfo.layout), createInfo.mipOffset, idealMip,
-                                           createInfo.layerOffset, createInfo.layerCount);
-    }
-    else
-    {
-        GFX_CHECK(deer_vulkan::GenerateMips(renderer.dispatch, renderer.commandBuffer, texture.image, createInfo.width, createInfo.height, idealMip), "Failed to generate mips.")
+        Cleanup(renderer.dispatch, renderer.device, renderer.allocator, texture.image);
+        return status;
     }
 
     const deer_vulkan::ImageViewCreateInfo viewInfo{
@@ -533,13 +522,15 @@ export [[nodiscard]] inline auto Initialize(const Renderer& renderer, const Imag
     return gfx_status::ok;
 }
 
-export [[nodiscard]] inline auto Initialize(const Renderer& renderer, const RenderTextureCreateInfo& createInfo, Texture& texture) noexcept -> gfx_status
+// An attachment-only target is never sampled, so it can live in lazily allocated memory where the device has it.
+[[nodiscard]] constexpr auto RenderTargetImageInfo(const RenderTextureCreateInfo& createInfo, const bool isAttachmentOnly = false) noexcept -> deer_vulkan::ImageCreateInfo
 {
     const bool isDepth = ((createInfo.aspect & image_aspect::depth) | (createInfo.aspect & image_aspect::stencil)) != 0;
 
-    const image_usage usage = isDepth ? (image_usage::depth_stencil_attachment | image_usage::sampled) : (image_usage::color_attachment | image_usage::sampled);
+    const image_usage attachment = isDepth ? image_usage::depth_stencil_attachment : image_usage::color_attachment;
+    const image_usage usage      = attachment | (isAttachmentOnly ? image_usage::transient_attachment : image_usage::sampled);
 
-    const deer_vulkan::ImageCreateInfo imageInfo{
+    return {
         .format         = static_cast<std::uint32_t>(createInfo.imageFormat),
         .width          = createInfo.width,
         .height         = createInfo.height,
@@ -548,13 +539,15 @@ export [[nodiscard]] inline auto Initialize(const Renderer& renderer, const Rend
         .arrayCount     = 1U,
         .sampleCount    = 1U,
         .usage          = static_cast<std::uint32_t>(usage),
-        .memoryProperty = static_cast<std::uint32_t>(memory_property::device_local),
+        .memoryUsage    = isAttachmentOnly ? deer_vulkan::memory_usage::transient : deer_vulkan::memory_usage::gpu_only,
         .imageType      = static_cast<std::uint8_t>(image_type::type_2d),
         .tiling         = static_cast<std::uint8_t>(image_tiling::optimal),
     };
+}
 
-    GFX_CHECK(deer_vulkan::Initialize(renderer.dispatch, renderer.device, renderer.physical, imageInfo, texture.image), "Failed to Initialize render target image.")
-
+// View and sampler of a render target whose image already has memory bound.
+[[nodiscard]] inline auto InitializeRenderTargetViews(const Renderer& renderer, const RenderTextureCreateInfo& createInfo, Texture& texture) noexcept -> gfx_status
+{
     const deer_vulkan::ImageViewCreateInfo viewInfo{
         .format      = static_cast<std::uint32_t>(createInfo.imageFormat),
         .aspectFlag  = static_cast<std::uint32_t>(createInfo.aspect),
@@ -586,10 +579,20 @@ export [[nodiscard]] inline auto Initialize(const Renderer& renderer, const Rend
     return gfx_status::ok;
 }
 
+// Owns its memory for the lifetime of the texture. Targets that only live within a frame should be render graph transients instead.
+export [[nodiscard]] inline auto Initialize(const Renderer& renderer, const RenderTextureCreateInfo& createInfo, Texture& texture) noexcept -> gfx_status
+{
+    BALBINO_PROFILE_ZONE("Initialize Render Target");
+    GFX_CHECK(deer_vulkan::Initialize(renderer.dispatch, renderer.device, renderer.allocator, RenderTargetImageInfo(createInfo), texture.image),
+              "Failed to Initialize render target image.")
+
+    return InitializeRenderTargetViews(renderer, createInfo, texture);
+}
+
 export inline auto Cleanup(const Renderer& renderer, Texture& texture) noexcept -> void
 {
     Cleanup(renderer.dispatch, renderer.device, texture.sampler);
     Cleanup(renderer.dispatch, renderer.device, texture.view);
-    Cleanup(renderer.dispatch, renderer.device, texture.image);
+    Cleanup(renderer.dispatch, renderer.device, renderer.allocator, texture.image);
 }
 } // namespace fawn_vision
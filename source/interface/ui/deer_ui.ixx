@@ -4,6 +4,7 @@
 //
 
 module;
+#include "headers/profiler.hpp"
 #include "shaders.hpp"
 
 export module DeerUI;
@@ -335,7 +336,6 @@ inline constexpr std::array quadVertices{
     Vertex{{1.0F, 0.0F}, {1.0F, 0.0F}},
 };
 inline constexpr std::array quadIndices{0U, 1U, 2U, 2U, 3U, 0U};
-inline constexpr std::uint32_t maxInstancesPerBatch{64U};
 
 // ---------------------------------------------------------------------------
 // Render graph pass data
@@ -345,7 +345,6 @@ struct PassData
 {
     fawn_vision::Shader shader{};
     fawn_vision::Mesh mesh{};
-    fawn_vision::Buffer instanceBuffer{};
 };
 
 // ---------------------------------------------------------------------------
@@ -477,6 +476,7 @@ void RebuildCanvasInstances(Canvas& canvas, std::vector<UIInstanceData>& out, co
 
 void Render(UIRenderer& ui, const PassData* pass, const fawn_vision::RenderPassContext& ctx)
 {
+    BALBINO_PROFILE_ZONE("UI Render");
     const float sw{static_cast<float>(ctx.swapChain.extent.width)};
     const float sh{static_cast<float>(ctx.swapChain.extent.height)};
     const float sx{2.0F / sw};
@@ -555,17 +555,14 @@ void Render(UIRenderer& ui, const PassData* pass, const fawn_vision::RenderPassC
             continue;
         }
 
-        const std::size_t total{instances.size()};
-        for (std::size_t i{}; i < total; i += maxInstancesPerBatch)
+        // Every canvas gets its own range of this frame's upload ring, so one draw covers all of its instances.
+        UploadRange range{};
+        if (Upload(ctx, std::span(instances), range) != fawn_vision::gfx_status::ok) [[unlikely]]
         {
-            const std::uint32_t batchSize{static_cast<std::uint32_t>(std::min<std::size_t>(maxInstancesPerBatch, total - i))};
-
-            CopyData(ctx, pass->instanceBuffer, std::span(instances.data() + i, batchSize));
-
-            BindBuffer(ctx, pass->instanceBuffer);
-
-            Draw(ctx, static_cast<std::uint32_t>(quadIndices.size()), batchSize, 0U, 0U);
+            continue;
         }
+        BindBuffer(ctx, range);
+        Draw(ctx, static_cast<std::uint32_t>(quadIndices.size()), static_cast<std::uint32_t>(instances.size()), 0U, 0U);
     }
 }
 } // namespace detail
@@ -630,7 +627,8 @@ namespace detail
 // Public API
 // ---------------------------------------------------------------------------
 
-export [[nodiscard]] inline auto Initialize(const fawn_vision::Renderer& renderer, fawn_vision::RenderGraph& renderGraph, UIRenderer& ui) noexcept -> std::int32_t
+// Waits for the quad mesh to be uploaded, so call it between frames. Render binds the mesh every frame without checking.
+export [[nodiscard]] inline auto Initialize(fawn_vision::Renderer& renderer, fawn_vision::RenderGraph& renderGraph, UIRenderer& ui) noexcept -> std::int32_t
 {
     fawn_vision::RenderPassHandle pass{fawn_vision::AddRasterRenderPass<PassData>(renderGraph, ui.renderData)};
 
@@ -648,18 +646,11 @@ export [[nodiscard]] inline auto Initialize(const fawn_vision::Renderer& rendere
     {
         return -1;
     }
-
-    if (fawn_vision::Initialize(renderer, maxInstancesPerBatch * sizeof(UIInstanceData), fawn_vision::buffer_usage::vertex_buffer,
-                                fawn_vision::memory_property::host_visible | fawn_vision::memory_property::host_coherent, ui.renderData->instanceBuffer)
-        != fawn_vision::gfx_status::ok) [[unlikely]]
+    if (fawn_vision::WaitForUpload(renderer, ui.renderData->mesh.upload) != fawn_vision::gfx_status::ok) [[unlikely]]
     {
         return -1;
     }
 
-    //todo: find a better way to set syncMode and signalValue
-    renderGraph.passes[pass.index]->syncMode = fawn_vision::SYNC_WAIT_SIGNAL;
-    renderGraph.passes[pass.index]->signalValue = 1;
-
     fawn_vision::SetRenderFunc<PassData>(renderGraph, pass,
                                          [&ui](const PassData* pPass, const fawn_vision::RenderPassContext& ctx)
                                          {
@@ -673,7 +664,6 @@ export inline auto Cleanup(const fawn_vision::Renderer& renderer, UIRenderer& ui
 {
     if (ui.renderData)
     {
-        fawn_vision::Cleanup(renderer, ui.renderData->instanceBuffer);
         fawn_vision::Cleanup(renderer, ui.renderData->mesh);
         fawn_vision::Cleanup(renderer, ui.renderData->shader);
         ui.renderData = nullptr;
@@ -0,0 +1,128 @@
+//
+// Copyright (c) 2026.
+// Author: Joran.
+//
+
+module;
+
+export module FawnVision:WorkerPool;
+
+import std;
+
+namespace fawn_vision
+{
+// A fixed set of threads that run one batch of indexed jobs at a time.
+// The thread that calls Run takes part as worker 0, so a pool without threads runs everything inline.
+export struct WorkerPool
+{
+    using job_function = void (*)(void* pContext, std::uint32_t job, std::uint32_t worker) noexcept;
+
+    std::vector<std::jthread> threads{};
+    std::mutex mutex{};
+    std::condition_variable wake{};
+    std::condition_variable done{};
+    job_function pJob{nullptr};
+    void* pContext{nullptr};
+    std::uint32_t jobCount{};
+    std::atomic<std::uint32_t> nextJob{};
+    std::uint32_t busyThreads{};
+    std::uint64_t generation{};
+    bool isStopping{false};
+};
+
+// Worker indices run from 0 to WorkerCount - 1; anything kept per worker is sized with this.
+export [[nodiscard]] inline auto WorkerCount(const WorkerPool& pool) noexcept -> std::uint32_t
+{
+    return static_cast<std::uint32_t>(pool.threads.size()) + 1U;
+}
+
+inline auto DrainJobs(WorkerPool& pool, const std::uint32_t worker) noexcept -> void
+{
+    for (std::uint32_t job{pool.nextJob.fetch_add(1U, std::memory_order_relaxed)}; job < pool.jobCount; job = pool.nextJob.fetch_add(1U, std::memory_order_relaxed))
+    {
+        pool.pJob(pool.pContext, job, worker);
+    }
+}
+
+inline auto WorkerLoop(WorkerPool& pool, const std::uint32_t worker) noexcept -> void
+{
+    std::uint64_t seen{};
+    while (true)
+    {
+        {
+            std::unique_lock lock{pool.mutex};
+            pool.wake.wait(lock,
+                           [&pool, &seen]
+                           {
+                               return pool.isStopping || pool.generation != seen;
+                           });
+            if (pool.isStopping)
+            {
+                return;
+            }
+            seen = pool.generation;
+        }
+
+        DrainJobs(pool, worker);
+
+        std::lock_guard lock{pool.mutex};
+        if (--pool.busyThreads == 0U)
+        {
+            pool.done.notify_one();
+        }
+    }
+}
+
+export inline auto Initialize(WorkerPool& pool, const std::uint32_t threadCount) noexcept -> void
+{
+    pool.threads.reserve(threadCount);
+    for (std::uint32_t i{}; i < threadCount; ++i)
+    {
+        pool.threads.emplace_back(
+            [&pool, worker = i + 1U]
+            {
+                WorkerLoop(pool, worker);
+            });
+    }
+}
+
+export inline auto Cleanup(WorkerPool& pool) noexcept -> void
+{
+    {
+        std::lock_guard lock{pool.mutex};
+        pool.isStopping = true;
+    }
+    pool.wake.notify_all();
+    pool.threads.clear();
+    pool.isStopping = false;
+}
+
+// Calls job(index, worker) for every index in [0, jobCount) and returns once all of them are done.
+// Jobs are handed out one at a time, so a slow one never holds up the rest; two jobs with the same worker index never run at the same time.
+export template <class Job>
+auto Run(WorkerPool& pool, const std::uint32_t jobCount, Job& job) noexcept -> void
+{
+    pool.pJob = [](void* pContext, const std::uint32_t index, const std::uint32_t worker) noexcept
+    {
+        (*static_cast<Job*>(pContext))(index, worker);
+    };
+    pool.pContext = static_cast<void*>(std::addressof(job));
+    {
+        std::lock_guard lock{pool.mutex};
+        pool.jobCount = jobCount;
+        pool.nextJob.store(0U, std::memory_order_relaxed);
+        pool.busyThreads = static_cast<std::uint32_t>(pool.threads.size());
+        ++pool.generation;
+    }
+    pool.wake.notify_all();
+
+    DrainJobs(pool, 0U);
+
+    std::unique_lock lock{pool.mutex};
+    pool.done.wait(lock,
+                   [&pool]
+                   {
+                       return pool.busyThreads == 0U;
+                   });
+}
+} // namespace fawn_vision